@@ -21,12 +21,19 @@
  * Authors:
  *   Pierre Wieser <pwieser@trychlos.org>
  * 
- * Commands: see cmdHelp() function.
+ * Commands: see the cmdTable commands table.
  *
  * Note that command interpreter is very rough:
  * - commands are case sensitive
  * - multi words commands expect only one space between words and no extra chars
- * - commands are expected to be '\n' terminated
+ * - commands are expected to be '\n' terminated, a trailing '\r' being
+ *   ignored
+ * - commands are limited to NW_MAX_COMMAND characters; the longer ones
+ *   are rejected as a whole
+ * - several commands may be sent as a batch on a single line, separated
+ *   by ';' characters (see startBatch())
+ * - answers are terminated by a '.' line, or by a '..' line when the
+ *   command outputs several lines (see nwEndOfResponse)
  *
  * The typical PC program may look like:
  *   nw-daemon.pl -nohelp
@@ -52,545 +59,2420 @@
 static const char *strSpace3 = "   ";
 static const char *strSpace4 = "    ";
 
-/* the pin on which the LED is connected */
-#define LED_START        14                /* A0: i/o port for start led */
-#define LED_PING         15                /* A1: i/o port for ping led */
-#define LED_RESET        16                /* A2: i/o port for reset led */
-#define EXEC_RESET       17                /* A3: i/o port for reset relay */
+/* the pin on which the LED is connected (see nwProfile.h) */
+#define LED_START        NW_PROFILE_LED_START   /* i/o port for start led */
+#define LED_PING         NW_PROFILE_LED_PING    /* i/o port for ping led */
+#define LED_RESET        NW_PROFILE_LED_RESET   /* i/o port for reset led */
 #define EXEC_BLINK       300               /* maintain the relay closed */
-#define DEF_DELAY        60                /* default reset delay without ping */
+#define DEF_DELAY        60                /* default reset delay without ping (sec.) */
+#define MIN_DELAY_MS     10                /* min reset delay (ms) */
+#define MAX_DELAY_MS     65535000          /* max reset delay (ms), ~18h */
 #define DEF_TEST         true              /* whether we are in test mode */
+#define DEF_TEST_STR     "ON"              /* DEF_TEST as displayed by HELP */
+#define DEF_AUTOSTART    false             /* whether the saved config starts the channels */
+#define DEF_GRACE        60                /* default grace period of the autostart (sec.) */
+#define MAX_GRACE        3600              /* max grace period (sec.) */
+#define DEF_IDLE         true              /* whether loop() sleeps between the events */
+#define DEF_IDLE_STR     "ON"              /* DEF_IDLE as displayed by HELP */
+#define NW_MAX_COMMAND   NW_PROFILE_MAX_COMMAND /* max length of a command line, not counting the '\n' */
+#define BAUD_FALLBACK    10                /* delay (sec.) before falling back to NW_DEFAULT_BAUD */
+
+/* the communication protocols (see nwBinary.h) */
+enum {
+    NW_PROTOCOL_TEXT = 0,
+    NW_PROTOCOL_BINARY
+};
 
-unsigned int parmDelay = DEF_DELAY;        /* config: delay */
 bool parmTest = DEF_TEST;                  /* config: mode */
+bool parmAutostart = DEF_AUTOSTART;        /* config: whether the saved config starts the channels */
+unsigned int parmGrace = DEF_GRACE;        /* config: grace period of the autostart (sec.) */
+bool configSaved = false;                  /* whether a valid config is saved in the EEPROM */
 bool dateSet = false;                      /* whether the 'SET DATE <time>' command has been issued */
+bool multiLine = false;                    /* whether the current command outputs several lines */
+bool commandOverflow = false;              /* whether the last read command has been truncated */
+char answerLine[NW_MAX_COMMAND+1];         /* the command line whose answer is being sent */
+byte answerLength = 0;                     /* the length of this line */
+const char *streamCommand = NULL;          /* the command whose answer is being streamed */
+char *batchNext = NULL;                    /* the next command of the running batch, or NULL */
+bool heldPinged = false;                   /* whether the held PING has already pinged its channel */
+byte statusFields = 0;                     /* the STATUS_xxx fields of the streamed STATUS */
+int  dumpCount = 0;                        /* the count of reset events of the streamed EEPROM DUMP */
+int  queryFrom = 0;                        /* the first index listed by the streamed EEPROM READ */
+int  queryTo = -1;                         /* the last one */
+bool queryUnack = false;                   /* whether only the unacknowledged events are listed */
+long querySince = -1;                      /* the sequence number the listed events follow, or -1 */
+long queryLast = 0;                        /* the sequence number of the last listed event */
+byte protocol = NW_PROTOCOL_TEXT;          /* the current communication protocol */
+byte protocolNext = NW_PROTOCOL_TEXT;      /* the protocol to be used after the current answer */
+long baudRate = NW_DEFAULT_BAUD;           /* the current serial baud rate */
+long baudNext = NW_DEFAULT_BAUD;           /* the baud rate to be used after the current answer */
+bool baudConfirmed = true;                 /* whether a valid command has been received at this rate */
+unsigned long baudSince = 0;               /* millis() when the current baud rate has been set */
+
+/* the STATUS fields
+ * each field records the status sequence number of its last change, so
+ * that 'STATUS SINCE <seq>' only displays the fields which have changed
+ * since this sequence number; the time-dependent lines (e.g. 'Now is')
+ * are not state changes, and are only displayed with their field;
+ * the sequence numbers of the n-th startup of the board start at
+ * n*65536+1, so that 'STATUS SINCE' a sequence number of a previous
+ * startup displays all the fields, along with the new Boot number
+ */
+enum {
+    STATUS_DELAY = 0,
+    STATUS_TEST,
+    STATUS_DATE,
+    STATUS_STATE,
+    STATUS_EVENT,
+    STATUS_CONFIG,
+    STATUS_COUNT
+};
+#define STATUS_ALL       (( 1 << STATUS_COUNT )-1 )
+
+unsigned long statusSeq = 1;               /* the status sequence number, incremented on each change */
+uint16_t statusBoot = 0;                   /* the number of the startup the sequence numbers are about */
+unsigned long statusFieldSeq[STATUS_COUNT] = { 1, 1, 1, 1, 1, 1 };
 
 /* the start time
- * zero if the watchdog is stopped (doesn't count for pings and intervals)
- * is set to now() when the watchdog receives a 'START' command
+ * is set to now() when a first channel is started, and is only used for
+ * display; the deadlines themselves are maintained by nwChannel with
+ * rollover-safe millis() arithmetic, so that the wall-clock is only
+ * needed for the events timestamps
  */
 time_t startTime = 0;
 
-/* the last ping time
- * zero if the watchdog is stopped (doesn't count for pings and intervals)
- * is set to now() when the watchdog receives a 'PING' command
+/* the state kept across a reset of the board by its own watchdog timer
+ * (see nwWdt.h), so that the watching resumes where it was; it is saved
+ * on each status change, and each second for the current date
+ * the fields have fixed-width types, so that the state has the same
+ * size on the host bench as on the AVR
+ */
+struct wdtState {
+    byte          flags;                   /* WDT_STATE_xxx */
+    byte          started;                 /* bit n: channel n is started */
+    byte          targets;                 /* the bindings of the channels to the targets */
+    uint16_t      grace;
+    uint32_t      date;
+    int32_t       drift;                   /* the clock drift estimate (ppm) */
+    uint32_t      delay[NW_MAX_CHANNEL];
+};
+
+/* a bigger state would be silently not saved */
+static_assert( sizeof( wdtState ) <= NW_WDT_SAVE_SIZE,
+        "wdtState does not fit in the NW_WDT_SAVE_SIZE bytes saved across a watchdog reset" );
+
+#define WDT_STATE_TEST         ( 1 << 0 )
+#define WDT_STATE_DATE_SET     ( 1 << 1 )
+#define WDT_STATE_AUTOSTART    ( 1 << 2 )
+#define WDT_STATE_CONFIG_SAVED ( 1 << 3 )
+#define WDT_STATE_IDLE         ( 1 << 4 )
+#define WDT_STATE_DRIFT        ( 1 << 5 )
+
+time_t stateDate = 0;                      /* now() when the state has been last saved */
+
+/* the handlers of the commands table */
+bool cmdAcknowledge( const nwArg *arg );
+bool cmdAcknowledgeAll( const nwArg *arg );
+bool cmdAcknowledgeRange( const nwArg *arg );
+bool cmdClearConfig( const nwArg *arg );
+bool cmdEepromInit ( const nwArg *arg );
+bool cmdEepromDump ( const nwArg *arg );
+bool cmdEepromRead ( const nwArg *arg );
+bool cmdEepromReadSince( const nwArg *arg );
+bool cmdEepromReadUnack( const nwArg *arg );
+bool cmdEepromStats( const nwArg *arg );
+bool cmdHelp       ( const nwArg *arg );
+bool cmdNoop       ( const nwArg *arg );
+bool cmdPerf       ( const nwArg *arg );
+bool cmdPerfReset  ( const nwArg *arg );
+bool cmdPing       ( const nwArg *arg );
+bool cmdPingDate   ( const nwArg *arg );
+bool cmdReboot     ( const nwArg *arg );
+bool cmdReinit     ( const nwArg *arg );
+bool cmdSaveConfig ( const nwArg *arg );
+bool cmdSetAutostart( const nwArg *arg );
+bool cmdSetBaud    ( const nwArg *arg );
+bool cmdSetDate    ( const nwArg *arg );
+bool cmdSetDelay   ( const nwArg *arg );
+bool cmdSetEvents  ( const nwArg *arg );
+bool cmdSetGrace   ( const nwArg *arg );
+bool cmdSetIdle    ( const nwArg *arg );
+bool cmdSetProtocol( const nwArg *arg );
+bool cmdSetTarget  ( const nwArg *arg );
+bool cmdSetTest    ( const nwArg *arg );
+bool cmdStart      ( const nwArg *arg );
+bool cmdStatus     ( const nwArg *arg );
+bool cmdStatusSince( const nwArg *arg );
+bool cmdStop       ( const nwArg *arg );
+
+/* the other functions
+ * the Arduino IDE would generate these prototypes, but declaring them
+ * here lets the sketch also be built as plain C++ (see Arduino/bench)
  */
-time_t lastPing = 0;
+void        binEepromDump   ();
+bool        binPingIsValid  ( const nwFrame &frame );
+void        binEepromDumpEnd();
+bool        binEepromDumpStep( unsigned int index );
+void        binPerf         ( nwFrame &reply );
+void        binStatus       ( nwFrame &reply );
+byte        cmdChannel      ( const nwArg *arg );
+void        confirmBaudRate ();
+void        endBatch        ( bool ok );
+void        endCommand      ();
+bool        execAcknowledge ( long from, long to );
+void        execHeartbeat   ();
+bool        execPing        ( byte channel );
+void        execSyncDate    ( time_t date );
+bool        execReboot      ( long reason, byte channel );
+bool        execReset       ( int reason, byte target );
+void        execStart       ( byte channel, unsigned long grace=0 );
+void        execStop        ( byte channel );
+const char *getCommand      ();
+bool        loadConfig      ();
+bool        pingCommand     ( const char *command );
+bool        isAnswering     ();
+void        printCommandResult( bool ok, const char *command );
+void        printDelay      ( unsigned long delay );
+void        printEndOfAnswer( bool ok, const char *command );
+bool        printEepromDumpStep( unsigned int index );
+bool        printEventsStep ( unsigned int index );
+bool        printHelpStep   ( unsigned int index );
+void        printStatus     ( byte fields );
+void        printStatusState();
+bool        printStatusStep ( unsigned int index );
+void        readCommand     ();
+void        readFrame       ();
+void        readHeartbeats  ();
+bool        resumeState     ();
+void        runBatch        ();
+void        runCommand      ( const char *command );
+void        runFrame        ( nwFrame &frame );
+void        saveState       ();
+void        setBaudRate     ( long rate );
+void        startBatch      ( const char *command );
+void        statusChanged   ( byte field );
 
-/* reset time
- * zero while the reset has not been activated, whether the watchdog is started
- * or not
- * is set to now() when the reset is activated, i.e. when the last ping is older
- * than the required interval)
+/* the commands table
+ * - commands are grouped by first letter (see nwCommandSetup())
+ * - HELP displays them in this order
  */
-time_t resetTime = 0;
+#define NW_STR_( x )    #x
+#define NW_STR( x )     NW_STR_( x )
+
+static const PROGMEM char cmdAcknowledgeName[]  = "ACKNOWLEDGE";
+static const PROGMEM char cmdAcknowledgeArgs[]  = NW_HELP( "<index>" );
+static const PROGMEM char cmdAcknowledgeHelp[]  = NW_HELP( "acknowledge a stored reset event (index counted from most recent=0)" );
+static const PROGMEM char cmdAcknowledgeAllName[] = "ACKNOWLEDGE ALL";
+static const PROGMEM char cmdAcknowledgeAllHelp[] = NW_HELP( "acknowledge all the stored reset events" );
+static const PROGMEM char cmdAcknowledgeRangeArgs[] = NW_HELP( "<from>-<to>" );
+static const PROGMEM char cmdAcknowledgeRangeHelp[] = NW_HELP( "acknowledge the stored reset events from index <from> to index <to>" );
+static const PROGMEM char cmdClearConfigName[]  = "CLEAR CONFIG";
+static const PROGMEM char cmdClearConfigHelp[]  = NW_HELP( "remove the configuration saved in the EEPROM" );
+static const PROGMEM char cmdEepromInitName[]   = "EEPROM INIT";
+static const PROGMEM char cmdEepromInitHelp[]   = NW_HELP( "initialize the EEPROM (once, before NanoWatchdog first installation)" );
+static const PROGMEM char cmdEepromDumpName[]   = "EEPROM DUMP";
+static const PROGMEM char cmdEepromDumpHelp[]   = NW_HELP( "dump the EEPROM content" );
+static const PROGMEM char cmdEepromReadName[]   = "EEPROM READ";
+static const PROGMEM char cmdEepromReadArgs[]   = NW_HELP( "<from> <count>" );
+static const PROGMEM char cmdEepromReadHelp[]   = NW_HELP( "list <count> reset events from index <from>, one 'event=<index> seq= time= reason= ack= fwid= target=' line per event" );
+static const PROGMEM char cmdEepromReadSinceName[] = "EEPROM READ SINCE";
+static const PROGMEM char cmdEepromReadSinceArgs[] = NW_HELP( "<seq>" );
+static const PROGMEM char cmdEepromReadSinceHelp[] = NW_HELP( "list the identifier of the reset log, then, as EEPROM READ, its reset events of sequence number greater than <seq>" );
+static const PROGMEM char cmdEepromReadUnackName[] = "EEPROM READ UNACK";
+static const PROGMEM char cmdEepromReadUnackHelp[] = NW_HELP( "list the unacknowledged reset events, as EEPROM READ" );
+static const PROGMEM char cmdEepromStatsName[]  = "EEPROM STATS";
+static const PROGMEM char cmdEepromStatsHelp[]  = NW_HELP( "display the EEPROM write counters since startup" );
+static const PROGMEM char cmdHelpName[]         = "HELP";
+static const PROGMEM char cmdHelpHelp[]         = NW_HELP( "list available commands" );
+static const PROGMEM char cmdNoopName[]         = "NOOP";
+static const PROGMEM char cmdNoopHelp[]         = NW_HELP( "no-operation (used at NanoWatchdog startup)" );
+static const PROGMEM char cmdChannelArgs[]      = NW_HELP( "[<channel>]" );
+static const PROGMEM char cmdOnOffArgs[]        = NW_HELP( "ON|OFF" );
+static const PROGMEM char cmdPerfName[]         = "PERF";
+static const PROGMEM char cmdPerfHelp[]         = NW_HELP( "display the performance counters" );
+static const PROGMEM char cmdPerfResetName[]    = "PERF RESET";
+static const PROGMEM char cmdPerfResetHelp[]    = NW_HELP( "reset the performance counters" );
+static const PROGMEM char cmdPingName[]         = "PING";
+static const PROGMEM char cmdPingHelp[]         = NW_HELP( "ping the watchdog channel [0], reinitializing its timeout delay" );
+static const PROGMEM char cmdPingDateArgs[]     = NW_HELP( "[<channel>] <date>" );
+static const PROGMEM char cmdPingDateHelp[]     = NW_HELP( "ping the watchdog channel [0], and synchronize the current UTC date (EPOCH time) of the board" );
+static const PROGMEM char cmdRebootName[]       = "REBOOT";
+static const PROGMEM char cmdRebootArgs[]       = NW_HELP( "[<channel>] <reason>" );
+static const PROGMEM char cmdRebootHelp[]       = NW_HELP( "reset right now the target of the channel [0], i.e. the PC with a single target" );
+static const PROGMEM char cmdReinitName[]       = "REINIT";
+static const PROGMEM char cmdReinitHelp[]       = NW_HELP( "reinit watchdog after a reset (deprecated since 2015.2)" );
+static const PROGMEM char cmdSaveConfigName[]   = "SAVE CONFIG";
+static const PROGMEM char cmdSaveConfigHelp[]   = NW_HELP( "save the test mode, the delays, the targets, the autostart and the started channels into the EEPROM, to be restored at startup" );
+static const PROGMEM char cmdSetAutostartName[] = "SET AUTOSTART";
+static const PROGMEM char cmdSetAutostartHelp[] = NW_HELP( "whether the saved config starts the channels which were started, at startup [OFF]" );
+static const PROGMEM char cmdSetBaudName[]      = "SET BAUD";
+static const PROGMEM char cmdSetBaudArgs[]      = NW_HELP( "<rate>" );
+static const PROGMEM char cmdSetBaudHelp[]      = NW_HELP( "set serial baud rate (9600..250000) [" NW_STR( NW_DEFAULT_BAUD ) "]" );
+static const PROGMEM char cmdSetDateName[]      = "SET DATE";
+static const PROGMEM char cmdSetDateArgs[]      = NW_HELP( "<date>" );
+static const PROGMEM char cmdSetDateHelp[]      = NW_HELP( "set current UTC date as a count of seconds since 1970-01-01 (EPOCH time), needed for storing actual reset date and time" );
+static const PROGMEM char cmdSetDelayName[]     = "SET DELAY";
+static const PROGMEM char cmdSetDelayArgs[]     = NW_HELP( "[<channel>] <delay>" );
+static const PROGMEM char cmdSetDelayHelp[]     = NW_HELP( "set the no-ping timeout of the channel [0] before reset, in sec. or in ms with a 'ms' suffix (min=" NW_STR( MIN_DELAY_MS ) "ms, max=65535 (~18h)) [" NW_STR( DEF_DELAY ) " sec.]" );
+static const PROGMEM char cmdSetEventsName[]    = "SET EVENTS";
+static const PROGMEM char cmdSetEventsHelp[]    = NW_HELP( "send asynchronous '!' notifications on state transitions [OFF]" );
+static const PROGMEM char cmdSetGraceName[]     = "SET GRACE";
+static const PROGMEM char cmdSetGraceArgs[]     = NW_HELP( "<grace>" );
+static const PROGMEM char cmdSetGraceHelp[]     = NW_HELP( "set the grace period added to the first deadline of an autostarted channel, in sec. (max=" NW_STR( MAX_GRACE ) ") [" NW_STR( DEF_GRACE ) " sec.]" );
+static const PROGMEM char cmdSetIdleName[]      = "SET IDLE";
+static const PROGMEM char cmdSetIdleHelp[]      = NW_HELP( "sleep between the received bytes and the deadline checks (ON), or busy poll (OFF) [" DEF_IDLE_STR "]" );
+static const PROGMEM char cmdSetProtocolName[]  = "SET PROTOCOL BINARY";
+static const PROGMEM char cmdSetProtocolHelp[]  = NW_HELP( "switch to the binary protocol (see nwBinary.h)" );
+static const PROGMEM char cmdSetTargetName[]    = "SET TARGET";
+static const PROGMEM char cmdSetTargetArgs[]    = NW_HELP( "[<channel>] <target>" );
+static const PROGMEM char cmdSetTargetHelp[]    = NW_HELP( "bind the channel [0] to the reset relay of the target (0..N-1) [0]" );
+static const PROGMEM char cmdSetTestName[]      = "SET TEST";
+static const PROGMEM char cmdSetTestHelp[]      = NW_HELP( "set test mode [" DEF_TEST_STR "]" );
+static const PROGMEM char cmdStartName[]        = "START";
+static const PROGMEM char cmdStartHelp[]        = NW_HELP( "start the watchdog channel [0]" );
+static const PROGMEM char cmdStatusName[]       = "STATUS";
+static const PROGMEM char cmdStatusHelp[]       = NW_HELP( "display the current watchdog status" );
+static const PROGMEM char cmdStatusSinceName[]  = "STATUS SINCE";
+static const PROGMEM char cmdStatusSinceArgs[]  = NW_HELP( "<seq>" );
+static const PROGMEM char cmdStatusSinceHelp[]  = NW_HELP( "only display the status fields which have changed since the sequence number" );
+static const PROGMEM char cmdStopName[]         = "STOP";
+static const PROGMEM char cmdStopHelp[]         = NW_HELP( "stop the watchdog channel [all]" );
+
+static const PROGMEM nwCommand cmdTable[] = {
+    /* name               argument                     min                      max                   handler         syntax              help */
+    { cmdAcknowledgeName, NW_ARG_LONG,                 0,                       NW_MAX_RESET_EVENT-1, cmdAcknowledge, cmdAcknowledgeArgs, cmdAcknowledgeHelp },
+    { cmdAcknowledgeName, NW_ARG_RANGE,                0,                       NW_MAX_RESET_EVENT-1, cmdAcknowledgeRange, cmdAcknowledgeRangeArgs, cmdAcknowledgeRangeHelp },
+    { cmdAcknowledgeAllName, NW_ARG_NONE,              0,                       0,                    cmdAcknowledgeAll, NULL,            cmdAcknowledgeAllHelp },
+    { cmdClearConfigName, NW_ARG_NONE,                 0,                       0,                    cmdClearConfig, NULL,               cmdClearConfigHelp },
+    { cmdEepromInitName,  NW_ARG_NONE,                 0,                       0,                    cmdEepromInit,  NULL,               cmdEepromInitHelp },
+    { cmdEepromDumpName,  NW_ARG_NONE,                 0,                       0,                    cmdEepromDump,  NULL,               cmdEepromDumpHelp },
+    { cmdEepromReadName,  NW_ARG_PAIR,                 0,                       NW_MAX_RESET_EVENT,   cmdEepromRead,  cmdEepromReadArgs,  cmdEepromReadHelp },
+    { cmdEepromReadSinceName, NW_ARG_LONG,             0,                       0xFFFF,               cmdEepromReadSince, cmdEepromReadSinceArgs, cmdEepromReadSinceHelp },
+    { cmdEepromReadUnackName, NW_ARG_NONE,             0,                       0,                    cmdEepromReadUnack, NULL,           cmdEepromReadUnackHelp },
+    { cmdEepromStatsName, NW_ARG_NONE,                 0,                       0,                    cmdEepromStats, NULL,               cmdEepromStatsHelp },
+#if NW_PROFILE_HELP
+    { cmdHelpName,        NW_ARG_NONE,                 0,                       0,                    cmdHelp,        NULL,               cmdHelpHelp },
+#endif
+    { cmdNoopName,        NW_ARG_NONE,                 0,                       0,                    cmdNoop,        NULL,               cmdNoopHelp },
+    { cmdPerfName,        NW_ARG_NONE,                 0,                       0,                    cmdPerf,        NULL,               cmdPerfHelp },
+    { cmdPerfResetName,   NW_ARG_NONE,                 0,                       0,                    cmdPerfReset,   NULL,               cmdPerfResetHelp },
+    { cmdPingName,        NW_ARG_NONE|NW_ARG_CHANNEL,  0,                       0,                    cmdPing,        cmdChannelArgs,     cmdPingHelp },
+    { cmdPingName,        NW_ARG_LONG|NW_ARG_CHANNEL,  NW_CLOCK_MIN_DATE,       0x7FFFFFFF,           cmdPingDate,    cmdPingDateArgs,    cmdPingDateHelp },
+    { cmdRebootName,      NW_ARG_LONG|NW_ARG_CHANNEL,  NW_REASON_COMMAND_START, NW_REASON_MAX,        cmdReboot,      cmdRebootArgs,      cmdRebootHelp },
+#if NW_PROFILE_REINIT
+    { cmdReinitName,      NW_ARG_NONE,                 0,                       0,                    cmdReinit,      NULL,               cmdReinitHelp },
+#endif
+    { cmdSaveConfigName,  NW_ARG_NONE,                 0,                       0,                    cmdSaveConfig,  NULL,               cmdSaveConfigHelp },
+    { cmdSetAutostartName, NW_ARG_BOOL,                0,                       0,                    cmdSetAutostart, cmdOnOffArgs,      cmdSetAutostartHelp },
+    { cmdSetBaudName,     NW_ARG_LONG,                 9600,                    250000,               cmdSetBaud,     cmdSetBaudArgs,     cmdSetBaudHelp },
+    { cmdSetDateName,     NW_ARG_LONG,                 0,                       0x7FFFFFFF,           cmdSetDate,     cmdSetDateArgs,     cmdSetDateHelp },
+    { cmdSetDelayName,    NW_ARG_DELAY|NW_ARG_CHANNEL, MIN_DELAY_MS,            MAX_DELAY_MS,         cmdSetDelay,    cmdSetDelayArgs,    cmdSetDelayHelp },
+    { cmdSetEventsName,   NW_ARG_BOOL,                 0,                       0,                    cmdSetEvents,   cmdOnOffArgs,       cmdSetEventsHelp },
+    { cmdSetGraceName,    NW_ARG_LONG,                 0,                       MAX_GRACE,            cmdSetGrace,    cmdSetGraceArgs,    cmdSetGraceHelp },
+    { cmdSetIdleName,     NW_ARG_BOOL,                 0,                       0,                    cmdSetIdle,     cmdOnOffArgs,       cmdSetIdleHelp },
+    { cmdSetProtocolName, NW_ARG_NONE,                 0,                       0,                    cmdSetProtocol, NULL,               cmdSetProtocolHelp },
+    { cmdSetTargetName,   NW_ARG_LONG|NW_ARG_CHANNEL,  0,                       NW_MAX_TARGET-1,      cmdSetTarget,   cmdSetTargetArgs,   cmdSetTargetHelp },
+    { cmdSetTestName,     NW_ARG_BOOL,                 0,                       0,                    cmdSetTest,     cmdOnOffArgs,       cmdSetTestHelp },
+    { cmdStartName,       NW_ARG_NONE|NW_ARG_CHANNEL,  0,                       0,                    cmdStart,       cmdChannelArgs,     cmdStartHelp },
+    { cmdStatusName,      NW_ARG_NONE,                 0,                       0,                    cmdStatus,      NULL,               cmdStatusHelp },
+    { cmdStatusSinceName, NW_ARG_LONG,                 0,                       0x7FFFFFFF,           cmdStatusSince, cmdStatusSinceArgs, cmdStatusSinceHelp },
+    { cmdStopName,        NW_ARG_NONE|NW_ARG_CHANNEL,  0,                       0,                    cmdStop,        cmdChannelArgs,     cmdStopHelp },
+};
 
 void setup() {
-    Serial.begin( 19200 );
+    nwPerfSetup();
+    nwEEPROMSetup();
+    statusBoot = nwEEPROMBootNew();
+    statusSeq = (( unsigned long ) statusBoot << 16 )+1;
+    for( byte i=0 ; i<STATUS_COUNT ; ++i ){
+        statusFieldSeq[i] = statusSeq;
+    }
+    nwCommandSetup( cmdTable, sizeof( cmdTable )/sizeof( cmdTable[0] ));
+    nwChannelSetup( DEF_DELAY*1000UL );
+    nwTargetSetup();
+    nwIdleEnable( DEF_IDLE );
+    baudNext = nwEEPROMBaudRateGet();
+    setBaudRate( baudNext );
     pinMode( LED_START, OUTPUT );
     pinMode( LED_PING,  OUTPUT );
     pinMode( LED_RESET, OUTPUT );
-    pinMode( EXEC_RESET, OUTPUT );
+
+    /* the board has been reset by its own watchdog timer: resume the
+     * watching where it was, and record the event; else restore the
+     * saved configuration
+     */
+    bool resumed = nwWdtHasFired() && resumeState();
+    if( !resumed ){
+        loadConfig();
+    }
+    if( nwWdtHasFired()){
+        nwEvent ev( NW_REASON_MCU_WDT );
+        nwEEPROMResetEventSetNew( ev );
+        statusChanged( STATUS_EVENT );
+    }
+    saveState();
+    nwWdtSetup();
 }
 
 void loop() {
+    nwPerfLoopBegin();
+    nwWdtKick();
+
+    /* first execute the LED and relay transitions which are due
+     */
+    nwSchedulerRun();
+    nwClockRun();
+
     /* is there a command to be executed ?
+     * then emit the next records of the answer being streamed, if any
      */
-    String command = getCommand();
-    if( command.length() > 0 ){
-        bool ok = false;
-        if( command.startsWith( "ACKNOWLEDGE " )){
-            ok = cmdAcknowledge( command );
-        } else if( command.startsWith( "EEPROM " )){
-            ok = cmdEeprom( command );
-        } else if( command.equals( "HELP" )){
-            ok = cmdHelp();
-        } else if( command.equals( "NOOP" )){
-            ok = true;
-        } else if( command.equals( "PING" )){
-            ok = cmdPing();
-        } else if( command.startsWith( "REBOOT " )){
-            ok = cmdReboot( command );
-        } else if( command.equals( "REINIT" )){
-            ok = cmdReinit();
-        } else if( command.startsWith( "SET " )){
-            ok = cmdSet( command );
-        } else if( command.equals( "START" )){
-            ok = cmdStart();
-        } else if( command.equals( "STATUS" )){
-            ok = cmdStatus();
-        } else if( command.equals( "STOP" )){
-            ok = cmdStop();
-        }
-        if( ok ){
-            Serial.print( F( "OK: " ));
-        } else {
-            Serial.print( F( "Unknown or invalid command: " ));
+    nwIdleParse();
+    if( protocol == NW_PROTOCOL_BINARY ){
+        readFrame();
+    } else {
+        readCommand();
+    }
+    nwOutputRun();
+    if( batchNext && !nwOutputIsBusy()){
+        runBatch();
+    }
+    if( !isAnswering()){
+        protocol = protocolNext;
+        if( baudNext != baudRate ){
+            setBaudRate( baudNext );
         }
-        Serial.println( command.c_str());
-        Serial.flush();
     }
-  
+
+    /* fall back to the default baud rate if nobody talks to us at the
+     * current one
+     */
+    if( !baudConfirmed && millis() - baudSince > BAUD_FALLBACK*1000UL ){
+        baudNext = NW_DEFAULT_BAUD;
+        setBaudRate( baudNext );
+        baudConfirmed = true;
+    }
+
     /* a command may have been executed
      * see about the watchdog itself
-     * if it has been started, and last ping is older than the delay
+     * if a channel has been started, and its last ping is older than its
+     * delay (or than a stage of it)
+     */
+    byte channel, percent;
+    while(( channel = nwChannelRun( &percent )) != NW_CHANNEL_NONE ){
+        if( percent < 100 ){
+            nwNotifyPush( NW_NOTIFY_DEADLINE, channel, percent );
+        } else {
+            execReset( channel == 0 ? NW_REASON_NOPING : NW_REASON_NOPING_CHANNEL+channel, nwTargetOf( channel ));
+        }
+    }
+
+    /* last send the notifications, the answer being complete
+     */
+    if( !isAnswering()){
+        nwNotifySend( protocol == NW_PROTOCOL_BINARY );
+    }
+
+    /* keep the saved date current, should the watchdog timer fire
      */
-    if( startTime > 0 && now() > lastPing + parmDelay ){
-        execReset( NW_REASON_NOPING );
+    if( now() != stateDate ){
+        saveState();
     }
+
+    nwPerfLoopEnd();
+
+    /* last sleep until the next received byte or timer tick
+     */
+    nwIdleSleep();
 }
 
 /**
- * getCommand:
- *
- * Read a command from serial input until next newline '\n'
- * - we do not want block when reading the serial input
- *   so we increment the static variable when there is something to read
- * - and only return it when complete
+ * setBaudRate:
+ * @rate: the new baud rate.
  *
- * Returns: the command as a new String, or empty if there is no new
- *  command.
+ * (Re)start the serial line at the given rate.
+ * Unless this is the default rate, the rate has yet to be confirmed by a
+ * valid command before BAUD_FALLBACK seconds.
  */
-String getCommand() 
+void setBaudRate( long rate )
 {
-    static String cmd = "";
-    static bool is_complete = false;
-  
-    if( is_complete ){                            // reinit the input string
-        is_complete = false;
-        cmd = "";
+    static bool started = false;
+
+    if( started ){
+        Serial.flush();
+        Serial.end();
     }
-    while( Serial.available() > 0 ){
-        char inChar = Serial.read();  
-        if( inChar == '\n' ){
-            is_complete = true;
-            return( cmd );
+    Serial.begin( rate );
+    started = true;
+    baudRate = rate;
+    baudConfirmed = ( rate == NW_DEFAULT_BAUD );
+    baudSince = millis();
+}
+
+/**
+ * confirmBaudRate:
+ *
+ * A valid command has been received: the current baud rate is fine,
+ * and becomes the one used at next startup.
+ */
+void confirmBaudRate()
+{
+    if( !baudConfirmed ){
+        baudConfirmed = true;
+        if( nwEEPROMBaudRateGet() != baudRate ){
+            nwEEPROMBaudRateSet( baudRate );
         }
-        cmd = cmd + inChar;
     }
-    return( "" );
 }
 
 /**
- * cmdAcknowledge:
- * @command: the command to be executed.
+ * readCommand:
  *
- * Acknowledge a stored reset event, whose index is specified from zero
- * where zero is the index of the most recent reset event.
- *
- * syntaxe: ACKNOWLEDGE <index>
+ * Read and execute the next text command.
  *
- * Returns: true if the command has been successfully executed, false else.
+ * While an answer is being sent, the command is held until the end of
+ * this answer, so that the answers are not intermixed, the following
+ * ones being left in the RX buffer; a held PING is yet executed at once,
+ * and only answered in its turn, without pinging again (see heldPinged),
+ * the date of a 'PING <date>' being only synchronized then. The
+ * heartbeats are always executed as soon as they are received.
+ * The held command stays in the buffer of getCommand(), which is not
+ * called again before the command is run.
  */
-bool cmdAcknowledge( String command )
+void readCommand()
 {
-    if( command.length() > 12 ){
-        String rest = command.substring( 12 );
-        int index = ( int ) rest.toInt();
-        if( index >= 0 && index < NW_MAX_RESET_EVENT ){
-            nwEvent ev = nwEEPROMResetEventGet( index );
-            ev.acknowledge();
-            nwEEPROMResetEventSet( ev, index );
-            return( true );
+    static const char *held = NULL;
+
+    if( !held ){
+        held = getCommand();
+        if( !held ){
+            return;
         }
+        heldPinged = isAnswering() && pingCommand( held );
+    }
+    if( isAnswering()){
+        readHeartbeats();
+    } else {
+        const char *command = held;
+        held = NULL;
+        runCommand( command );
+        heldPinged = false;
     }
-    return( false );
 }
 
 /**
- * cmdEeprom:
- * @command: the command to be executed.
- *
- * EEPROM management:
- * - INIT : initialize the EEPROM content to zero
- * - READ: display the EEPROM content
+ * isAnswering:
  *
- * The content of the EEPROM is read with the STATUS command.
+ * Returns: whether an answer is being streamed, or a batch is running.
  */
-bool cmdEeprom( String command )
+bool isAnswering()
 {
-    bool ok = false;
-  
-    if( command.startsWith( "INIT", 7 ) && command.length() == 11 ){
-        ok = cmdEepromInit( command );
-    } else if( command.startsWith( "DUMP", 7 ) && command.length() == 11 ){
-        ok = cmdEepromDump( command );
-    }
-    return( ok );
+    return( nwOutputIsBusy() || batchNext != NULL );
 }
 
 /**
- * cmdEepromInit:
- * @command: the command to be executed.
+ * pingCommand:
+ * @command: the text command.
  *
- * EEPROM management:
- * - INIT : initialize the EEPROM content to zero
+ * Ping the channel if the command is a valid PING.
  *
- * The 'SET DATE <time>' command should have been issued before initializing
- * the EEPROM in order to have a valid date.
+ * Returns: whether the channel has been pinged.
  */
-bool cmdEepromInit( String command )
+bool pingCommand( const char *command )
 {
-    /* first, init the EEPROM to zero */
-    for( int i=0 ; i<EEPROM_SIZE ; ++i ){
-        EEPROM[i] = '\0';
+    size_t len = strlen_P( cmdPingName );
+    long channel = 0;
+
+    if( !commandOverflow && nwStrStartsWith( command, cmdPingName ) &&
+            ( command[len] == '\0' || ( command[len] == ' ' && nwStrToLong( command+len+1, &channel ))) &&
+            channel >= 0 && channel < NW_MAX_CHANNEL ){
+        execPing( channel );
+        return( true );
     }
-    /* write the initialization event */
-    nwEvent ev( NW_REASON_INIT );
-    ev.acknowledge();
-    nwEEPROMInitEventSet( ev );
-    /* last blink the START LED and returns */
-    nwBlinkPin( LED_START );
-    return( true );
+    return( false );
 }
 
 /**
- * cmdEepromDump:
- * @command: the command to be executed.
+ * readFrame:
  *
- * EEPROM management:
- * - DUMP: display the EEPROM content
- *
- * Read and display the EEPROM content.
+ * Read and execute the next binary request frame, holding it while an
+ * answer is being streamed, as readCommand() does.
  */
-bool cmdEepromDump( String command )
+void readFrame()
 {
-    nwSerialPrintVersion();
-    Serial.println( F( "EEPROM dump:" ));
-    /* read initialization event */
-    nwEvent ev = nwEEPROMInitEventGet();
-    Serial.println( F( " Initialization event:" ));
-    ev.display( strSpace3 );
+    static nwFrame held;
+    static bool isHeld = false;
 
-    /* read reset traces count */
-    int count = nwEEPROMResetEventCountGet();
-    Serial.println( F( " Reset events count:" ));
-    Serial.print( strSpace3 );
-    Serial.print( F( "count=" ));
-    Serial.println( count );
-
-    for( int i=0 ; i<count ; ++i ){
-        ev = nwEEPROMResetEventGet( i );
-        Serial.print( F( " Reset event #" ));
-        Serial.println( i );
-        ev.display( strSpace3 );
+    if( !isHeld ){
+        if( !nwBinaryRead( held )){
+            return;
+        }
+        isHeld = true;
+        if( nwOutputIsBusy() && held.opcode == NW_BIN_OP_PING && binPingIsValid( held )){
+            execPing( held.length ? held.payload[0] : 0 );
+            heldPinged = true;
+        }
+    }
+    if( nwOutputIsBusy() && held.opcode != NW_BIN_OP_HEARTBEAT ){
+        readHeartbeats();
+    } else {
+        isHeld = false;
+        runFrame( held );
+        heldPinged = false;
     }
-    return( true );
 }
 
 /**
- * cmdHelp:
- *
- * Display the available commands.
+ * readHeartbeats:
  *
- * Returns: true.
+ * Execute the NW_HEARTBEAT bytes which wait in the RX buffer before the
+ * next command or frame.
  */
-bool cmdHelp()
+void readHeartbeats()
 {
-    nwSerialPrintVersion();
-    Serial.println( F( "Available commands:" ));
-    Serial.println( F( " ACKNOWLEDGE <index>  acknowledge a stored reset event (index counted from most recent=0)" ));
-    Serial.println( F( " EEPROM INIT          initialize the EEPROM (once, before NanoWatchdog first installation)" ));
-    Serial.println( F( " EEPROM DUMP          dump the EEPROM content" ));
-    Serial.println( F( " HELP                 list available commands" ));
-    Serial.println( F( " NOOP                 no-operation (used at NanoWatchdog startup)" ));
-    Serial.println( F( " PING                 ping the watchdog, reinitializing the timeout delay" ));
-    Serial.println( F( " REBOOT <reason>      reset the PC right now" ));
-    Serial.println( F( " REINIT               reinit watchdog after a reset (deprecated since 2015.2)" ));
-    Serial.println( F( " SET DATE <date>      set current UTC date as a count of seconds since 1970-01-01 (EPOCH time)" ));
-    Serial.println( F( "                      (needed for storing actual reset date and time)" ));
-    Serial.print  ( F( " SET DELAY <delay>    set no-ping timeout before reset (min=1, max=65535 (~18h)) [" ));
-    Serial.print( DEF_DELAY );
-    Serial.println( F( " sec.]" ));
-    Serial.print  ( F( " SET TEST ON|OFF      set test mode [" ));
-    Serial.print( DEF_TEST ? "ON" : "OFF" );
-    Serial.println( "]" );
-    Serial.println( F( " START                start the watchdog" ));
-    Serial.println( F( " STATUS               display the current watchdog status" ));
-    Serial.println( F( " STOP                 stop the watchdog" ));
-    return( true );
+    while( Serial.peek() == NW_HEARTBEAT ){
+        Serial.read();
+        execHeartbeat();
+    }
 }
 
 /**
- * cmdPing:
- *
- * Ping the watchdog, inhibiting the reset for the next interval
- * doesn't ping if the reset has been activated
- * no input args
+ * runCommand:
+ * @command: the text command to be executed.
  *
- * Returns: true.
+ * Execute the command, and terminate the answer, unless it is streamed
+ * (see endCommand()) or it is a batch (see startBatch()).
  */
-bool cmdPing()
+void runCommand( const char *command )
 {
-    if( startTime > 0 && resetTime == 0 ){
-        lastPing = now();
-        nwBlinkPin( LED_PING );
-      }
-    return( true );
+    bool ok = false;
+    multiLine = false;
+    if( !commandOverflow && strchr( command, ';' )){
+        startBatch( command );
+        return;
+    }
+    if( commandOverflow ){
+        ok = false;
+    } else {
+        ok = nwCommandRun( command );
+    }
+    if( ok ){
+        confirmBaudRate();
+    } else {
+        nwPerfRejected();
+    }
+    if( nwOutputIsBusy()){
+        strcpy( answerLine, command );
+        streamCommand = answerLine;
+        return;
+    }
+    printEndOfAnswer( ok, command );
+    Serial.flush();
 }
 
 /**
- * cmdReboot:
- *
- * Reboot the PC right now.
+ * startBatch:
+ * @command: the ';'-separated commands.
  *
- * syntax: REBOOT <reason>
+ * Check, then execute a batch of commands, e.g.
+ * 'SET DATE 1508083200;SET DELAY 60;START'.
  *
- * Returns: true/false whether the command has been accepted.
+ * The batch is rejected as a whole, without executing any of its
+ * commands, if one of them is unknown or invalid: each of these gets
+ * its 'Unknown or invalid command:' line.
+ * Else the commands are executed in sequence, each answer being
+ * terminated by its own 'OK:' line, and no other command is executed
+ * before the end of the batch (see runBatch()).
+ * The whole answer is terminated by the 'OK:' (resp. 'Unknown or
+ * invalid command:') line of the batch, and by the multi-lines marker.
  */
-bool cmdReboot( String command )
+void startBatch( const char *command )
 {
-    if( command.length() > 7 ){
-        String rest = command.substring( 7 );
-        int reason = ( int ) rest.toInt();
-        if( reason >= NW_REASON_COMMAND_START && reason <= NW_REASON_MAX ){
-            execReset( reason );
-            return( true );
+    bool ok = true;
+
+    answerLength = strlen( command );
+    memcpy( answerLine, command, answerLength+1 );
+    for( byte i=0 ; i<answerLength ; ++i ){
+        if( answerLine[i] == ';' ){
+            answerLine[i] = '\0';
         }
     }
-    return( false );
+    for( char *part=answerLine ; part<=answerLine+answerLength ; part+=strlen( part )+1 ){
+        if( !nwCommandIsValid( part )){
+            printCommandResult( false, part );
+            ok = false;
+        }
+    }
+    multiLine = true;
+    if( !ok ){
+        nwPerfRejected();
+        endBatch( false );
+        return;
+    }
+    confirmBaudRate();
+    batchNext = answerLine;
+    runBatch();
 }
 
 /**
- * cmdReinit:
- *
- * Reinit the watchdog.
- * This is only useful when in development mode
+ * runBatch:
  *
- * Returns: true.
+ * Execute the next commands of the batch, until one of them streams its
+ * answer, or fails, or the batch is complete.
+ * A failing command, though its syntax has been checked, ends the batch,
+ * the next commands being left unexecuted.
  */
-bool cmdReinit()
+void runBatch()
 {
-    resetTime = 0;
-    digitalWrite( LED_START, LOW );
-    digitalWrite( LED_RESET, LOW );
-    startTime = 0;
-    return( true );
+    while( !nwOutputIsBusy()){
+        if( batchNext > answerLine+answerLength ){
+            endBatch( true );
+            return;
+        }
+        char *part = batchNext;
+        batchNext += strlen( part )+1;
+        if( !nwCommandRun( part )){
+            nwPerfRejected();
+            printCommandResult( false, part );
+            endBatch( false );
+            return;
+        }
+        if( nwOutputIsBusy()){
+            streamCommand = part;
+        } else {
+            printCommandResult( true, part );
+        }
+    }
 }
 
 /**
- * cmdSet:
- * @command: the command to be executed.
+ * endBatch:
+ * @ok: whether all the commands of the batch have been executed.
  *
- * Set a configuration parameter
- * syntaxe: SET <parm> <value>
- * were parm is:
- * - DATE <date>
- *   the epoch time as a time_t
- *   default = 0
- * - DELAY <delay>
- *   the delay is seconds since the last ping at which the reset is launched
- *   value = 1..32767
- *   default = 60
- * - TEST ON|OFF
- *   whether a reset is really launched, or is just flagged as during tests
- *   value = ON (false, not a test) or OFF (true, is a test)
- *   default = ON
+ * Terminate the answer of the batch.
+ */
+void endBatch( bool ok )
+{
+    for( byte i=0 ; i<answerLength ; ++i ){
+        if( answerLine[i] == '\0' ){
+            answerLine[i] = ';';
+        }
+    }
+    batchNext = NULL;
+    printEndOfAnswer( ok, answerLine );
+}
+
+/**
+ * endCommand:
  *
- * Returns: true if the command has been successfully executed, false else.
+ * Terminate a streamed answer, or only the answer of the command when
+ * it is part of a batch.
+ * Contrarily to the other answers, it is not flushed: loop() would else
+ * block until the last bytes are sent.
  */
-bool cmdSet( String command )
+void endCommand()
 {
-    bool ok = false;
-  
-    if( command.startsWith( "DATE ", 4 )){
-        ok = cmdSetDate( command );
-    } else if( command.startsWith( "DELAY ", 4 )){
-        ok = cmdSetDelay( command );
-    } else if( command.startsWith( "TEST ", 4 )){
-        ok = cmdSetTest( command );
+    if( batchNext ){
+        printCommandResult( true, streamCommand );
+    } else {
+        printEndOfAnswer( true, streamCommand );
     }
-    return( ok );
 }
 
 /**
- * cmdSetDate:
- * @command: the command to be executed.
+ * printCommandResult:
+ * @ok: whether the command has been successfully executed.
+ * @command: the text command.
  *
- * Set the current date
- * syntaxe: SET DATE <value>
- *   where value is an epoch time (count of seconds since 1970-01-01)
- * This is needed in order to be able actual reset time in EEPROM traces.
+ * Send the 'OK:' (resp. 'Unknown or invalid command:') line.
+ */
+void printCommandResult( bool ok, const char *command )
+{
+    Serial.print( ok ? F( "OK: " ) : F( "Unknown or invalid command: " ));
+    Serial.println( command );
+}
+
+/**
+ * printEndOfAnswer:
+ * @ok: whether the command has been successfully executed.
+ * @command: the text command.
  *
- * Returns: true if the command has been successfully executed, false else.
+ * Send the last lines of the answer.
  */
-bool cmdSetDate( String command )
+void printEndOfAnswer( bool ok, const char *command )
 {
-    if( command.length() > 9 ){
-        String rest = command.substring( 9 );
-        time_t epoch = rest.toInt();
-        setTime( epoch );
-        dateSet = true;
-        return( true );
+    printCommandResult( ok, command );
+    Serial.println( FS( multiLine ? nwEndOfMultiline : nwEndOfResponse ));
+}
+
+/**
+ * runFrame:
+ * @frame: the binary request frame to be executed.
+ *
+ * Execute the request, and send the reply frame, unless the answer is
+ * streamed (see binEepromDump()).
+ */
+void runFrame( nwFrame &frame )
+{
+    nwFrame reply;
+    byte status = NW_BIN_STATUS_OK;
+
+    reply.opcode = frame.opcode | NW_BIN_OP_REPLY;
+    reply.length = 1;                     /* status is set last */
+
+    if( frame.opcode == NW_BIN_OP_ERROR ){
+        nwPerfBadFrame();
+    } else if( frame.opcode != NW_BIN_OP_HEARTBEAT ){
+        nwPerfFrame( frame.opcode );
     }
-    return( false );
+
+    switch( frame.opcode ){
+        case NW_BIN_OP_HEARTBEAT:
+            execHeartbeat();
+            return;
+        case NW_BIN_OP_PING:
+            if( !binPingIsValid( frame )){
+                status = NW_BIN_STATUS_INVALID;
+            } else {
+                if( !heldPinged ){
+                    execPing( frame.length ? frame.payload[0] : 0 );
+                }
+                if( frame.length == 5 ){
+                    execSyncDate( nwBinaryGet( frame, 1, 4 ));
+                }
+            }
+            break;
+        case NW_BIN_OP_STATUS:
+            binStatus( reply );
+            break;
+        case NW_BIN_OP_REBOOT:
+            if(( frame.length != 1 && frame.length != 2 ) ||
+                    ( frame.length == 2 && frame.payload[1] >= NW_MAX_CHANNEL ) ||
+                    !execReboot( frame.payload[0], frame.length == 2 ? frame.payload[1] : 0 )){
+                status = NW_BIN_STATUS_INVALID;
+            }
+            break;
+        case NW_BIN_OP_ACKNOWLEDGE:
+            if( frame.length != 1 || !execAcknowledge( frame.payload[0], frame.payload[0] )){
+                status = NW_BIN_STATUS_INVALID;
+            }
+            break;
+        case NW_BIN_OP_EEPROM_DUMP:
+            binEepromDump();
+            break;
+        case NW_BIN_OP_NOOP:
+            break;
+        case NW_BIN_OP_PERF:
+            if( frame.length > 1 ){
+                status = NW_BIN_STATUS_INVALID;
+            } else {
+                binPerf( reply );
+                if( frame.length && frame.payload[0] ){
+                    nwPerfReset();
+                }
+            }
+            break;
+        case NW_BIN_OP_TEXT:
+            protocolNext = NW_PROTOCOL_TEXT;
+            break;
+        case NW_BIN_OP_ERROR:
+            reply.opcode = NW_BIN_OP_ERROR;
+            nwBinaryPut( reply, frame.payload[0], 1 );
+            status = NW_BIN_STATUS_CRC;
+            break;
+        default:
+            reply.opcode = NW_BIN_OP_ERROR;
+            nwBinaryPut( reply, frame.opcode, 1 );
+            status = NW_BIN_STATUS_INVALID;
+            break;
+    }
+    if( status == NW_BIN_STATUS_OK ){
+        confirmBaudRate();
+    }
+    if( nwOutputIsBusy()){
+        return;
+    }
+    reply.payload[0] = status;
+    nwBinaryWrite( reply );
 }
 
 /**
- * cmdSetDelay:
- * @command: the command to be executed.
+ * getCommand:
  *
- * Set the reboot delay parameter
- * syntaxe: SET DELAY <value>
- *   the delay is seconds since the last ping at which the reset is launched
- *   value = 1..65535
- *   default = 60
+ * Read a command from serial input until next newline '\n'
+ * - we do not want block when reading the serial input
+ *   so we append to the static buffer when there is something to read
+ * - and only return it when complete.
  *
- * Returns: true if the command has been successfully executed, false else.
+ * The buffer has a fixed size: the characters which do not fit in are
+ * dropped until the next newline, and the (truncated) command is then
+ * returned with the commandOverflow flag set, so that it is rejected.
+ *
+ * A NW_HEARTBEAT byte is not part of the command: it is executed as
+ * soon as it is received.
+ *
+ * Returns: the null-terminated command, or NULL if there is no new
+ *  (non-empty) command. The returned string is only valid until next
+ *  call.
  */
-bool cmdSetDelay( String command )
+const char *getCommand()
 {
-    if( command.length() > 10 ){
-        String rest = command.substring( 10 );
-        long long_delay = rest.toInt();
-        if( long_delay >= 1 && long_delay <= 65535 ){
-            parmDelay = int( long_delay );
-            return( true );
+    static char cmd[NW_MAX_COMMAND+1];
+    static byte length = 0;
+    static bool overflow = false;
+
+    while( Serial.available() > 0 ){
+        char inChar = Serial.read();
+        if( inChar == '\n' ){
+            cmd[length] = '\0';
+            commandOverflow = overflow;
+            overflow = false;
+            if( length > 0 ){
+                length = 0;
+                return( cmd );
+            }
+        } else if( inChar == NW_HEARTBEAT ){
+            execHeartbeat();
+        } else if( inChar == '\r' ){
+            /* ignore */
+        } else if( length < NW_MAX_COMMAND ){
+            cmd[length++] = inChar;
+        } else {
+            overflow = true;
+            nwPerfRxDropped();
         }
     }
-    return( false );
+    return( NULL );
 }
 
 /**
- * cmdSetTest:
- * @command: the command to be executed.
+ * cmdAcknowledge:
+ * @arg: the index of the reset event.
  *
- * Set the test parameter
- * syntaxe: SET TEST <value>
- *   whether a reset is really launched, or is just flagged during tests
- *   value = 0 (false, not a test) or 1 (true, is a test)
- *   default = 1
+ * Acknowledge a stored reset event, whose index is specified from zero
+ * where zero is the index of the most recent reset event.
+ *
+ * syntaxe: ACKNOWLEDGE <index>
  *
  * Returns: true if the command has been successfully executed, false else.
  */
-bool cmdSetTest( String command )
+bool cmdAcknowledge( const nwArg *arg )
 {
-    if( command.length() > 9 ){
-        String rest = command.substring( 9 );
-        if( rest.equals( "ON" )){
-            parmTest = true;
-          return( true );
-        }
-        if( rest.equals( "OFF" )){
-            parmTest = false;
-            return( true );
-        }
-    }
-    return( false );
+    return( execAcknowledge( arg->l, arg->l ));
 }
 
 /**
- * cmdStart:
+ * cmdAcknowledgeAll:
+ * @arg: unused.
  *
- * Start the watchdog
- * idempotent if already started
- * no input args
+ * Acknowledge all the stored reset events in one pass.
+ *
+ * syntaxe: ACKNOWLEDGE ALL
  *
  * Returns: true.
  */
-bool cmdStart()
+bool cmdAcknowledgeAll( const nwArg *arg )
 {
-    if( startTime == 0 ){
-        startTime = now();
-        lastPing = startTime;
-        digitalWrite( LED_START, HIGH );
-    }
-    return( true );
+    int count = nwEEPROMResetEventCountGet();
+    return( count == 0 || execAcknowledge( 0, count-1 ));
 }
 
 /**
- * cmdStatus:
+ * cmdAcknowledgeRange:
+ * @arg: the indexes of the first and last reset events.
  *
- * Display the current status of the watchdog
- * no input args
- * display:
- * - up date and time
- * - start date and time, or zero if not started
- * - current interval
- * - current test
- * - last ping date and time (may be zero)
- * - date and time of reboot, or zero if not started
- * - last reset time
+ * Acknowledge the stored reset events of the range in one pass, the
+ * indexes being counted as for ACKNOWLEDGE.
  *
- * Returns: true:
+ * syntaxe: ACKNOWLEDGE <from>-<to>
+ *
+ * Returns: true if the command has been successfully executed, false else.
  */
-bool cmdStatus()
+bool cmdAcknowledgeRange( const nwArg *arg )
 {
-    nwSerialPrintVersion();
-    Serial.println( F( "Current status:" ));
-    Serial.print  ( F( " Reset delay:    " ));               /* reset delay */
-    Serial.print  ( parmDelay );
-    Serial.println( F( " sec." ));
-    Serial.print  ( F( " Test mode:      " ));               /* test mode */
-    Serial.println( parmTest ? F( "ON (test mode)" ) : F( "OFF (reset mode)" ));
-    Serial.print  ( F( " Date set:       " ));               /* whether the date has been set */
-    Serial.println( dateSet ? F( "yes" ) : F( "no" ));
-    Serial.print  ( F( " Status:         " ));               /* current status */
-    if( resetTime > 0 ){
-        Serial.println( F( "reset" ));
-        Serial.print  ( F( "   Reset time:   " ));           /* reset time (if resetted) */
-        Serial.println( nwDateTimeString( resetTime ));
-    } else if( startTime > 0 ){
-        Serial.println( F( "started" ));
-        Serial.print  ( F( "   Start time:   " ));           /* start time (if started) */
-        Serial.println( nwDateTimeString( startTime ));
-        Serial.print  ( F( "   Last ping:    " ));           /* last ping (if started) */
-        Serial.println( nwDateTimeString( lastPing ));
-        time_t tnow = now();
-        Serial.print  ( F( "   Now is:       " ));           /* current time (if started) */
-        Serial.println( nwDateTimeString( tnow ));
-        Serial.print  ( F( "   Before reset: " ));           /* left before reset (if started) */
-        Serial.print  ( parmDelay-(tnow-lastPing));
-        Serial.println( F( " sec. left" ));
-    } else {
-        Serial.println( F( "stopped" ));
-    }
-    Serial.print  ( F( " Last reset:   " ));                 /* last reset event */
-    nwEvent ev = nwEEPROMResetEventGet( 0 );
-    if( ev.isNull()){
-        Serial.println( F( "none" ));
-    } else {
-        Serial.println( "" );
-        ev.display( strSpace3 );
-    }
-    Serial.flush();
-    return( true );
+    return( execAcknowledge( arg->l, arg->l2 ));
 }
 
 /**
- * cmdStop:
+ * cmdClearConfig:
+ * @arg: unused.
  *
- * Stop the watchdog
- * idempotent if already stopped (or not yet started)
- * no input args
+ * Remove the configuration saved in the EEPROM
+ * syntaxe: CLEAR CONFIG
+ *   the current configuration is left unchanged, but the board will
+ *   use the defaults at next startup
  *
  * Returns: true.
  */
-bool cmdStop()
+bool cmdClearConfig( const nwArg *arg )
 {
-    cmdReinit();
+    nwEEPROMConfigClear();
+    if( configSaved ){
+        configSaved = false;
+        statusChanged( STATUS_CONFIG );
+    }
     return( true );
 }
 
 /**
- * execReset
- * @reason: the reset reason code.
+ * cmdEepromInit:
+ * @arg: unused.
  *
- * If not in test mode, reset the PC and stores the event in EEPROM
- */
-bool execReset( int reason )
-{
-    if( resetTime == 0 ){
-        resetTime = now();
-        digitalWrite( LED_RESET, HIGH );
+ * EEPROM management:
+ * - INIT : initialize the EEPROM content to zero
+ *
+ * The 'SET DATE <time>' command should have been issued before initializing
+ * the EEPROM in order to have a valid date.
+ */
+bool cmdEepromInit( const nwArg *arg )
+{
+    /* first, init the EEPROM to zero */
+    statusChanged( STATUS_EVENT );
+    nwEEPROMClear();
+    if( configSaved ){
+        configSaved = false;
+        statusChanged( STATUS_CONFIG );
+    }
+    /* setup an empty reset log */
+    nwEEPROMSetup();
+    /* write the initialization event */
+    nwEvent ev( NW_REASON_INIT );
+    ev.acknowledge();
+    nwEEPROMInitEventSet( ev );
+    /* last blink the START LED and returns */
+    nwBlinkPin( LED_START );
+    return( true );
+}
+
+/**
+ * cmdEepromDump:
+ * @arg: unused.
+ *
+ * EEPROM management:
+ * - DUMP: display the EEPROM content
+ *
+ * Read and display the EEPROM content, the dump being streamed line by
+ * line (see printEepromDumpStep()).
+ */
+bool cmdEepromDump( const nwArg *arg )
+{
+    multiLine = true;
+    nwOutputStart( printEepromDumpStep, endCommand );
+    return( true );
+}
+
+/**
+ * printEepromDumpStep:
+ * @index: the index of the record.
+ *
+ * Display the index-th line of the EEPROM dump: the title, the
+ * initialization event, the count of reset events, then each of these,
+ * the event being read with its first line.
+ *
+ * Returns: false when the dump is complete, true else.
+ */
+bool printEepromDumpStep( unsigned int index )
+{
+    static nwEvent ev;
+
+    switch( index ){
+        case 0:
+            nwSerialPrintVersion();
+            Serial.println( F( "EEPROM dump:" ));
+            return( true );
+        case 1:
+            /* read initialization event */
+            ev = nwEEPROMInitEventGet();
+            Serial.println( F( " Initialization event:" ));
+            return( true );
+        case 2+NW_EVENT_LINES:
+            /* read reset traces count */
+            dumpCount = nwEEPROMResetEventCountGet();
+            Serial.println( F( " Reset events count:" ));
+            Serial.print( strSpace3 );
+            Serial.print( F( "count=" ));
+            Serial.println( dumpCount );
+            return( true );
+    }
+    if( index < 2+NW_EVENT_LINES ){
+        return( ev.displayLine( strSpace3, index-2 ));
+    }
+    index -= 3+NW_EVENT_LINES;
+    int i = index/( 1+NW_EVENT_LINES );
+    byte line = index%( 1+NW_EVENT_LINES );
+    if( i >= dumpCount ){
+        return( false );
+    }
+    if( line == 0 ){
+        ev = nwEEPROMResetEventGet( i );
+        Serial.print( F( " Reset event #" ));
+        Serial.println( i );
+        return( true );
+    }
+    return( ev.displayLine( strSpace3, line-1 ));
+}
+
+/**
+ * cmdEepromRead:
+ * @arg: the index of the first reset event, and the count of events.
+ *
+ * EEPROM management:
+ * - READ: list the specified reset events
+ *
+ * List up to <count> reset events, from the index <from> counted from
+ * the most recent=0, one machine-readable line per event (see
+ * printEventsStep()).
+ * syntax: EEPROM READ <from> <count>
+ *
+ * Returns: true.
+ */
+bool cmdEepromRead( const nwArg *arg )
+{
+    int count = nwEEPROMResetEventCountGet();
+    queryFrom = arg->l;
+    queryTo = arg->l+arg->l2-1;
+    if( queryTo >= count ){
+        queryTo = count-1;
+    }
+    queryUnack = false;
+    querySince = -1;
+    nwOutputStart( printEventsStep, endCommand );
+    return( true );
+}
+
+/**
+ * cmdEepromReadUnack:
+ * @arg: unused.
+ *
+ * EEPROM management:
+ * - READ UNACK: list the unacknowledged reset events
+ *
+ * List the unacknowledged reset events, as EEPROM READ does.
+ * syntax: EEPROM READ UNACK
+ *
+ * Returns: true.
+ */
+bool cmdEepromReadUnack( const nwArg *arg )
+{
+    queryFrom = 0;
+    queryTo = nwEEPROMResetEventCountGet()-1;
+    queryUnack = true;
+    querySince = -1;
+    nwOutputStart( printEventsStep, endCommand );
+    return( true );
+}
+
+/**
+ * cmdEepromReadSince:
+ * @arg: the sequence number of the last known reset event.
+ *
+ * EEPROM management:
+ * - READ SINCE: list the reset events recorded after a known one
+ *
+ * List the identifier of the reset log, then, as EEPROM READ does, the
+ * reset events of this log whose sequence number is greater than the
+ * specified one, so that the host only has to read the new events since
+ * its last synchronization:
+ *   log=<id>
+ * The sequence numbers are only meaningful inside a same log: the host
+ * has to read the whole log, i.e. since the sequence number zero, when
+ * the identifier is not the one it has synced, because the EEPROM has
+ * been initialized or the sequence numbers have wrapped since.
+ * syntax: EEPROM READ SINCE <seq>
+ *
+ * Returns: true.
+ */
+bool cmdEepromReadSince( const nwArg *arg )
+{
+    queryFrom = 0;
+    queryTo = nwEEPROMResetEventCountGet()-1;
+    queryUnack = false;
+    querySince = arg->l;
+    nwOutputStart( printEventsStep, endCommand );
+    return( true );
+}
+
+/**
+ * printEventsStep:
+ * @index: the index of the record.
+ *
+ * Display the queried reset events, one line per event:
+ *   event=<index> seq=<seq> time=<time_t> reason=<code> ack=<0|1> fwid=<id>
+ * With EEPROM READ SINCE, the log identifier is first displayed; then,
+ * the events being read from the most recent one, the list stops at the
+ * first one whose sequence number is not greater than the known one, or
+ * is not lower than the one of the previously listed event, i.e. which
+ * precedes a wrap of the sequence numbers.
+ * The answer is only a multi-lines one if at least one event matches,
+ * or if the log identifier is displayed.
+ *
+ * Returns: false when the list is complete, true else.
+ */
+bool printEventsStep( unsigned int index )
+{
+    if( querySince >= 0 ){
+        if( index == 0 ){
+            multiLine = true;
+            Serial.print( F( "log=" ));
+            Serial.println( nwEEPROMResetLogIdGet());
+            queryLast = 0x10000;
+            return( true );
+        }
+        index -= 1;
+    }
+    int i = queryFrom+index;
+    if( i > queryTo ){
+        return( false );
+    }
+    nwEvent ev = nwEEPROMResetEventGet( i );
+    if( querySince >= 0 && ev.getSeq()){
+        if( ev.getSeq() <= querySince || ev.getSeq() >= queryLast ){
+            return( false );
+        }
+        queryLast = ev.getSeq();
+    }
+    if( ev.getSeq() && !( queryUnack && ( ev.getAckReason() & B10000000 ))){
+        multiLine = true;
+        Serial.print( F( "event=" ));
+        Serial.print( i );
+        Serial.print( " " );
+        ev.displayRecord();
+    }
+    return( true );
+}
+
+/**
+ * cmdEepromStats:
+ * @arg: unused.
+ *
+ * EEPROM management:
+ * - STATS: display the EEPROM write counters
+ *
+ * Display, for each EEPROM region, the count of bytes written since
+ * startup and the count of bytes which have been left untouched because
+ * unchanged.
+ */
+bool cmdEepromStats( const nwArg *arg )
+{
+    multiLine = true;
+    nwSerialPrintVersion();
+    Serial.println( F( "EEPROM statistics (since startup):" ));
+    for( byte i=0 ; i<NW_EEPROM_REGION_COUNT ; ++i ){
+        Serial.print( strSpace3 );
+        Serial.print( FS( nwEEPROMRegionName( i )));
+        Serial.print( F( ": written=" ));
+        Serial.print( nwEEPROMWriteCountGet( i ));
+        Serial.print( F( ", unchanged=" ));
+        Serial.println( nwEEPROMSkipCountGet( i ));
+    }
+    Serial.print( F( " Reset events written since initialization: " ));
+    Serial.println( nwEEPROMResetEventSeqGet());
+    return( true );
+}
+
+/**
+ * cmdHelp:
+ * @arg: unused.
+ *
+ * Display the available commands.
+ *
+ * Returns: true.
+ */
+bool cmdHelp( const nwArg *arg )
+{
+    multiLine = true;
+    nwOutputStart( printHelpStep, endCommand );
+    return( true );
+}
+
+/**
+ * printHelpStep:
+ * @index: the index of the record.
+ *
+ * Display the title, then one line per command.
+ *
+ * Returns: false when the help is complete, true else.
+ */
+bool printHelpStep( unsigned int index )
+{
+    if( index == 0 ){
+        nwSerialPrintVersion();
+        Serial.println( F( "Available commands:" ));
+        return( true );
+    }
+    return( nwCommandHelpLine( index-1 ));
+}
+
+/**
+ * cmdNoop:
+ * @arg: unused.
+ *
+ * No-operation.
+ *
+ * Returns: true.
+ */
+bool cmdNoop( const nwArg *arg )
+{
+    return( true );
+}
+
+/**
+ * cmdPerf:
+ * @arg: unused.
+ *
+ * Display the performance counters (see nwPerf.h).
+ *
+ * Returns: true.
+ */
+bool cmdPerf( const nwArg *arg )
+{
+    multiLine = true;
+    nwSerialPrintVersion();
+    Serial.print( F( "Performance counters (since " ));
+    Serial.print( nwPerfSince());
+    Serial.println( F( " ms):" ));
+
+    Serial.print( F( " Loop: count=" ));
+    Serial.print( nwPerfLoopCount());
+    Serial.print( F( ", average=" ));
+    Serial.print( nwPerfLoopAverage());
+    Serial.print( F( " us, max=" ));
+    Serial.print( nwPerfLoopMax());
+    Serial.println( F( " us" ));
+
+    Serial.print( F( " Free RAM: min=" ));
+    unsigned long value = nwPerfFreeRamMin();
+    if( value == NW_PERF_NONE ){
+        Serial.println( F( "unknown" ));
+    } else {
+        Serial.print( value );
+        Serial.println( F( " bytes" ));
+    }
+
+    Serial.print( F( " Serial: rx full=" ));
+    Serial.print( nwPerfRxFullCount());
+    Serial.print( F( ", dropped=" ));
+    Serial.print( nwPerfRxDroppedCount());
+    Serial.print( F( ", bad frames=" ));
+    Serial.println( nwPerfBadFrameCount());
+
+    Serial.print( F( " EEPROM: written=" ));
+    Serial.print( nwPerfEEPROMWritten());
+    Serial.println( F( " bytes" ));
+
+    Serial.print( F( " Margin: min=" ));
+    byte channel;
+    value = nwPerfMarginMin( &channel );
+    if( value == NW_PERF_NONE ){
+        Serial.println( F( "none" ));
+    } else {
+        Serial.print( value );
+        Serial.print( F( " ms, channel=" ));
+        Serial.println( channel );
+    }
+
+    Serial.print( F( " Idle: sleeps=" ));
+    Serial.print( nwPerfIdleCount());
+    Serial.print( F( ", asleep=" ));
+    Serial.print( nwPerfIdleTime());
+    Serial.print( F( " ms (" ));
+    Serial.print( nwPerfSince() >= 100 ? nwPerfIdleTime()/( nwPerfSince()/100 ) : 0 );
+    Serial.println( F( "%)" ));
+
+    Serial.print( F( " Wake-to-parse: count=" ));
+    Serial.print( nwPerfWakeCount());
+    Serial.print( F( ", average=" ));
+    Serial.print( nwPerfWakeAverage());
+    Serial.print( F( " us, max=" ));
+    Serial.print( nwPerfWakeMax());
+    Serial.println( F( " us" ));
+
+    Serial.print( F( " Commands: total=" ));
+    Serial.print( nwPerfCommandTotal());
+    Serial.print( F( ", rejected=" ));
+    Serial.println( nwPerfRejectedCount());
+    for( byte i=0 ; i<nwCommandCountGet() ; ++i ){
+        if( nwPerfCommandCount( i )){
+            Serial.print( strSpace3 );
+            Serial.print( FS( nwCommandName( i )));
+            Serial.print( F( "=" ));
+            Serial.println( nwPerfCommandCount( i ));
+        }
+    }
+    if( nwPerfFrameCount( NW_BIN_OP_HEARTBEAT )){
+        Serial.print( F( "   heartbeat=" ));
+        Serial.println( nwPerfFrameCount( NW_BIN_OP_HEARTBEAT ));
+    }
+    for( byte i=0 ; i<NW_PERF_MAX_FRAME ; ++i ){
+        if( i != NW_BIN_OP_HEARTBEAT && nwPerfFrameCount( i )){
+            Serial.print( F( "   frame 0x" ));
+            if( i < 0x10 ){
+                Serial.print( '0' );
+            }
+            Serial.print( i, HEX );
+            Serial.print( F( "=" ));
+            Serial.println( nwPerfFrameCount( i ));
+        }
+    }
+    return( true );
+}
+
+/**
+ * cmdPerfReset:
+ * @arg: unused.
+ *
+ * Reset the performance counters.
+ *
+ * Returns: true.
+ */
+bool cmdPerfReset( const nwArg *arg )
+{
+    nwPerfReset();
+    return( true );
+}
+
+/**
+ * cmdPing:
+ * @arg: the optional channel number.
+ *
+ * Ping the watchdog channel, inhibiting the reset for the next interval
+ * doesn't ping if the reset has been activated
+ * syntax: PING [<channel>]
+ *
+ * Returns: true.
+ */
+bool cmdPing( const nwArg *arg )
+{
+    if( !heldPinged ){
+        execPing( cmdChannel( arg ));
+    }
+    return( true );
+}
+
+/**
+ * cmdPingDate:
+ * @arg: the optional channel number, and the current UTC date.
+ *
+ * Ping the watchdog channel as PING does, and synchronize the date of
+ * the board, which so doesn't drift between two SET DATE (see nwClock.h)
+ * syntax: PING [<channel>] <date>
+ *   date = NW_CLOCK_MIN_DATE..0x7FFFFFFF, lesser values being channels
+ *
+ * Returns: true.
+ */
+bool cmdPingDate( const nwArg *arg )
+{
+    if( !heldPinged ){
+        execPing( cmdChannel( arg ));
+    }
+    execSyncDate(( time_t ) arg->l );
+    return( true );
+}
+
+/**
+ * cmdReboot:
+ * @arg: the optional channel number, and the reason code.
+ *
+ * Reboot right now the target the channel is bound to, i.e. the PC
+ * when a single target is used.
+ *
+ * syntax: REBOOT [<channel>] <reason>
+ *
+ * Returns: true/false whether the command has been accepted.
+ */
+bool cmdReboot( const nwArg *arg )
+{
+    return( execReboot( arg->l, cmdChannel( arg )));
+}
+
+/**
+ * cmdReinit:
+ * @arg: unused.
+ *
+ * Reinit the watchdog.
+ * This is only useful when in development mode
+ *
+ * Returns: true.
+ */
+bool cmdReinit( const nwArg *arg )
+{
+    if( nwTargetResetCount()){
+        statusChanged( STATUS_STATE );
+    }
+    for( byte i=0 ; i<NW_MAX_TARGET ; ++i ){
+        nwTargetClear( i );
+    }
+    nwSchedulerPinWrite( LED_START, LOW );
+    nwSchedulerPinWrite( LED_RESET, LOW );
+    for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+        execStop( i );
+    }
+    startTime = 0;
+    return( true );
+}
+
+/**
+ * cmdSaveConfig:
+ * @arg: unused.
+ *
+ * Save the runtime configuration into the EEPROM
+ * syntaxe: SAVE CONFIG
+ *   the test mode, the delays of the channels and their targets, the
+ *   autostart and its grace period, and which channels are started, are
+ *   restored at startup (see loadConfig()); only the changed bytes are
+ *   written
+ *
+ * Returns: true.
+ */
+bool cmdSaveConfig( const nwArg *arg )
+{
+    nwConfigStr config;
+    config.flags = ( parmTest ? NW_CONFIG_TEST : 0 ) |
+            ( parmAutostart ? NW_CONFIG_AUTOSTART : 0 ) |
+            ( nwIdleIsEnabled() ? NW_CONFIG_IDLE : 0 );
+    config.started = 0;
+    config.targets = nwTargetBindingsGet();
+    config.grace = parmGrace;
+    for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+        if( nwChannelIsStarted( i )){
+            config.started |= ( 1 << i );
+        }
+        config.delay[i] = nwChannelDelayGet( i );
+    }
+    nwEEPROMConfigSet( config );
+    configSaved = true;
+    statusChanged( STATUS_CONFIG );
+    return( true );
+}
+
+/**
+ * cmdSetAutostart:
+ * @arg: whether to autostart.
+ *
+ * Set the autostart parameter
+ * syntaxe: SET AUTOSTART ON|OFF
+ *   whether the configuration saved by SAVE CONFIG starts at startup
+ *   the channels which were started, without waiting for the host;
+ *   only applies once saved
+ *   default = OFF
+ *
+ * Returns: true.
+ */
+bool cmdSetAutostart( const nwArg *arg )
+{
+    if( parmAutostart != arg->l ){
+        parmAutostart = arg->l;
+        statusChanged( STATUS_CONFIG );
+    }
+    return( true );
+}
+
+
+/**
+ * cmdSetBaud:
+ * @arg: the baud rate.
+ *
+ * Set the serial baud rate
+ * syntaxe: SET BAUD <rate>
+ *   where rate is one of 9600, 19200, 38400, 57600, 115200, 250000
+ * The new rate is used once the command has been answered at the
+ * current rate. It is stored in EEPROM as soon as a valid command has
+ * been received at the new rate; if no valid command is received in
+ * BAUD_FALLBACK seconds, the board falls back to NW_DEFAULT_BAUD.
+ *
+ * Returns: true if the command has been successfully executed, false else.
+ */
+bool cmdSetBaud( const nwArg *arg )
+{
+    if( nwBaudRateIsValid( arg->l )){
+        baudNext = arg->l;
+        return( true );
+    }
+    return( false );
+}
+
+/**
+ * cmdSetDate:
+ * @arg: the epoch time.
+ *
+ * Set the current date
+ * syntaxe: SET DATE <value>
+ *   where value is an epoch time (count of seconds since 1970-01-01)
+ * This is needed in order to be able actual reset time in EEPROM traces.
+ *
+ * Returns: true.
+ */
+bool cmdSetDate( const nwArg *arg )
+{
+    nwClockSet(( time_t ) arg->l );
+    if( !dateSet ){
+        dateSet = true;
+        statusChanged( STATUS_DATE );
+    }
+    return( true );
+}
+
+/**
+ * cmdSetDelay:
+ * @arg: the optional channel number, and the delay (ms).
+ *
+ * Set the reboot delay parameter of the channel
+ * syntaxe: SET DELAY [<channel>] <value>[ms]
+ *   the delay since the last ping at which the reset is launched, in
+ *   seconds, or in milliseconds with the 'ms' suffix
+ *   value = MIN_DELAY_MS ms..65535 sec.
+ *   default = 60 sec.
+ *
+ * Returns: true.
+ */
+bool cmdSetDelay( const nwArg *arg )
+{
+    byte channel = cmdChannel( arg );
+    if( nwChannelDelayGet( channel ) != ( unsigned long ) arg->l ){
+        nwChannelDelaySet( channel, arg->l );
+        statusChanged( channel == 0 ? STATUS_DELAY : STATUS_STATE );
+    }
+    return( true );
+}
+
+/**
+ * cmdSetEvents:
+ * @arg: whether to send the notifications.
+ *
+ * Set the asynchronous notifications
+ * syntaxe: SET EVENTS ON|OFF
+ *   whether the board sends a '!'-prefixed line (resp. a NOTIFY frame)
+ *   on each state transition, see nwNotify.h
+ *   default = OFF
+ *
+ * Returns: true.
+ */
+bool cmdSetEvents( const nwArg *arg )
+{
+    nwNotifyEnable( arg->l );
+    return( true );
+}
+
+/**
+ * cmdSetGrace:
+ * @arg: the grace period (sec.).
+ *
+ * Set the grace period of the autostart
+ * syntaxe: SET GRACE <grace>
+ *   the delay added to the first deadline of the channels started at
+ *   startup by the saved configuration, leaving the host the time to
+ *   boot up; only applies once saved
+ *   value = 0..MAX_GRACE sec.
+ *   default = 60 sec.
+ *
+ * Returns: true.
+ */
+bool cmdSetGrace( const nwArg *arg )
+{
+    if( parmGrace != arg->l ){
+        parmGrace = arg->l;
+        statusChanged( STATUS_CONFIG );
+    }
+    return( true );
+}
+
+/**
+ * cmdSetIdle:
+ * @arg: whether to sleep between the events.
+ *
+ * Set the idle mode
+ * syntaxe: SET IDLE ON|OFF
+ *   whether loop() puts the MCU into its idle sleep mode until the next
+ *   received byte or timer tick (ON), or busy polls (OFF), see nwIdle.h
+ *   default = ON
+ *
+ * Returns: true.
+ */
+bool cmdSetIdle( const nwArg *arg )
+{
+    if( nwIdleIsEnabled() != arg->l ){
+        nwIdleEnable( arg->l );
+        statusChanged( STATUS_CONFIG );
+    }
+    return( true );
+}
+
+/**
+ * cmdSetProtocol:
+ * @arg: unused.
+ *
+ * Set the communication protocol
+ * syntaxe: SET PROTOCOL BINARY
+ *   the switch happens once the command has been answered; the board
+ *   goes back to the text protocol on a NW_BIN_OP_TEXT request frame.
+ *
+ * Returns: true.
+ */
+bool cmdSetProtocol( const nwArg *arg )
+{
+    protocolNext = NW_PROTOCOL_BINARY;
+    return( true );
+}
+
+/**
+ * cmdSetTarget:
+ * @arg: the optional channel number, and the target number.
+ *
+ * Bind the channel to a reset target
+ * syntaxe: SET TARGET [<channel>] <target>
+ *   the relay of the target is activated when the channel misses its
+ *   deadline, or on REBOOT <channel>, so that a single board may reset
+ *   several hosts (see nwTarget.h)
+ *   target = 0..NW_MAX_TARGET-1
+ *   default = 0
+ *
+ * Returns: true.
+ */
+bool cmdSetTarget( const nwArg *arg )
+{
+    byte channel = cmdChannel( arg );
+    if( nwTargetOf( channel ) != arg->l ){
+        nwTargetBind( channel, arg->l );
+        statusChanged( STATUS_STATE );
+    }
+    return( true );
+}
+
+/**
+ * cmdSetTest:
+ * @arg: whether to set the test mode.
+ *
+ * Set the test parameter
+ * syntaxe: SET TEST ON|OFF
+ *   whether a reset is really launched, or is just flagged during tests
+ *   default = ON
+ *
+ * Returns: true.
+ */
+bool cmdSetTest( const nwArg *arg )
+{
+    if( parmTest != arg->l ){
+        parmTest = arg->l;
+        statusChanged( STATUS_TEST );
+    }
+    return( true );
+}
+
+/**
+ * cmdStart:
+ * @arg: the optional channel number.
+ *
+ * Start the watchdog channel
+ * idempotent if already started
+ * syntax: START [<channel>]
+ *
+ * Returns: true.
+ */
+bool cmdStart( const nwArg *arg )
+{
+    execStart( cmdChannel( arg ));
+    return( true );
+}
+
+/**
+ * cmdStatus:
+ *
+ * Display the current status of the watchdog
+ * no input args
+ * display:
+ * - status sequence number (see STATUS SINCE)
+ * - up date and time
+ * - start date and time, or zero if not started
+ * - current interval
+ * - current test
+ * - whether a config is saved, and the autostart
+ * - last ping date and time (may be zero)
+ * - date and time of reboot, or zero if not started
+ * - last reset time
+ *
+ * Returns: true:
+ */
+bool cmdStatus( const nwArg *arg )
+{
+    printStatus( STATUS_ALL );
+    return( true );
+}
+
+/**
+ * cmdStatusSince:
+ * @arg: the status sequence number.
+ *
+ * Display the status fields which have changed since the specified
+ * sequence number, as STATUS does, or nothing (i.e. a single-line
+ * answer) if nothing has changed.
+ * All the fields are displayed if the sequence number is greater than
+ * the current one, or is one of a previous startup of the board; the
+ * host has then to read the whole STATUS, as the Boot line, which is
+ * always displayed along with the Sequence one, has changed.
+ * syntax: STATUS SINCE <seq>
+ *
+ * Returns: true.
+ */
+bool cmdStatusSince( const nwArg *arg )
+{
+    unsigned long since = arg->l;
+    byte fields = 0;
+
+    if( since > statusSeq ){
+        fields = STATUS_ALL;
+    } else {
+        for( byte i=0 ; i<STATUS_COUNT ; ++i ){
+            if( statusFieldSeq[i] > since ){
+                fields |= ( 1 << i );
+            }
+        }
+    }
+    if( fields ){
+        printStatus( fields );
+    }
+    return( true );
+}
+
+/**
+ * statusChanged:
+ * @field: the STATUS_xxx field.
+ *
+ * Record that the field has changed.
+ */
+void statusChanged( byte field )
+{
+    statusSeq += 1;
+    statusFieldSeq[field] = statusSeq;
+    saveState();
+}
+
+/**
+ * saveState:
+ *
+ * Save the state which is to survive a reset of the board by its own
+ * watchdog timer.
+ */
+void saveState()
+{
+    wdtState state;
+    long drift;
+    state.flags = ( parmTest ? WDT_STATE_TEST : 0 ) |
+            ( dateSet ? WDT_STATE_DATE_SET : 0 ) |
+            ( parmAutostart ? WDT_STATE_AUTOSTART : 0 ) |
+            ( configSaved ? WDT_STATE_CONFIG_SAVED : 0 ) |
+            ( nwIdleIsEnabled() ? WDT_STATE_IDLE : 0 ) |
+            ( nwClockDriftGet( &drift ) ? WDT_STATE_DRIFT : 0 );
+    state.drift = drift;
+    state.started = 0;
+    state.targets = nwTargetBindingsGet();
+    state.grace = parmGrace;
+    state.date = now();
+    for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+        if( nwChannelIsStarted( i )){
+            state.started |= ( 1 << i );
+        }
+        state.delay[i] = nwChannelDelayGet( i );
+    }
+    nwWdtSave( &state, sizeof( state ));
+    stateDate = state.date;
+}
+
+/**
+ * resumeState:
+ *
+ * Restore the state saved before a reset of the board by its own
+ * watchdog timer: the date is advanced by the watchdog period, and the
+ * started channels restart with a full delay.
+ *
+ * Returns: true if a valid state has been restored.
+ */
+bool resumeState()
+{
+    wdtState state;
+    if( !nwWdtRestore( &state, sizeof( state ))){
+        return( false );
+    }
+    parmTest = state.flags & WDT_STATE_TEST;
+    dateSet = state.flags & WDT_STATE_DATE_SET;
+    parmAutostart = state.flags & WDT_STATE_AUTOSTART;
+    configSaved = state.flags & WDT_STATE_CONFIG_SAVED;
+    nwIdleEnable( state.flags & WDT_STATE_IDLE );
+    parmGrace = state.grace;
+    nwTargetBindingsSet( state.targets );
+    setTime( state.date + NW_WDT_PERIOD/1000 );
+    if( state.flags & WDT_STATE_DRIFT ){
+        nwClockDriftSet( state.drift );
+    }
+    for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+        nwChannelDelaySet( i, state.delay[i] );
+        if( state.started & ( 1 << i )){
+            execStart( i );
+        }
+    }
+    return( true );
+}
+
+/**
+ * loadConfig:
+ *
+ * Restore the configuration saved by SAVE CONFIG, if any; with the
+ * autostart, the channels which were started are started right now,
+ * their first deadline being pushed by the grace period, so that the
+ * PC is protected as soon as the board is powered up.
+ *
+ * Returns: true if a valid configuration has been restored.
+ */
+bool loadConfig()
+{
+    nwConfigStr config;
+    if( !nwEEPROMConfigGet( config )){
+        return( false );
+    }
+    parmTest = config.flags & NW_CONFIG_TEST;
+    parmAutostart = config.flags & NW_CONFIG_AUTOSTART;
+    nwIdleEnable( config.flags & NW_CONFIG_IDLE );
+    parmGrace = config.grace;
+    nwTargetBindingsSet( config.targets );
+    for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+        nwChannelDelaySet( i, config.delay[i] );
+        if( parmAutostart && ( config.started & ( 1 << i ))){
+            execStart( i, parmGrace*1000UL );
+        }
+    }
+    configSaved = true;
+    return( true );
+}
+
+/**
+ * printStatus:
+ * @fields: the mask of the STATUS_xxx fields to be displayed.
+ *
+ * Display the specified fields of the current status (see cmdStatus()),
+ * preceded by the current status sequence number.
+ * The answer is streamed (see printStatusStep()).
+ */
+void printStatus( byte fields )
+{
+    multiLine = true;
+    statusFields = fields;
+    nwOutputStart( printStatusStep, endCommand );
+}
+
+/**
+ * printStatusStep:
+ * @index: the index of the record.
+ *
+ * Display the index-th line of the status, if its field is displayed.
+ * The state field, with its time-dependent lines, is displayed as a
+ * single record, so that these lines are consistent.
+ * A field which changes while the status is streamed may be displayed
+ * with its new value, and is so displayed again by the next STATUS
+ * SINCE.
+ *
+ * Returns: false when the status is complete, true else.
+ */
+bool printStatusStep( unsigned int index )
+{
+    static nwEvent ev;
+    long drift;
+
+    switch( index ){
+        case 0:
+            nwSerialPrintVersion();
+            Serial.println( F( "Current status:" ));
+            break;
+        case 1:
+            Serial.print  ( F( " Sequence:       " ));           /* status sequence number */
+            Serial.println( statusSeq );
+            Serial.print  ( F( " Boot:           " ));           /* the startup it is about */
+            Serial.println( statusBoot );
+            break;
+        case 2:
+            if( statusFields & ( 1 << STATUS_DELAY )){
+                Serial.print  ( F( " Reset delay:    " ));       /* reset delay of channel 0 */
+                printDelay( nwChannelDelayGet( 0 ));
+                Serial.println();
+            }
+            break;
+        case 3:
+            if( statusFields & ( 1 << STATUS_TEST )){
+                Serial.print  ( F( " Test mode:      " ));       /* test mode */
+                Serial.println( parmTest ? F( "ON (test mode)" ) : F( "OFF (reset mode)" ));
+            }
+            break;
+        case 4:
+            if( statusFields & ( 1 << STATUS_DATE )){
+                Serial.print  ( F( " Date set:       " ));       /* whether the date has been set */
+                Serial.print  ( dateSet ? F( "yes" ) : F( "no" ));
+                if( nwClockDriftGet( &drift )){
+                    Serial.print  ( F( " (drift " ));            /* the clock drift estimate */
+                    Serial.print  ( drift );
+                    Serial.print  ( F( " ppm)" ));
+                }
+                Serial.println();
+            }
+            break;
+        case 5:
+            if( statusFields & ( 1 << STATUS_CONFIG )){
+                Serial.print  ( F( " Saved config:   " ));       /* whether a config is saved in EEPROM */
+                Serial.println( configSaved ? F( "yes" ) : F( "no" ));
+            }
+            break;
+        case 6:
+            if( statusFields & ( 1 << STATUS_CONFIG )){
+                Serial.print  ( F( " Autostart:      " ));       /* autostart and grace period */
+                if( parmAutostart ){
+                    Serial.print  ( F( "ON (grace " ));
+                    printDelay( parmGrace*1000UL );
+                    Serial.println( F( ")" ));
+                } else {
+                    Serial.println( F( "OFF" ));
+                }
+            }
+            break;
+        case 7:
+            if( statusFields & ( 1 << STATUS_CONFIG )){
+                Serial.print  ( F( " Idle mode:      " ));       /* sleep or busy poll */
+                Serial.println( nwIdleIsEnabled() ? F( "ON (sleep between events)" ) : F( "OFF (busy polling)" ));
+            }
+            break;
+        case 8:
+            if( statusFields & ( 1 << STATUS_STATE )){
+                printStatusState();
+            }
+            break;
+        case 9:
+            if( statusFields & ( 1 << STATUS_EVENT )){
+                Serial.print  ( F( " Last reset:   " ));         /* last reset event */
+                ev = nwEEPROMResetEventGet( 0 );
+                Serial.println( ev.isNull() ? F( "none" ) : F( "" ));
+            }
+            break;
+        default:
+            if( index >= 10+NW_EVENT_LINES ){
+                return( false );
+            }
+            if(( statusFields & ( 1 << STATUS_EVENT )) && !ev.isNull()){
+                ev.displayLine( strSpace3, index-10 );
+            }
+            break;
+    }
+    return( true );
+}
+
+/**
+ * printStatusState:
+ *
+ * Display the state field of the status, along with its
+ * time-dependent lines.
+ * The started channels whose target has not been reset are still
+ * watched, and are displayed after the reset targets, if any.
+ */
+void printStatusState()
+{
+    Serial.print  ( F( " Status:         " ));               /* current status */
+    if( nwTargetResetCount()){
+        Serial.println( F( "reset" ));
+        for( byte i=0 ; i<NW_MAX_TARGET ; ++i ){
+            if( nwTargetIsReset( i )){
+                Serial.print  ( F( "   Reset time" ));       /* reset time (of each reset target) */
+                if( i > 0 ){
+                    Serial.print  ( ' ' );
+                    Serial.print  ( i );
+                    Serial.print  ( F( ": " ));
+                } else {
+                    Serial.print  ( F( ":   " ));
+                }
+                nwDateTimePrint( nwTargetResetTime( i ));
+            }
+        }
+    } else if( nwChannelCount()){
+        Serial.println( F( "started" ));
+    } else {
+        Serial.println( F( "stopped" ));
+    }
+    if( nwTargetWatchedCount()){
+        time_t tnow = now();
+        Serial.print  ( F( "   Start time:   " ));           /* start time (if started) */
+        nwDateTimePrint( startTime );
+        if( nwTargetIsWatched( 0 )){
+            Serial.print  ( F( "   Last ping:    " ));       /* last ping (if channel 0 is watched) */
+            nwDateTimePrint( tnow-nwChannelSince( 0 )/1000 );
+        }
+        Serial.print  ( F( "   Now is:       " ));           /* current time (if started) */
+        nwDateTimePrint( tnow );
+        Serial.print  ( F( "   Before reset: " ));           /* left before the soonest deadline */
+        printDelay( nwTargetLeftMin());
+        Serial.println( F( " left" ));
+        for( byte i=1 ; i<NW_MAX_CHANNEL ; ++i ){
+            if( nwTargetIsWatched( i )){
+                Serial.print  ( F( "   Channel " ));         /* other watched channels */
+                Serial.print  ( i );
+                Serial.print  ( F( ":    " ));
+                printDelay( nwChannelLeft( i ));
+                Serial.print  ( F( " left, delay " ));
+                printDelay( nwChannelDelayGet( i ));
+                if( nwTargetOf( i )){
+                    Serial.print  ( F( ", target " ));       /* its target, if not the first one */
+                    Serial.print  ( nwTargetOf( i ));
+                }
+                Serial.println();
+            }
+        }
+    }
+}
+
+/**
+ * cmdStop:
+ * @arg: the optional channel number.
+ *
+ * Stop the watchdog channel, or the whole watchdog when no channel is
+ * specified
+ * idempotent if already stopped (or not yet started)
+ * syntax: STOP [<channel>]
+ *
+ * Returns: true.
+ */
+bool cmdStop( const nwArg *arg )
+{
+    if( arg->channel == NW_CHANNEL_NONE ){
+        cmdReinit( arg );
+    } else {
+        execStop( arg->channel );
+        if( !nwChannelCount()){
+            nwSchedulerPinWrite( LED_START, LOW );
+            startTime = 0;
+        }
+    }
+    return( true );
+}
+
+/**
+ * cmdChannel:
+ * @arg: the parsed argument of a NW_ARG_CHANNEL command.
+ *
+ * Returns: the specified channel number, defaulting to zero.
+ */
+byte cmdChannel( const nwArg *arg )
+{
+    return( arg->channel == NW_CHANNEL_NONE ? 0 : arg->channel );
+}
+
+/**
+ * printDelay:
+ * @delay: a delay (ms).
+ *
+ * Print the delay, as seconds if it is a whole count of them, as
+ * milliseconds else.
+ */
+void printDelay( unsigned long delay )
+{
+    if( delay % 1000 == 0 ){
+        Serial.print( delay/1000 );
+        Serial.print( F( " sec." ));
+    } else {
+        Serial.print( delay );
+        Serial.print( F( " ms" ));
+    }
+}
+
+/**
+ * execReset
+ * @reason: the reset reason code.
+ * @target: the reset target.
+ *
+ * If not in test mode, reset the target (i.e. the PC with a single
+ * target) and stores the event in EEPROM
+ */
+bool execReset( int reason, byte target )
+{
+    if( nwTargetReset( target )){
+        nwSchedulerPinWrite( LED_RESET, HIGH );
+        nwNotifyPush( NW_NOTIFY_RESET, NW_CHANNEL_NONE, reason );
+        statusChanged( STATUS_STATE );
         if( !parmTest ){
             /* write the reset time into eeprom */
-            nwEvent ev( reason );
+            nwEvent ev( reason, target );
             nwEEPROMResetEventSetNew( ev );
-            /* last, reset the PC */
-            nwBlinkPin( EXEC_RESET, EXEC_BLINK );
+            statusChanged( STATUS_EVENT );
+            nwNotifyPush( NW_NOTIFY_EEPROM, NW_CHANNEL_NONE, nwEEPROMResetEventSeqGet());
+            /* last, reset the target
+             * the relay is released later by the scheduler */
+            nwBlinkPin( nwTargetPin( target ), EXEC_BLINK );
+        }
+    }
+    return( true );
+}
+
+/**
+ * execAcknowledge
+ * @from: the index of the first reset event, counted from zero.
+ * @to: the index of the last reset event.
+ *
+ * Acknowledge the specified stored reset events.
+ *
+ * Returns: true if the indexes are valid, false else.
+ */
+bool execAcknowledge( long from, long to )
+{
+    if( from >= 0 && to < NW_MAX_RESET_EVENT &&
+            nwEEPROMResetEventAcknowledgeRange( from, to )){
+        if( from == 0 ){
+            statusChanged( STATUS_EVENT );
         }
+        return( true );
+    }
+    return( false );
+}
+
+/**
+ * execHeartbeat
+ *
+ * Ping the watchdog on a NW_HEARTBEAT byte, answering with a single
+ * byte. Contrarily to the text commands, the answer is not flushed:
+ * the host doesn't have to wait for it before sending the next one.
+ */
+void execHeartbeat()
+{
+    nwPerfFrame( NW_BIN_OP_HEARTBEAT );
+    Serial.write( execPing( 0 ) ? NW_HEARTBEAT_ACK : NW_HEARTBEAT_NAK );
+}
+
+/**
+ * execPing
+ * @channel: the channel number.
+ *
+ * Push the deadline of the channel, unless it is not started or the
+ * reset of its target has been activated.
+ *
+ * Returns: true if the channel has been pinged, false else.
+ */
+bool execPing( byte channel )
+{
+    if( nwTargetIsWatched( channel )){
+        nwChannelPing( channel );
+        nwBlinkPin( LED_PING );
+        return( true );
+    }
+    return( false );
+}
+
+/**
+ * execSyncDate
+ * @date: the current UTC date, as sent by the host with a ping.
+ *
+ * Synchronize the date of the board, setting it if it has not been set
+ * yet.
+ */
+void execSyncDate( time_t date )
+{
+    if( dateSet ){
+        nwClockSync( date );
+    } else {
+        nwClockSet( date );
+        dateSet = true;
+        statusChanged( STATUS_DATE );
+    }
+}
+
+/**
+ * execStart
+ * @channel: the channel number.
+ * @grace: the grace period of the first deadline (ms).
+ *
+ * Start the channel, notifying it if it was not started.
+ * Starting again a channel whose target has been reset leaves the reset
+ * state of the target, the channel restarting with a full delay: this
+ * is the way a rebooted host gets watched again.
+ */
+void execStart( byte channel, unsigned long grace )
+{
+    byte target = nwTargetOf( channel );
+    if( nwTargetIsReset( target )){
+        nwTargetClear( target );
+        nwChannelStop( channel );
+        nwSchedulerPinWrite( LED_RESET, nwTargetResetCount() ? HIGH : LOW );
+        statusChanged( STATUS_STATE );
+    }
+    if( !nwChannelCount()){
+        startTime = now();
+        nwSchedulerPinWrite( LED_START, HIGH );
+    }
+    if( !nwChannelIsStarted( channel )){
+        nwChannelStart( channel, grace );
+        nwNotifyPush( NW_NOTIFY_START, channel, nwChannelDelayGet( channel ));
+        statusChanged( STATUS_STATE );
+    }
+}
+
+/**
+ * execStop
+ * @channel: the channel number.
+ *
+ * Stop the channel, notifying it if it was started.
+ */
+void execStop( byte channel )
+{
+    if( nwChannelIsStarted( channel )){
+        nwChannelStop( channel );
+        nwNotifyPush( NW_NOTIFY_STOP, channel, 0 );
+        statusChanged( STATUS_STATE );
+    }
+}
+
+/**
+ * execReboot
+ * @reason: the reset reason code.
+ * @channel: the channel whose target is to be reset.
+ *
+ * Reset the target of the channel on an external request.
+ *
+ * Returns: true if the reason code is valid, false else.
+ */
+bool execReboot( long reason, byte channel )
+{
+    if( reason >= NW_REASON_COMMAND_START && reason <= NW_REASON_MAX ){
+        execReset( reason, nwTargetOf( channel ));
+        return( true );
+    }
+    return( false );
+}
+
+/**
+ * binPingIsValid:
+ * @frame: a NW_BIN_OP_PING request.
+ *
+ * The payload is empty, or holds the channel number, optionally followed
+ * by the current UTC date as a 4-bytes EPOCH time.
+ *
+ * Returns: whether the payload of the PING frame is valid.
+ */
+bool binPingIsValid( const nwFrame &frame )
+{
+    return( frame.length == 0 ||
+            (( frame.length == 1 || frame.length == 5 ) && frame.payload[0] < NW_MAX_CHANNEL ));
+}
+
+/**
+ * binStatus:
+ * @reply: the reply frame.
+ *
+ * Append the current status of the watchdog to the reply payload.
+ */
+void binStatus( nwFrame &reply )
+{
+    byte flags = 0;
+    long left = 0;
+    time_t tnow = now();
+
+    if( parmTest ){
+        flags |= NW_BIN_FLAG_TEST;
+    }
+    if( dateSet ){
+        flags |= NW_BIN_FLAG_DATE_SET;
     }
+    if( nwTargetResetCount()){
+        flags |= NW_BIN_FLAG_RESET;
+    }
+    if( nwTargetWatchedCount()){
+        flags |= NW_BIN_FLAG_STARTED;
+        left = nwTargetLeftMin();
+    }
+    nwBinaryPut( reply, flags, 1 );
+    nwBinaryPut( reply, nwChannelDelayGet( 0 )/1000, 2 );
+    nwBinaryPut( reply, left/1000, 4 );
+    nwBinaryPut( reply, tnow, 4 );
+    nwEvent ev = nwEEPROMResetEventGet( 0 );
+    nwBinaryPut( reply, ev.isNull() ? 0 : ev.getTime(), 4 );
+    nwBinaryPut( reply, ev.isNull() ? 0 : ev.getAckReason(), 1 );
+    nwBinaryPut( reply, nwChannelDelayGet( 0 ), 4 );
+    nwBinaryPut( reply, left, 4 );
+    nwBinaryPut( reply, statusSeq, 4 );
+    nwBinaryPut( reply, statusBoot, 2 );
+}
+
+/**
+ * binPerf:
+ * @reply: the reply frame.
+ *
+ * Append the performance counters to the reply payload, the 2-bytes
+ * ones being saturated.
+ */
+void binPerf( nwFrame &reply )
+{
+    const unsigned long counts[] = {
+        nwPerfLoopAverage(),
+        nwPerfRxFullCount(),
+        nwPerfRxDroppedCount(),
+        nwPerfBadFrameCount(),
+        nwPerfFreeRamMin()
+    };
+    byte channel;
+    unsigned long margin = nwPerfMarginMin( &channel );
+
+    nwBinaryPut( reply, nwPerfLoopCount(), 4 );
+    nwBinaryPut( reply, nwPerfLoopMax(), 4 );
+    for( byte i=0 ; i<sizeof( counts )/sizeof( counts[0] ) ; ++i ){
+        nwBinaryPut( reply, counts[i] > 0xFFFF ? 0xFFFF : counts[i], 2 );
+    }
+    nwBinaryPut( reply, nwPerfEEPROMWritten(), 4 );
+    nwBinaryPut( reply, margin, 4 );
+    nwBinaryPut( reply, channel, 1 );
+    nwBinaryPut( reply, nwPerfCommandTotal(), 4 );
+}
+
+/**
+ * binEepromDump:
+ *
+ * Stream one NW_BIN_OP_EVENT frame per stored event, the reply frame
+ * being sent after the last one (see binEepromDumpEnd()).
+ */
+void binEepromDump()
+{
+    nwOutputStart( binEepromDumpStep, binEepromDumpEnd );
+}
+
+/**
+ * binEepromDumpStep:
+ * @index: the index of the record.
+ *
+ * Send the NW_BIN_OP_EVENT frame of the initialization event, then of
+ * each reset event.
+ *
+ * Returns: false when the dump is complete, true else.
+ */
+bool binEepromDumpStep( unsigned int index )
+{
+    if( index == 0 ){
+        dumpCount = nwEEPROMResetEventCountGet();
+    }
+    int i = ( int ) index-1;
+    if( i >= dumpCount ){
+        return( false );
+    }
+    nwFrame frame;
+    nwEvent ev = ( i < 0 ) ? nwEEPROMInitEventGet() : nwEEPROMResetEventGet( i );
+    frame.opcode = NW_BIN_OP_EVENT;
+    frame.length = 0;
+    nwBinaryPut( frame, ( i < 0 ) ? 0xFF : i, 1 );
+    nwBinaryPut( frame, ev.getTime(), 4 );
+    nwBinaryPut( frame, ev.getAckReason(), 1 );
+    nwBinaryWrite( frame );
     return( true );
 }
 
+/**
+ * binEepromDumpEnd:
+ *
+ * Send the reply frame of the EEPROM DUMP, with the count of reset
+ * events.
+ */
+void binEepromDumpEnd()
+{
+    nwFrame reply;
+
+    reply.opcode = NW_BIN_OP_EEPROM_DUMP | NW_BIN_OP_REPLY;
+    reply.length = 0;
+    nwBinaryPut( reply, NW_BIN_STATUS_OK, 1 );
+    nwBinaryPut( reply, dumpCount, 1 );
+    nwBinaryWrite( reply );
+}
@@ -0,0 +1,315 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+/* The NanoWatchdog host bench
+ *
+ * Replays command streams against the firmware built for the host, and
+ * reports for each kind of command:
+ * - its count in the streams
+ * - the host CPU time of the loop() calls, until the last byte of the
+ *   answer has been sent (average and maximum, in microseconds)
+ * - the simulated milliseconds of the same calls (loop() is run once
+ *   per simulated millisecond)
+ * - the bytes physically written to the EEPROM
+ * - the bytes sent on the serial bus.
+ * The heap usage of the firmware and the EEPROM wear are reported for
+ * the whole run.
+ *
+ * The streams are text files, which may be recorded by nw-daemon.pl
+ * (see its 'record-file' option), each line being:
+ * - '@<n>': let n milliseconds elapse
+ * - 'X <hex> [<hex> ...]': send these bytes (binary frames, heartbeats)
+ * - '#...' or an empty line: ignored
+ * - anything else: send the line as a text command.
+ * The bytes are sent at the simulated baud rate, so that the firmware
+ * receives them over several loop() iterations.
+ *
+ * Usage: nw-bench [-v] [-b <baud>] [-e <eeprom.bin>] [-n <count>] [-o <output>] <stream> [...]
+ *  -v: echo the firmware output
+ *  -b: the simulated baud rate, zero for the bytes to be received at
+ *      once [19200]
+ *  -e: load the EEPROM from this file (erased else), and save it at end
+ *  -n: replay the streams this count of times
+ *  -o: write the transcript of the firmware output to this file, each
+ *      stream line being written as a '> <line>' line, so that it can
+ *      be compared with the expected one (see nwHostSerialOutput()).
+ */
+
+#include <Arduino.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NanoWatchdog.h"
+#include "nwBinary.h"
+#include "nwHost.h"
+
+void setup();
+void loop();
+
+/* after the command has been sent, the answer is considered complete
+ * when nothing has been sent for NW_BENCH_IDLE simulated ms
+ */
+#define NW_BENCH_IDLE            20
+#define NW_BENCH_MAX_MS          10000
+#define NW_BENCH_LINE_SIZE       256
+#define NW_BENCH_KEY_SIZE        24
+#define NW_BENCH_MAX_KEY         64
+
+struct nwBenchStat {
+	char          key[NW_BENCH_KEY_SIZE];
+	unsigned long count;
+	unsigned long ns;
+	unsigned long nsMax;
+	unsigned long ms;
+	unsigned long eeprom;
+	unsigned long serial;
+};
+
+static nwBenchStat st_stats[NW_BENCH_MAX_KEY];
+static byte        st_statCount = 0;
+
+static unsigned long hostNs()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( ts.tv_sec*1000000000UL+ts.tv_nsec );
+}
+
+/*
+ * Run loop() once per simulated ms, during at least @ms, then until
+ * the firmware has nothing left to read, and has sent nothing during
+ * NW_BENCH_IDLE ms.
+ * Returns the host time and the simulated time up to the last sent
+ * byte.
+ */
+static void run( unsigned long ms, unsigned long *ns, unsigned long *elapsed )
+{
+	unsigned long total = 0;
+	unsigned long idle = 0;
+	*ns = 0;
+	*elapsed = 0;
+	for( unsigned long i=0 ; i<NW_BENCH_MAX_MS && ( i<ms || idle<NW_BENCH_IDLE ) ; ++i ){
+		unsigned long sent = nwHostSerialSent();
+		unsigned long start = hostNs();
+		nwHostHeapTrack( true );
+		loop();
+		nwHostHeapTrack( false );
+		total += hostNs()-start;
+		nwHostAdvance( 1 );
+		if( nwHostSerialSent() != sent || nwHostSerialPending()){
+			idle = 0;
+			*ns = total;
+			*elapsed = i+1;
+		} else {
+			idle += 1;
+		}
+	}
+}
+
+/*
+ * The statistics of a stream line, whose key is the text command
+ * without its numeric arguments, or the binary opcode.
+ * The statistics are kept in the order of the first occurrence of
+ * their key.
+ */
+static nwBenchStat *lineStat( const char *line, const uint8_t *bytes, size_t count )
+{
+	char key[NW_BENCH_KEY_SIZE] = "";
+	if( line[0] == '@' ){
+		strcpy( key, "(elapsed time)" );
+	} else if( line[0] == 'X' ){
+		if( count == 1 && bytes[0] == NW_HEARTBEAT ){
+			strcpy( key, "(heartbeat)" );
+		} else if( count >= 2 && bytes[0] == NW_BIN_SOF ){
+			snprintf( key, sizeof( key ), "(frame 0x%02X)", bytes[1] );
+		} else {
+			strcpy( key, "(bytes)" );
+		}
+	} else {
+		size_t len = 0;
+		for( const char *c=line ; *c && len<sizeof( key )-1 ; ++c ){
+			if( isdigit( *c ) && ( c == line || c[-1] == ' ' )){
+				break;
+			}
+			key[len++] = toupper( *c );
+		}
+		while( len && key[len-1] == ' ' ){
+			len -= 1;
+		}
+		key[len] = '\0';
+	}
+	for( byte i=0 ; i<st_statCount ; ++i ){
+		if( !strcmp( st_stats[i].key, key )){
+			return( &st_stats[i] );
+		}
+	}
+	if( st_statCount == NW_BENCH_MAX_KEY ){
+		fprintf( stderr, "more than %d kinds of commands\n", NW_BENCH_MAX_KEY );
+		exit( 1 );
+	}
+	nwBenchStat *stat = &st_stats[st_statCount++];
+	strcpy( stat->key, key );
+	return( stat );
+}
+
+static bool replay( const char *fname )
+{
+	FILE *fp = fopen( fname, "r" );
+	if( !fp ){
+		perror( fname );
+		return( false );
+	}
+	char line[NW_BENCH_LINE_SIZE];
+	while( fgets( line, sizeof( line ), fp )){
+		line[strcspn( line, "\r\n" )] = '\0';
+		if( !line[0] || line[0] == '#' ){
+			continue;
+		}
+		uint8_t bytes[NW_BENCH_LINE_SIZE];
+		size_t count = 0;
+		unsigned long wait = 0;
+		if( line[0] == '@' ){
+			wait = strtoul( line+1, NULL, 10 );
+		} else if( line[0] == 'X' ){
+			char *p = line+1, *end;
+			unsigned long v;
+			while(( v = strtoul( p, &end, 16 )), end != p ){
+				bytes[count++] = v;
+				p = end;
+			}
+		} else {
+			count = strlen( line );
+			memcpy( bytes, line, count );
+			bytes[count++] = '\n';
+		}
+		unsigned long eeprom = nwHostEepromWrites();
+		unsigned long serial = nwHostSerialSent();
+		unsigned long ns, ms;
+		if( line[0] != '@' ){
+			nwHostSerialNote( line );
+		}
+		nwHostSerialFeed( bytes, count );
+		run( wait, &ns, &ms );
+
+		nwBenchStat *stat = lineStat( line, bytes, count );
+		stat->count += 1;
+		stat->ns += ns;
+		if( ns > stat->nsMax ){
+			stat->nsMax = ns;
+		}
+		stat->ms += ms;
+		stat->eeprom += nwHostEepromWrites()-eeprom;
+		stat->serial += nwHostSerialSent()-serial;
+	}
+	fclose( fp );
+	return( true );
+}
+
+static void report()
+{
+	printf( "%-24s %8s %10s %10s %8s %8s %8s\n",
+			"command", "count", "avg(us)", "max(us)", "avg(ms)", "eeprom", "serial" );
+	for( byte i=0 ; i<st_statCount ; ++i ){
+		const nwBenchStat *stat = &st_stats[i];
+		printf( "%-24s %8lu %10.2f %10.2f %8.1f %8lu %8lu\n",
+				stat->key, stat->count,
+				stat->ns/1000.0/stat->count, stat->nsMax/1000.0, ( double ) stat->ms/stat->count,
+				stat->eeprom, stat->serial );
+	}
+	nwHostHeapStats heap;
+	nwHostHeapGet( &heap );
+	printf( "EEPROM: %lu bytes written, at most %lu times at the same address\n",
+			nwHostEepromWrites(), nwHostEepromWearMax());
+	printf( "heap: %lu allocations, %lu frees, %lu bytes live, %lu bytes peak, %lu bytes fragmented\n",
+			heap.allocs, heap.frees, heap.live, heap.peak, heap.fragmented );
+}
+
+int main( int argc, char **argv )
+{
+	const char *eeprom = NULL;
+	const char *output = NULL;
+	unsigned long repeat = 1;
+	int opt;
+	while(( opt = getopt( argc, argv, "vb:e:n:o:" )) != -1 ){
+		switch( opt ){
+			case 'v':
+				nwHostSerialEcho( true );
+				break;
+			case 'b':
+				nwHostSerialBaud( strtoul( optarg, NULL, 10 ));
+				break;
+			case 'e':
+				eeprom = optarg;
+				break;
+			case 'n':
+				repeat = strtoul( optarg, NULL, 10 );
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				fprintf( stderr, "usage: %s [-v] [-b <baud>] [-e <eeprom.bin>] [-n <count>] [-o <output>] <stream> [...]\n", argv[0] );
+				return( 1 );
+		}
+	}
+	if( optind >= argc ){
+		fprintf( stderr, "%s: no stream to replay\n", argv[0] );
+		return( 1 );
+	}
+	nwHostEepromLoad( eeprom );
+	FILE *out = NULL;
+	if( output ){
+		out = fopen( output, "w" );
+		if( !out ){
+			perror( output );
+			return( 1 );
+		}
+		nwHostSerialOutput( out );
+	}
+
+	unsigned long ns, ms;
+	nwHostHeapTrack( true );
+	setup();
+	nwHostHeapTrack( false );
+	run( 0, &ns, &ms );
+
+	for( unsigned long r=0 ; r<repeat ; ++r ){
+		for( int i=optind ; i<argc ; ++i ){
+			if( !replay( argv[i] )){
+				return( 1 );
+			}
+		}
+	}
+	report();
+	if( out ){
+		nwHostSerialOutput( NULL );
+		fclose( out );
+	}
+	if( eeprom && !nwHostEepromSave( eeprom )){
+		perror( eeprom );
+		return( 1 );
+	}
+	return( 0 );
+}
@@ -0,0 +1,513 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include <EEPROM.h>
+#include <Time.h>
+#include <new>
+
+#include "nwHost.h"
+
+HardwareSerial Serial;
+EEPROMClass    EEPROM;
+uint8_t        nwHostEeprom[NW_HOST_EEPROM_SIZE];
+
+/* the simulated clock */
+static unsigned long st_millis = 0;
+static time_t        st_timeBase = 0;
+static unsigned long st_timeBaseMs = 0;
+
+/* the serial bus: the bytes on the wire, which are received at the
+ * simulated baud rate into the received bytes ring, and a sent bytes
+ * counter
+ */
+#define NW_HOST_RX_SIZE          1024
+
+static uint8_t       st_wire[NW_HOST_RX_SIZE];
+static size_t        st_wireHead = 0;
+static size_t        st_wireCount = 0;
+static unsigned long st_baud = 19200;
+static unsigned long st_bits = 0;		/* received bits, in 1/1000 */
+static uint8_t       st_rx[NW_HOST_RX_SIZE];
+static size_t        st_rxHead = 0;
+static size_t        st_rxCount = 0;
+static unsigned long st_txCount = 0;
+static bool          st_echo = false;
+static FILE         *st_output = NULL;
+static int           st_outputLast = '\n';
+
+/* the EEPROM write counters */
+static unsigned long st_eepromWrites = 0;
+static unsigned long st_eepromWear[NW_HOST_EEPROM_SIZE];
+
+/* the heap model
+ * live blocks are kept sorted by virtual address; each of them is
+ * charged with the 2 bytes of the avr-libc block header
+ */
+#define NW_HOST_HEAP_BLOCKS      64
+#define NW_HOST_HEAP_HEADER      2
+
+struct nwHostBlock {
+	void         *ptr;
+	unsigned long adr;
+	unsigned long size;
+};
+
+static nwHostBlock     st_blocks[NW_HOST_HEAP_BLOCKS];
+static byte            st_blockCount = 0;
+static bool            st_heapTrack = false;
+static nwHostHeapStats st_heap = { 0 };
+
+unsigned long millis()
+{
+	return( st_millis );
+}
+
+unsigned long micros()
+{
+	return( 1000*st_millis );
+}
+
+void delay( unsigned long ms )
+{
+	st_millis += ms;
+}
+
+void pinMode( uint8_t pin, uint8_t mode )
+{
+}
+
+void digitalWrite( uint8_t pin, uint8_t value )
+{
+}
+
+int digitalRead( uint8_t pin )
+{
+	return( LOW );
+}
+
+time_t now()
+{
+	return( st_timeBase+( st_millis-st_timeBaseMs )/1000 );
+}
+
+void setTime( time_t t )
+{
+	st_timeBase = t;
+	st_timeBaseMs = st_millis;
+}
+
+void adjustTime( long adjustment )
+{
+	st_timeBase += adjustment;
+}
+
+void breakTime( time_t t, TimeElements &tm )
+{
+	struct tm utc;
+	gmtime_r( &t, &utc );
+	tm.Second = utc.tm_sec;
+	tm.Minute = utc.tm_min;
+	tm.Hour = utc.tm_hour;
+	tm.Wday = utc.tm_wday+1;
+	tm.Day = utc.tm_mday;
+	tm.Month = utc.tm_mon+1;
+	tm.Year = utc.tm_year+1900-1970;
+}
+
+int HardwareSerial::available()
+{
+	return( st_rxCount );
+}
+
+int HardwareSerial::read()
+{
+	if( !st_rxCount ){
+		return( -1 );
+	}
+	int c = st_rx[st_rxHead];
+	st_rxHead = ( st_rxHead+1 ) % NW_HOST_RX_SIZE;
+	st_rxCount -= 1;
+	return( c );
+}
+
+int HardwareSerial::peek()
+{
+	return( st_rxCount ? st_rx[st_rxHead] : -1 );
+}
+
+size_t HardwareSerial::write( uint8_t c )
+{
+	st_txCount += 1;
+	if( st_echo ){
+		putchar( c );
+	}
+	if( st_output ){
+		if( c == '\n' || ( c >= 0x20 && c < 0x7F )){
+			fputc( c, st_output );
+			st_outputLast = c;
+		} else if( c != '\r' ){
+			fprintf( st_output, "<%02X>", c );
+			st_outputLast = '>';
+		}
+	}
+	return( 1 );
+}
+
+size_t HardwareSerial::write( const uint8_t *buffer, size_t size )
+{
+	for( size_t i=0 ; i<size ; ++i ){
+		write( buffer[i] );
+	}
+	return( size );
+}
+
+size_t HardwareSerial::print( const char *str )
+{
+	return( write(( const uint8_t * ) str, strlen( str )));
+}
+
+size_t HardwareSerial::print( long n, int base )
+{
+	char buffer[24];
+	snprintf( buffer, sizeof( buffer ), base == HEX ? "%lX" : "%ld", n );
+	return( print( buffer ));
+}
+
+size_t HardwareSerial::print( unsigned long n, int base )
+{
+	char buffer[24];
+	snprintf( buffer, sizeof( buffer ), base == HEX ? "%lX" : "%lu", n );
+	return( print( buffer ));
+}
+
+void nwHostEepromWrite( int adr, uint8_t value )
+{
+	if( adr < 0 || adr >= NW_HOST_EEPROM_SIZE ){
+		fprintf( stderr, "EEPROM write out of range at %d\n", adr );
+		abort();
+	}
+	nwHostEeprom[adr] = value;
+	st_eepromWrites += 1;
+	st_eepromWear[adr] += 1;
+}
+
+/* a byte received in a full ring is lost */
+static void rxPut( uint8_t c )
+{
+	if( st_rxCount < NW_HOST_RX_SIZE ){
+		st_rx[( st_rxHead+st_rxCount ) % NW_HOST_RX_SIZE] = c;
+		st_rxCount += 1;
+	}
+}
+
+/**
+ * nwHostAdvance:
+ * @ms: the count of milliseconds.
+ *
+ * Advance the simulated clock, receiving the bytes which have been
+ * transmitted meanwhile at the simulated baud rate (10 bits per byte).
+ */
+void nwHostAdvance( unsigned long ms )
+{
+	st_millis += ms;
+	if( st_wireCount ){
+		st_bits += st_baud*ms;
+		while( st_wireCount && st_bits >= 10000 ){
+			rxPut( st_wire[st_wireHead] );
+			st_wireHead = ( st_wireHead+1 ) % NW_HOST_RX_SIZE;
+			st_wireCount -= 1;
+			st_bits -= 10000;
+		}
+	}
+	if( !st_wireCount ){
+		st_bits = 0;
+	}
+}
+
+/**
+ * nwHostSerialBaud:
+ * @baud: the baud rate, or zero for the bytes to be received at once.
+ *
+ * Set the simulated baud rate of the bytes sent to the firmware.
+ */
+void nwHostSerialBaud( unsigned long baud )
+{
+	st_baud = baud;
+}
+
+/**
+ * nwHostSerialFeed:
+ * @data: the bytes.
+ * @size: the count of bytes.
+ *
+ * Send the bytes to the firmware: they are received as the simulated
+ * clock advances, so that a command or a frame most often spans several
+ * loop() iterations, as with an actual serial bus.
+ */
+void nwHostSerialFeed( const uint8_t *data, size_t size )
+{
+	for( size_t i=0 ; i<size ; ++i ){
+		if( !st_baud ){
+			rxPut( data[i] );
+		} else if( st_wireCount < NW_HOST_RX_SIZE ){
+			st_wire[( st_wireHead+st_wireCount ) % NW_HOST_RX_SIZE] = data[i];
+			st_wireCount += 1;
+		}
+	}
+}
+
+/**
+ * nwHostSerialPending:
+ *
+ * Returns: the count of sent bytes not yet read by the firmware.
+ */
+size_t nwHostSerialPending()
+{
+	return( st_wireCount+st_rxCount );
+}
+
+/**
+ * nwHostSerialSent:
+ *
+ * Returns: the count of bytes sent by the firmware since the start.
+ */
+unsigned long nwHostSerialSent()
+{
+	return( st_txCount );
+}
+
+/**
+ * nwHostSerialEcho:
+ * @echo: whether to copy the sent bytes to the standard output.
+ */
+void nwHostSerialEcho( bool echo )
+{
+	st_echo = echo;
+}
+
+/**
+ * nwHostSerialOutput:
+ * @fp: the file, or NULL.
+ *
+ * Write the bytes sent by the firmware to the file, as a transcript
+ * which can be compared with an expected one: the CR characters are
+ * dropped, and the non-printable bytes are written as '<XX>'.
+ */
+void nwHostSerialOutput( FILE *fp )
+{
+	st_output = fp;
+	st_outputLast = '\n';
+}
+
+/**
+ * nwHostSerialNote:
+ * @line: the line sent to the firmware.
+ *
+ * Write the line to the transcript, as a '> <line>' line.
+ */
+void nwHostSerialNote( const char *line )
+{
+	if( st_output ){
+		if( st_outputLast != '\n' ){
+			fputc( '\n', st_output );
+		}
+		fprintf( st_output, "> %s\n", line );
+		st_outputLast = '\n';
+	}
+}
+
+/**
+ * nwHostEepromLoad:
+ * @fname: the file which holds the EEPROM image.
+ *
+ * Load the EEPROM content, or erase it (all bytes set to 0xFF, as on a
+ * new chip) if the file doesn't exist.
+ *
+ * Returns: true if the file has been loaded.
+ */
+bool nwHostEepromLoad( const char *fname )
+{
+	memset( nwHostEeprom, 0xFF, sizeof( nwHostEeprom ));
+	FILE *fp = fname ? fopen( fname, "rb" ) : NULL;
+	if( !fp ){
+		return( false );
+	}
+	bool ok = ( fread( nwHostEeprom, 1, sizeof( nwHostEeprom ), fp ) == sizeof( nwHostEeprom ));
+	fclose( fp );
+	return( ok );
+}
+
+/**
+ * nwHostEepromSave:
+ * @fname: the file to write the EEPROM image to.
+ *
+ * Returns: true if the file has been written.
+ */
+bool nwHostEepromSave( const char *fname )
+{
+	FILE *fp = fopen( fname, "wb" );
+	if( !fp ){
+		return( false );
+	}
+	bool ok = ( fwrite( nwHostEeprom, 1, sizeof( nwHostEeprom ), fp ) == sizeof( nwHostEeprom ));
+	fclose( fp );
+	return( ok );
+}
+
+/**
+ * nwHostEepromWrites:
+ *
+ * Returns: the count of bytes physically written to the EEPROM since
+ *  the start.
+ */
+unsigned long nwHostEepromWrites()
+{
+	return( st_eepromWrites );
+}
+
+/**
+ * nwHostEepromWearMax:
+ *
+ * Returns: the highest count of writes of a single EEPROM address
+ *  (which is what limits the life of the EEPROM, at about 100,000
+ *  writes per address).
+ */
+unsigned long nwHostEepromWearMax()
+{
+	unsigned long max = 0;
+	for( int i=0 ; i<NW_HOST_EEPROM_SIZE ; ++i ){
+		if( st_eepromWear[i] > max ){
+			max = st_eepromWear[i];
+		}
+	}
+	return( max );
+}
+
+/**
+ * nwHostHeapTrack:
+ * @track: whether the allocations are made by the firmware.
+ *
+ * Only the allocations made while tracking are charged to the heap
+ * model, so that those of the bench itself are ignored.
+ */
+void nwHostHeapTrack( bool track )
+{
+	st_heapTrack = track;
+}
+
+/**
+ * nwHostHeapGet:
+ * @stats: [out] the heap usage since the start.
+ */
+void nwHostHeapGet( nwHostHeapStats *stats )
+{
+	*stats = st_heap;
+}
+
+static void heapAlloc( void *ptr, size_t size )
+{
+	if( st_blockCount == NW_HOST_HEAP_BLOCKS ){
+		fprintf( stderr, "more than %d live heap blocks\n", NW_HOST_HEAP_BLOCKS );
+		abort();
+	}
+	/* first fit: the first hole large enough, else the top of the heap */
+	unsigned long need = size+NW_HOST_HEAP_HEADER;
+	unsigned long adr = 0;
+	byte i;
+	for( i=0 ; i<st_blockCount ; ++i ){
+		if( st_blocks[i].adr-adr >= need ){
+			break;
+		}
+		adr = st_blocks[i].adr+st_blocks[i].size;
+	}
+	memmove( &st_blocks[i+1], &st_blocks[i], ( st_blockCount-i )*sizeof( nwHostBlock ));
+	st_blocks[i].ptr = ptr;
+	st_blocks[i].adr = adr;
+	st_blocks[i].size = need;
+	st_blockCount += 1;
+
+	st_heap.allocs += 1;
+	st_heap.live += need;
+	unsigned long top = st_blocks[st_blockCount-1].adr+st_blocks[st_blockCount-1].size;
+	if( top > st_heap.peak ){
+		st_heap.peak = top;
+	}
+}
+
+static void heapFree( void *ptr )
+{
+	for( byte i=0 ; i<st_blockCount ; ++i ){
+		if( st_blocks[i].ptr == ptr ){
+			st_heap.frees += 1;
+			st_heap.live -= st_blocks[i].size;
+			memmove( &st_blocks[i], &st_blocks[i+1], ( st_blockCount-i-1 )*sizeof( nwHostBlock ));
+			st_blockCount -= 1;
+			unsigned long top = st_blockCount ? st_blocks[st_blockCount-1].adr+st_blocks[st_blockCount-1].size : 0;
+			if( top-st_heap.live > st_heap.fragmented ){
+				st_heap.fragmented = top-st_heap.live;
+			}
+			return;
+		}
+	}
+}
+
+void *operator new( size_t size )
+{
+	void *ptr = malloc( size ? size : 1 );
+	if( !ptr ){
+		throw std::bad_alloc();
+	}
+	if( st_heapTrack ){
+		heapAlloc( ptr, size );
+	}
+	return( ptr );
+}
+
+void *operator new[]( size_t size )
+{
+	return( operator new( size ));
+}
+
+void operator delete( void *ptr ) noexcept
+{
+	if( ptr ){
+		heapFree( ptr );
+		free( ptr );
+	}
+}
+
+void operator delete[]( void *ptr ) noexcept
+{
+	operator delete( ptr );
+}
+
+void operator delete( void *ptr, size_t size ) noexcept
+{
+	operator delete( ptr );
+}
+
+void operator delete[]( void *ptr, size_t size ) noexcept
+{
+	operator delete( ptr );
+}
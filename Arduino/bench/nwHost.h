@@ -0,0 +1,74 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWHOST_H__
+#define __NWHOST_H__
+
+/* The host side of the Arduino shims
+ *
+ * Lets the bench drive the simulated hardware (clock, serial bus) and
+ * read the counters it maintains:
+ * - the bytes sent on the serial bus
+ * - the physical EEPROM writes, globally and per address
+ * - the heap usage of the firmware, on a first-fit model of the 2 KB
+ *   SRAM heap of the Nano (see nwHostHeapStats).
+ */
+
+#include <Arduino.h>
+
+/* the heap usage
+ * addresses are those of a virtual heap where each allocation takes the
+ * first free hole large enough, like avr-libc malloc() does:
+ * - peak is the highest break of this heap
+ * - fragmented is the count of free bytes below the break, i.e. which
+ *   have been allocated then freed, but are not at the top of the heap,
+ *   measured when the heap was the most fragmented
+ */
+struct nwHostHeapStats {
+	unsigned long allocs;
+	unsigned long frees;
+	unsigned long live;
+	unsigned long peak;
+	unsigned long fragmented;
+};
+
+void          nwHostAdvance( unsigned long ms );
+
+void          nwHostSerialFeed( const uint8_t *data, size_t size );
+size_t        nwHostSerialPending();
+unsigned long nwHostSerialSent();
+void          nwHostSerialEcho( bool echo );
+void          nwHostSerialBaud( unsigned long baud );
+void          nwHostSerialOutput( FILE *fp );
+void          nwHostSerialNote( const char *line );
+
+bool          nwHostEepromLoad( const char *fname );
+bool          nwHostEepromSave( const char *fname );
+unsigned long nwHostEepromWrites();
+unsigned long nwHostEepromWearMax();
+
+void          nwHostHeapTrack( bool track );
+void          nwHostHeapGet( nwHostHeapStats *stats );
+
+#endif /* __NWHOST_H__ */
@@ -0,0 +1,123 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWSHIM_ARDUINO_H__
+#define __NWSHIM_ARDUINO_H__
+
+/* A minimal host replacement of the Arduino core
+ *
+ * Only provides what the NanoWatchdog sketch and library actually use,
+ * so that they can be built and benchmarked on the host (see nw-bench.cpp).
+ * The Flash memory is plain memory here: PROGMEM is a no-op, and the _P
+ * functions are their standard counterparts.
+ */
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH                     1
+#define LOW                      0
+#define INPUT                    0
+#define OUTPUT                   1
+#define DEC                      10
+#define HEX                      16
+
+#define B01111111                0x7F
+#define B10000000                0x80
+
+#define PROGMEM
+#define PGM_P                    const char *
+#define PSTR( s )                ( s )
+#define F( s )                   (( const __FlashStringHelper * )( s ))
+
+#define pgm_read_byte( p )       ( *( const uint8_t * )( p ))
+#define pgm_read_byte_near( p )  ( *( const uint8_t * )( p ))
+#define pgm_read_word( p )       ( *( const uint16_t * )( p ))
+#define pgm_read_dword( p )      ( *( const uint32_t * )( p ))
+#define pgm_read_ptr( p )        ( *( void * const * )( p ))
+
+#define memcpy_P                 memcpy
+#define strcasecmp_P             strcasecmp
+#define strcmp_P                 strcmp
+#define strcpy_P                 strcpy
+#define strlen_P                 strlen
+#define strncmp_P                strncmp
+#define strncpy_P                strncpy
+
+class __FlashStringHelper;
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+unsigned long millis();
+unsigned long micros();
+void delay( unsigned long ms );
+void pinMode( uint8_t pin, uint8_t mode );
+void digitalWrite( uint8_t pin, uint8_t value );
+int  digitalRead( uint8_t pin );
+
+/* the serial bus
+ * the received bytes are fed by the bench, the sent ones are counted
+ * and optionally echoed to the standard output (see nwHost.h); they are
+ * so sent at once, and the TX buffer is always seen as empty
+ */
+class HardwareSerial {
+	public:
+		void   begin( unsigned long baud ) {}
+		void   end() {}
+		void   flush() {}
+		int    available();
+		int    read();
+		int    peek();
+		int    availableForWrite() { return( 63 ); }
+		size_t write( uint8_t c );
+		size_t write( const uint8_t *buffer, size_t size );
+
+		size_t print( const char *str );
+		size_t print( const __FlashStringHelper *str ) { return( print(( const char * ) str )); }
+		size_t print( char c )                         { return( write( c )); }
+		size_t print( unsigned char n, int base=DEC )  { return( print(( unsigned long ) n, base )); }
+		size_t print( int n, int base=DEC )            { return( print(( long ) n, base )); }
+		size_t print( unsigned int n, int base=DEC )   { return( print(( unsigned long ) n, base )); }
+		size_t print( long n, int base=DEC );
+		size_t print( unsigned long n, int base=DEC );
+
+		size_t println()                               { return( print( "\r\n" )); }
+		template< typename T > size_t println( T v )   { return( print( v )+println()); }
+		template< typename T > size_t println( T v, int base ) { return( print( v, base )+println()); }
+
+		operator bool() { return( true ); }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* __NWSHIM_ARDUINO_H__ */
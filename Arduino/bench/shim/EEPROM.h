@@ -0,0 +1,68 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWSHIM_EEPROM_H__
+#define __NWSHIM_EEPROM_H__
+
+/* A host replacement of the Arduino EEPROM library
+ *
+ * The EEPROM is a plain array, whose physical writes are counted by
+ * address so that the bench can report them (see nwHost.h).
+ */
+
+#include <Arduino.h>
+
+#define NW_HOST_EEPROM_SIZE      1024
+
+void nwHostEepromWrite( int adr, uint8_t value );
+
+extern uint8_t nwHostEeprom[NW_HOST_EEPROM_SIZE];
+
+class EEPROMClass {
+	public:
+		uint8_t  read( int adr )                 { return( nwHostEeprom[adr] ); }
+		void     write( int adr, uint8_t value ) { nwHostEepromWrite( adr, value ); }
+		void     update( int adr, uint8_t value ) {
+			if( nwHostEeprom[adr] != value ){
+				nwHostEepromWrite( adr, value );
+			}
+		}
+		uint16_t length() { return( NW_HOST_EEPROM_SIZE ); }
+
+		template< typename T > T &get( int adr, T &t ) {
+			memcpy( &t, nwHostEeprom+adr, sizeof( T ));
+			return( t );
+		}
+		template< typename T > const T &put( int adr, const T &t ) {
+			const uint8_t *p = ( const uint8_t * ) &t;
+			for( size_t i=0 ; i<sizeof( T ) ; ++i ){
+				update( adr+i, p[i] );
+			}
+			return( t );
+		}
+};
+
+extern EEPROMClass EEPROM;
+
+#endif /* __NWSHIM_EEPROM_H__ */
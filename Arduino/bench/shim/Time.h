@@ -0,0 +1,54 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWSHIM_TIME_H__
+#define __NWSHIM_TIME_H__
+
+/* A host replacement of the Time library
+ * (http://www.pjrc.com/teensy/td_libs_Time.html)
+ *
+ * The clock is driven by the simulated millis() of the bench.
+ */
+
+#include <Arduino.h>
+#include <time.h>
+
+typedef struct {
+	uint8_t Second;
+	uint8_t Minute;
+	uint8_t Hour;
+	uint8_t Wday;						/* day of week, sunday is day 1 */
+	uint8_t Day;
+	uint8_t Month;
+	uint8_t Year;						/* offset from 1970 */
+} TimeElements;
+
+#define tmYearToCalendar( Y )    (( Y )+1970 )
+
+time_t now();
+void   setTime( time_t t );
+void   adjustTime( long adjustment );
+void   breakTime( time_t t, TimeElements &tm );
+
+#endif /* __NWSHIM_TIME_H__ */
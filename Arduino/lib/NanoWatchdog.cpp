@@ -24,53 +24,128 @@
 
 #include "NanoWatchdog.h"
 
+/**
+ * nwBaudRateIsValid:
+ * @rate: a serial baud rate.
+ *
+ * Returns: true if @rate is one of the supported rates.
+ */
+bool nwBaudRateIsValid( long rate )
+{
+	for( byte i=0 ; i<sizeof( nwBaudRates )/sizeof( nwBaudRates[0] ) ; ++i ){
+		if(( long ) pgm_read_dword( nwBaudRates+i ) == rate ){
+			return( true );
+		}
+	}
+	return( false );
+}
+
 /**
  * nwBlinkPin:
  * @pin: the PIN number of the LED.
  * @blink: the delay in milliseconds; defaults to LED_BLINK.
+ *
+ * Set the pin HIGH right now, and schedule it back to LOW after @blink
+ * milliseconds. This doesn't block: the transition is executed by
+ * nwSchedulerRun() from the main loop.
  */
 void nwBlinkPin( int pin, int blink )
 {
-    digitalWrite( pin, HIGH );
-    delay( blink );
-    digitalWrite( pin, LOW );
+    nwSchedulerPinWrite( pin, HIGH );
+    nwSchedulerPinSet( pin, LOW, blink );
+}
+
+/*
+ * nwDateTimeDigits:
+ * @p: where to write the digits.
+ * @value: the value to be written.
+ * @count: the count of digits, left-padded with zeros.
+ *
+ * Returns: the position after the written digits.
+ */
+static char *nwDateTimeDigits( char *p, int value, byte count )
+{
+	for( byte i=count ; i>0 ; --i ){
+		p[i-1] = '0' + value % 10;
+		value /= 10;
+	}
+	return( p+count );
+}
+
+/**
+ * nwDateTimeFormat:
+ * @t: a time_t value
+ * @buffer: [out] a buffer of at least NW_DATETIME_SIZE chars.
+ *
+ * Format the date and time, without any dynamic allocation.
+ *
+ * Returns: @buffer, which contains the corresponding
+ *  'yyyy-mm-dd hh:mi:ss UTC' null-terminated date and time.
+ */
+char *nwDateTimeFormat( time_t t, char *buffer )
+{
+	TimeElements tm;
+	char *p = buffer;
+
+	breakTime( t, tm );
+	p = nwDateTimeDigits( p, tmYearToCalendar( tm.Year ), 4 );
+	*p++ = '-';
+	p = nwDateTimeDigits( p, tm.Month, 2 );
+	*p++ = '-';
+	p = nwDateTimeDigits( p, tm.Day, 2 );
+	*p++ = ' ';
+	p = nwDateTimeDigits( p, tm.Hour, 2 );
+	*p++ = ':';
+	p = nwDateTimeDigits( p, tm.Minute, 2 );
+	*p++ = ':';
+	p = nwDateTimeDigits( p, tm.Second, 2 );
+	strcpy_P( p, PSTR( " UTC" ));
+
+	return( buffer );
 }
 
 /**
- * nwDateTimeString:
+ * nwDateTimePrint:
  * @t: a time_t value
  *
- * Returns: the corresponding 'yyyy-mm-dd hh:mi:ss' date and time as a
- * new String
+ * Print the 'yyyy-mm-dd hh:mi:ss UTC' date and time to Serial, as a
+ * line.
+ */
+void nwDateTimePrint( time_t t )
+{
+	char buffer[NW_DATETIME_SIZE];
+	Serial.println( nwDateTimeFormat( t, buffer ));
+}
+
+/**
+ * nwStrStartsWith:
+ * @str: a null-terminated string.
+ * @prefix: a null-terminated string stored in Flash memory (PSTR).
+ *
+ * Returns: true if @str starts with @prefix.
+ */
+bool nwStrStartsWith( const char *str, PGM_P prefix )
+{
+	return( strncmp_P( str, prefix, strlen_P( prefix )) == 0 );
+}
+
+/**
+ * nwStrToLong:
+ * @str: a null-terminated string.
+ * @value: [out] the parsed value.
+ *
+ * Parse a decimal number, which must make up all the string.
+ *
+ * Returns: true if @str was a valid number, false else.
  */
-String nwDateTimeString( time_t t )
+bool nwStrToLong( const char *str, long *value )
 {
-    TimeElements tm;
-    breakTime( t, tm );
-    String str = String( tmYearToCalendar( tm.Year ), DEC ) + "-";
-    if( tm.Month < 10 ){
-        str = str + "0";
-    }
-    str = str + String( tm.Month, DEC ) + "-";
-    if( tm.Day < 10 ){
-        str = str + "0";
-    }
-    str = str + String( tm.Day, DEC ) + " ";
-    if( tm.Hour < 10 ){
-        str = str + "0";
-    }
-    str = str + String( tm.Hour, DEC ) + ":";
-    if( tm.Minute < 10 ){
-        str = str + "0";
-    }
-    str = str + String( tm.Minute, DEC ) + ":";
-    if( tm.Second < 10 ){
-        str = str + "0";
-    }
-    str = str + String( tm.Second, DEC );
-    str += " UTC";
-   
-    return( str );
+	char *end;
+	if( !*str ){
+		return( false );
+	}
+	*value = strtol( str, &end, 10 );
+	return( *end == '\0' );
 }
 
 /**
@@ -39,20 +39,64 @@ static const int nwVersionSize = 32;
 /*                                             1234567890123456789012345678901 */
 static const PROGMEM char nwVersionString[] = "NanoWatchdog v11.2017";
 
+/* end-of-response markers
+ * each command answer is terminated by one of these markers, sent as a
+ * full line after the 'OK:' or 'Unknown or invalid command:' line, so
+ * that the daemon doesn't have to wait for a read timeout; the second
+ * one terminates the answers which are displayed on several lines */
+static const PROGMEM char nwEndOfResponse[]  = ".";
+static const PROGMEM char nwEndOfMultiline[] = "..";
+
+/* the single-byte heartbeat
+ * received outside of a command line or of a frame, it pings the
+ * watchdog; it is answered with a single NW_HEARTBEAT_ACK byte, or with
+ * NW_HEARTBEAT_NAK if the watchdog is not started, so that the host may
+ * send the next one without waiting for the answer */
+#define NW_HEARTBEAT		0x05			/* ASCII ENQ */
+#define NW_HEARTBEAT_ACK	0x06			/* ASCII ACK */
+#define NW_HEARTBEAT_NAK	0x15			/* ASCII NAK */
+
+/* the serial baud rates, the first one being the default */
+#define NW_DEFAULT_BAUD	19200
+static const PROGMEM long nwBaudRates[] = { NW_DEFAULT_BAUD, 9600, 38400, 57600, 115200, 250000 };
+
 #define LED_BLINK	300					/* elapsed milliseconds on/off for a led blink */
 
-/* blink the specified LED */
+/* blink the specified LED (asynchronously) */
 void nwBlinkPin( int pin, int blink=LED_BLINK );
 
-/* a command date formating function
- * display yyyy-mm-dd hh:mi:ss from a time_t value */
-String nwDateTimeString( time_t time );
+/* the date formating functions
+ * format 'yyyy-mm-dd hh:mi:ss UTC' from a time_t value, either into a
+ * buffer of at least NW_DATETIME_SIZE chars, or to Serial */
+#define NW_DATETIME_SIZE	24
+
+char *nwDateTimeFormat( time_t time, char *buffer );
+void  nwDateTimePrint ( time_t time );
+
+/* some helping functions to parse the commands */
+bool nwStrStartsWith( const char *str, PGM_P prefix );
+bool nwStrToLong( const char *str, long *value );
+
+/* whether the baud rate is one of nwBaudRates */
+bool nwBaudRateIsValid( long rate );
 
 /* some helping functions for Serial.print */
 void nwSerialPrintVersion();
 
+#include "nwBinary.h"
+#include "nwChannel.h"
+#include "nwClock.h"
+#include "nwCommand.h"
 #include "nwEEPROM.h"
 #include "nwEvent.h"
+#include "nwIdle.h"
+#include "nwNotify.h"
+#include "nwOutput.h"
+#include "nwPerf.h"
+#include "nwProfile.h"
 #include "nwReason.h"
+#include "nwScheduler.h"
+#include "nwTarget.h"
+#include "nwWdt.h"
 
 #endif /* __NANOWATCHDOG_H__ */
@@ -0,0 +1,185 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+/* the state of the reader which discards the rest of a too long frame */
+#define NW_BIN_DISCARD           0xFF
+
+/**
+ * nwCrc8:
+ * @crc: the current CRC value (zero to start with).
+ * @data: the next byte.
+ *
+ * Returns: the CRC-8 (polynomial x^8+x^2+x+1, no reflection) updated
+ * with @data.
+ */
+byte nwCrc8( byte crc, byte data )
+{
+	crc ^= data;
+	for( byte i=0 ; i<8 ; ++i ){
+		crc = ( crc & 0x80 ) ? ( crc << 1 ) ^ 0x07 : ( crc << 1 );
+	}
+	return( crc );
+}
+
+/**
+ * nwBinaryRead:
+ * @frame: [out] the received frame.
+ *
+ * Read the available bytes from the serial input, without blocking.
+ * The bytes received before a NW_BIN_SOF marker are ignored, and a
+ * partial frame is dropped if the next byte doesn't come within
+ * NW_BIN_TIMEOUT ms, so that the reader resynchronizes itself.
+ *
+ * As a frame most often spans several calls, it is assembled in the
+ * static st_frame, @frame being only set once it is complete.
+ *
+ * When a frame has been received with a wrong CRC, or with a too long
+ * payload, it is returned as a NW_BIN_OP_ERROR frame whose payload is
+ * the original opcode; after a too long payload, the received bytes are
+ * discarded until NW_BIN_TIMEOUT ms of silence, so that the rest of the
+ * payload is neither taken as heartbeats nor as the start of a frame.
+ *
+ * Returns: true when a full frame has been received.
+ */
+bool nwBinaryRead( nwFrame &frame )
+{
+	static nwFrame       st_frame;
+	static byte          st_pos = 0;	/* count of bytes received in the frame, or NW_BIN_DISCARD */
+	static byte          st_crc = 0;
+	static unsigned long st_last = 0;
+
+	if( st_pos > 0 && millis() - st_last > NW_BIN_TIMEOUT ){
+		st_pos = 0;
+	}
+	while( Serial.available() > 0 ){
+		byte c = Serial.read();
+		st_last = millis();
+		if( st_pos == NW_BIN_DISCARD ){
+			continue;
+		}
+		if( st_pos == 0 ){
+			if( c == NW_BIN_SOF ){
+				st_pos = 1;
+				st_crc = 0;
+			} else if( c == NW_HEARTBEAT ){
+				frame.opcode = NW_BIN_OP_HEARTBEAT;
+				frame.length = 0;
+				return( true );
+			}
+		} else if( st_pos == 1 ){
+			st_frame.opcode = c;
+			st_crc = nwCrc8( st_crc, c );
+			st_pos = 2;
+		} else if( st_pos == 2 ){
+			st_frame.length = c;
+			st_crc = nwCrc8( st_crc, c );
+			st_pos = 3;
+			if( st_frame.length > NW_BIN_MAX_PAYLOAD ){
+				frame.payload[0] = st_frame.opcode;
+				frame.opcode = NW_BIN_OP_ERROR;
+				frame.length = 1;
+				st_pos = NW_BIN_DISCARD;
+				return( true );
+			}
+		} else if( st_pos < 3+st_frame.length ){
+			st_frame.payload[st_pos-3] = c;
+			st_crc = nwCrc8( st_crc, c );
+			st_pos += 1;
+		} else {
+			st_pos = 0;
+			if( c != st_crc ){
+				frame.payload[0] = st_frame.opcode;
+				frame.opcode = NW_BIN_OP_ERROR;
+				frame.length = 1;
+			} else {
+				frame = st_frame;
+			}
+			return( true );
+		}
+	}
+	return( false );
+}
+
+/**
+ * nwBinaryWrite:
+ * @frame: the frame to be sent.
+ *
+ * Send the frame to the serial output, computing its CRC.
+ */
+void nwBinaryWrite( nwFrame &frame )
+{
+	byte crc = 0;
+
+	Serial.write( NW_BIN_SOF );
+	Serial.write( frame.opcode );
+	crc = nwCrc8( crc, frame.opcode );
+	Serial.write( frame.length );
+	crc = nwCrc8( crc, frame.length );
+	for( byte i=0 ; i<frame.length ; ++i ){
+		Serial.write( frame.payload[i] );
+		crc = nwCrc8( crc, frame.payload[i] );
+	}
+	Serial.write( crc );
+}
+
+/**
+ * nwBinaryPut:
+ * @frame: the frame.
+ * @value: the value to be appended to the payload.
+ * @size: the count of bytes of @value to be appended.
+ *
+ * Append the @size least significant bytes of @value to the payload,
+ * as little-endian. Bytes which would overflow the payload are dropped.
+ */
+void nwBinaryPut( nwFrame &frame, unsigned long value, byte size )
+{
+	for( byte i=0 ; i<size && frame.length < NW_BIN_MAX_PAYLOAD ; ++i ){
+		frame.payload[frame.length++] = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+/**
+ * nwBinaryGet:
+ * @frame: the frame.
+ * @offset: the offset of the value in the payload.
+ * @size: the size of the value.
+ *
+ * Returns: the little-endian unsigned value read from the payload, or
+ * zero if the payload is too short.
+ */
+unsigned long nwBinaryGet( nwFrame &frame, byte offset, byte size )
+{
+	unsigned long value = 0;
+
+	if( offset+size > frame.length ){
+		return( 0 );
+	}
+	for( byte i=size ; i>0 ; --i ){
+		value = ( value << 8 ) | frame.payload[offset+i-1];
+	}
+	return( value );
+}
@@ -0,0 +1,151 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWBINARY_H__
+#define __NWBINARY_H__
+
+/* The binary protocol
+ *
+ * It is negotiated by the 'SET PROTOCOL BINARY' text command, and left
+ * by sending a NW_BIN_OP_TEXT frame.
+ *
+ * Each frame is:
+ *
+ *  offset  size  content
+ *  ------  ----  -----------------------------------------------------
+ *       0     1  NW_BIN_SOF start-of-frame marker
+ *       1     1  opcode
+ *       2     1  payload length (max NW_BIN_MAX_PAYLOAD)
+ *       3     n  payload
+ *     3+n     1  CRC-8 (polynomial 0x07) of opcode, length and payload
+ *
+ * Multi-bytes values are sent as little-endian unsigned integers.
+ *
+ * The board answers each request frame with a reply frame whose opcode
+ * is the request opcode or'ed with NW_BIN_OP_REPLY, and whose first
+ * payload byte is a NW_BIN_STATUS_xxx status code. EEPROM DUMP request
+ * sends one NW_BIN_OP_EVENT frame per stored event before its reply.
+ * A frame which cannot be decoded is answered with a NW_BIN_OP_ERROR
+ * frame.
+ * A NW_HEARTBEAT byte received outside of a frame is returned as a
+ * NW_BIN_OP_HEARTBEAT pseudo-frame, and answered with a single byte.
+ * When enabled, the asynchronous notifications are sent as NOTIFY
+ * frames, between the replies (see nwNotify.h).
+ *
+ * Request       payload
+ * ------------  ------------------------------------------------------
+ * PING          -, or channel (1), optionally followed by the current
+ *               UTC date (4, see nwClock.h)
+ * STATUS        -
+ * REBOOT        reason (1), optionally followed by the channel whose
+ *               target is to be reset (1, see nwTarget.h)
+ * ACKNOWLEDGE   index (1)
+ * EEPROM DUMP   -
+ * NOOP          -
+ * PERF          -, or reset (1, non-zero to reset the counters once
+ *               sent)
+ * TEXT          -
+ *
+ * Reply         payload
+ * ------------  ------------------------------------------------------
+ * STATUS        status (1), flags (1, see NW_BIN_FLAG_xxx), delay (2,
+ *               sec.), seconds left before the soonest deadline (4,
+ *               signed), now (4), last reset event time (4), last
+ *               reset event ack_reason (1, see nwEventStr), delay (4,
+ *               ms), milliseconds left before the soonest deadline (4,
+ *               signed), status sequence number (4), startup number
+ *               (2, see STATUS SINCE); the delays are those of the
+ *               channel 0
+ * EEPROM DUMP   status (1), count of reset events (1)
+ * PERF          status (1), loop() iterations (4), max iteration (4,
+ *               us), average iteration (2, us), rx full (2), dropped
+ *               rx bytes (2), bad frames (2), min free RAM (2, bytes,
+ *               0xFFFF if unknown), EEPROM written bytes (4), min
+ *               margin (4, ms, 0xFFFFFFFF if none), channel of the min
+ *               margin (1), commands (4); the 2-bytes values are
+ *               saturated (see nwPerf.h)
+ * others        status (1)
+ *
+ * EVENT         index (1, 0xFF for the initialization event), time (4),
+ *               ack_reason (1)
+ * ERROR         status (1), request opcode (1)
+ * NOTIFY        code (1, see NW_NOTIFY_xxx), channel (1, 0xFF if none),
+ *               value (4)
+ */
+
+#define NW_BIN_SOF               0xA5
+#define NW_BIN_MAX_PAYLOAD       32
+#define NW_BIN_TIMEOUT           100	/* max ms between two bytes of a frame */
+
+enum {
+	NW_BIN_OP_PING           = 0x01,
+	NW_BIN_OP_STATUS         = 0x02,
+	NW_BIN_OP_REBOOT         = 0x03,
+	NW_BIN_OP_ACKNOWLEDGE    = 0x04,
+	NW_BIN_OP_EEPROM_DUMP    = 0x05,
+	NW_BIN_OP_NOOP           = 0x06,
+	NW_BIN_OP_PERF           = 0x07,
+	NW_BIN_OP_HEARTBEAT      = 0x0E,	/* not sent on the line */
+	NW_BIN_OP_TEXT           = 0x0F,
+	NW_BIN_OP_EVENT          = 0x10,
+	NW_BIN_OP_NOTIFY         = 0x11,
+	NW_BIN_OP_REPLY          = 0x80,
+	NW_BIN_OP_ERROR          = 0xFF
+};
+
+enum {
+	NW_BIN_STATUS_OK         = 0,
+	NW_BIN_STATUS_INVALID,
+	NW_BIN_STATUS_CRC
+};
+
+enum {
+	NW_BIN_FLAG_TEST         = 1 << 0,
+	NW_BIN_FLAG_DATE_SET     = 1 << 1,
+	NW_BIN_FLAG_STARTED      = 1 << 2,
+	NW_BIN_FLAG_RESET        = 1 << 3
+};
+
+struct nwFrame {
+	byte opcode;
+	byte length;
+	byte payload[NW_BIN_MAX_PAYLOAD];
+};
+
+/* compute the CRC-8 */
+byte          nwCrc8      ( byte crc, byte data );
+
+/* read a frame from Serial without blocking
+ * returns true when a full frame has been received, @frame being left
+ * untouched until then */
+bool          nwBinaryRead( nwFrame &frame );
+
+/* send a frame to Serial */
+void          nwBinaryWrite( nwFrame &frame );
+
+/* pack and unpack little-endian values into the frame payload */
+void          nwBinaryPut ( nwFrame &frame, unsigned long value, byte size );
+unsigned long nwBinaryGet ( nwFrame &frame, byte offset, byte size );
+
+#endif /* __NWBINARY_H__ */
@@ -0,0 +1,319 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+/* the stages of the delay, as percentages, the last one being the
+ * deadline itself */
+static const byte    st_stages[] = { 50, 75, 90, 100 };
+
+#define NW_STAGE_COUNT           sizeof( st_stages )
+#define NW_STAGE_EXPIRED         NW_STAGE_COUNT
+
+/* a watchdog channel
+ * lastPing is the millis() of the last ping, or of the start
+ * stage is the index of the next stage to be reached, NW_STAGE_EXPIRED
+ * once the deadline has been reached
+ * grace is added to the delay until the first ping after the start
+ */
+struct nwChannelStr {
+	bool          started;
+	byte          stage;
+	unsigned long lastPing;
+	unsigned long delay;
+	unsigned long grace;
+};
+
+static nwChannelStr  st_channels[NW_MAX_CHANNEL];
+
+/* the started channel with the soonest stage, and the millis() of this
+ * stage */
+static byte          st_next = NW_CHANNEL_NONE;
+static unsigned long st_nextAt = 0;
+
+/*
+ * nwChannelDeadline:
+ * @channel: the channel number.
+ *
+ * Returns: the ms from the last ping at which the deadline is reached,
+ *  i.e. the delay, plus the grace period if any.
+ */
+static unsigned long nwChannelDeadline( byte channel )
+{
+	return( st_channels[channel].delay+st_channels[channel].grace );
+}
+
+/*
+ * nwChannelStageAt:
+ * @channel: the channel number.
+ * @stage: the index of the stage.
+ *
+ * Returns: the ms from the last ping at which the stage is reached.
+ *  This is computed from the remaining percentage, by hundredths so
+ *  that it doesn't overflow with the max delay plus a grace period.
+ */
+static unsigned long nwChannelStageAt( byte channel, byte stage )
+{
+	unsigned long deadline = nwChannelDeadline( channel );
+	byte remain = 100-st_stages[stage];
+	return( deadline - deadline/100*remain - deadline%100*remain/100 );
+}
+
+/*
+ * nwChannelUpdate:
+ *
+ * Find the started channel which has the soonest stage to be reached.
+ * The stages are compared on their signed difference with now, so that
+ * this keeps right when millis() rolls over.
+ */
+static void nwChannelUpdate()
+{
+	unsigned long tnow = millis();
+	long best = 0;
+
+	st_next = NW_CHANNEL_NONE;
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		if( st_channels[i].started && st_channels[i].stage < NW_STAGE_EXPIRED ){
+			unsigned long at = st_channels[i].lastPing + nwChannelStageAt( i, st_channels[i].stage );
+			long left = ( long )( at - tnow );
+			if( st_next == NW_CHANNEL_NONE || left < best ){
+				best = left;
+				st_next = i;
+				st_nextAt = at;
+			}
+		}
+	}
+}
+
+/**
+ * nwChannelSetup:
+ * @delay: the default reset delay (ms).
+ *
+ * Stop all the channels, and set their reset delay.
+ */
+void nwChannelSetup( unsigned long delay )
+{
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		st_channels[i].started = false;
+		st_channels[i].stage = 0;
+		st_channels[i].lastPing = 0;
+		st_channels[i].delay = delay;
+		st_channels[i].grace = 0;
+	}
+	st_next = NW_CHANNEL_NONE;
+}
+
+/**
+ * nwChannelStart:
+ * @channel: the channel number.
+ * @grace: the grace period (ms).
+ *
+ * Start the channel, its deadline being its delay plus the grace
+ * period from now; the grace period ends with the first ping.
+ * Idempotent if the channel is already started.
+ */
+void nwChannelStart( byte channel, unsigned long grace )
+{
+	if( !st_channels[channel].started ){
+		st_channels[channel].started = true;
+		st_channels[channel].stage = 0;
+		st_channels[channel].lastPing = millis();
+		st_channels[channel].grace = grace;
+		nwChannelUpdate();
+	}
+}
+
+/**
+ * nwChannelStop:
+ * @channel: the channel number.
+ *
+ * Stop the channel.
+ * Idempotent if the channel is not started.
+ */
+void nwChannelStop( byte channel )
+{
+	if( st_channels[channel].started ){
+		st_channels[channel].started = false;
+		nwChannelUpdate();
+	}
+}
+
+/**
+ * nwChannelPing:
+ * @channel: the channel number.
+ *
+ * Push the deadline of the channel.
+ * As a ping only delays the stages of the channel, the soonest stage
+ * has only to be searched for again when pinging the channel which
+ * held it, or when the channel had already expired.
+ */
+void nwChannelPing( byte channel )
+{
+	if( st_channels[channel].started ){
+		bool expired = ( st_channels[channel].stage == NW_STAGE_EXPIRED );
+		nwPerfMargin( channel, nwChannelLeft( channel ));
+		st_channels[channel].lastPing = millis();
+		st_channels[channel].stage = 0;
+		st_channels[channel].grace = 0;
+		if( channel == st_next || expired ){
+			nwChannelUpdate();
+		}
+	}
+}
+
+/**
+ * nwChannelDelaySet:
+ * @channel: the channel number.
+ * @delay: the reset delay (ms).
+ *
+ * Set the reset delay of the channel, which applies to its current
+ * deadline if it is started: the stages already passed with the new
+ * delay are skipped, but the deadline itself.
+ */
+void nwChannelDelaySet( byte channel, unsigned long delay )
+{
+	st_channels[channel].delay = delay;
+	if( st_channels[channel].started ){
+		unsigned long since = nwChannelSince( channel );
+		byte stage = 0;
+		while( stage < NW_STAGE_EXPIRED-1 && since >= nwChannelStageAt( channel, stage )){
+			stage += 1;
+		}
+		st_channels[channel].stage = stage;
+		nwChannelUpdate();
+	}
+}
+
+/**
+ * nwChannelDelayGet:
+ * @channel: the channel number.
+ *
+ * Returns: the reset delay of the channel (ms).
+ */
+unsigned long nwChannelDelayGet( byte channel )
+{
+	return( st_channels[channel].delay );
+}
+
+/**
+ * nwChannelIsStarted:
+ * @channel: the channel number.
+ *
+ * Returns: whether the channel is started.
+ */
+bool nwChannelIsStarted( byte channel )
+{
+	return( st_channels[channel].started );
+}
+
+/**
+ * nwChannelCount:
+ *
+ * Returns: the count of started channels.
+ */
+byte nwChannelCount()
+{
+	byte count = 0;
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		if( st_channels[i].started ){
+			count += 1;
+		}
+	}
+	return( count );
+}
+
+/**
+ * nwChannelSince:
+ * @channel: the channel number.
+ *
+ * Returns: the count of ms since the last ping of the channel.
+ */
+unsigned long nwChannelSince( byte channel )
+{
+	return( millis()-st_channels[channel].lastPing );
+}
+
+/**
+ * nwChannelLeft:
+ * @channel: the channel number.
+ *
+ * Returns: the count of ms left before the deadline of the channel, or
+ *  zero if it is expired.
+ */
+unsigned long nwChannelLeft( byte channel )
+{
+	unsigned long since = nwChannelSince( channel );
+	unsigned long deadline = nwChannelDeadline( channel );
+	return( since < deadline ? deadline-since : 0 );
+}
+
+/**
+ * nwChannelLeftMin:
+ *
+ * Returns: the count of ms left before the soonest deadline of the
+ *  started channels, or zero if no channel is started.
+ */
+unsigned long nwChannelLeftMin()
+{
+	unsigned long left = 0;
+	bool found = false;
+
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		if( st_channels[i].started ){
+			unsigned long chleft = nwChannelLeft( i );
+			if( !found || chleft < left ){
+				left = chleft;
+				found = true;
+			}
+		}
+	}
+	return( left );
+}
+
+/**
+ * nwChannelRun:
+ * @percent: [out] the reached stage, as a percentage of the delay.
+ *
+ * Only compares the soonest stage with now.
+ * A channel which has reached its deadline (100%) is left started, but
+ * doesn't reach any other stage until it is pinged.
+ *
+ * Returns: the started channel which has just reached a stage, or
+ *  NW_CHANNEL_NONE.
+ */
+byte nwChannelRun( byte *percent )
+{
+	byte channel = st_next;
+
+	if( channel != NW_CHANNEL_NONE && ( long )( millis()-st_nextAt ) >= 0 ){
+		*percent = st_stages[st_channels[channel].stage];
+		st_channels[channel].stage += 1;
+		if( *percent == 100 ){
+			nwPerfMargin( channel, 0 );
+		}
+		nwChannelUpdate();
+		return( channel );
+	}
+	return( NW_CHANNEL_NONE );
+}
@@ -0,0 +1,86 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWCHANNEL_H__
+#define __NWCHANNEL_H__
+
+/* The watchdog channels
+ *
+ * Each channel is started, pinged and stopped independently, and has
+ * its own reset delay, so that several host processes may each ping
+ * their own channel. The PC is reset as soon as one started channel
+ * has not been pinged in time.
+ *
+ * Besides its deadline, the time elapsed since the last ping of a
+ * channel goes through 50, 75 and 90% of its delay, so that the host
+ * may be notified of a near-miss.
+ * The channel with the soonest of these stages is maintained each time
+ * a channel changes, so that checking the stages from loop() doesn't
+ * need to scan the channels.
+ *
+ * Channel 0 is the default channel of the commands which accept an
+ * optional channel number.
+ */
+#define NW_MAX_CHANNEL           4	/* at most 4, see nwTarget.h */
+#define NW_CHANNEL_NONE          0xFF
+
+/* set the reset delay (ms) of all channels, which are all stopped */
+void          nwChannelSetup     ( unsigned long delay );
+
+/* start the channel, reinitializing its deadline; idempotent
+ * the first deadline may be pushed by a grace period (ms), which ends
+ * with the first ping */
+void          nwChannelStart     ( byte channel, unsigned long grace=0 );
+
+/* stop the channel; idempotent */
+void          nwChannelStop      ( byte channel );
+
+/* push the deadline of the channel if it is started */
+void          nwChannelPing      ( byte channel );
+
+/* the reset delay (ms) of the channel */
+void          nwChannelDelaySet  ( byte channel, unsigned long delay );
+unsigned long nwChannelDelayGet  ( byte channel );
+
+/* whether the channel is started */
+bool          nwChannelIsStarted ( byte channel );
+
+/* the count of started channels */
+byte          nwChannelCount     ();
+
+/* the ms elapsed since the last ping of the channel */
+unsigned long nwChannelSince     ( byte channel );
+
+/* the ms left before the deadline of the channel (0 if expired) */
+unsigned long nwChannelLeft      ( byte channel );
+
+/* the ms left before the soonest deadline of the started channels */
+unsigned long nwChannelLeftMin   ();
+
+/* the started channel which has just reached a stage of its delay, and
+ * this stage as a percentage (100 when it has expired), or
+ * NW_CHANNEL_NONE; is to be called from loop() until NW_CHANNEL_NONE */
+byte          nwChannelRun       ( byte *percent );
+
+#endif /* __NWCHANNEL_H__ */
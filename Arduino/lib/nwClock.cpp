@@ -0,0 +1,130 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+static bool          st_hasRef = false;
+static time_t        st_refDate = 0;		/* host date of the reference synchronization */
+static unsigned long st_refMs = 0;			/* millis() of the reference synchronization */
+static unsigned long st_syncMs = 0;			/* millis() of the last synchronization */
+static long          st_applied = 0;		/* correction applied since then (sec.) */
+static bool          st_hasDrift = false;
+static long          st_drift = 0;			/* the drift estimate (ppm) */
+static unsigned long st_runMs = 0;			/* millis() of the last correction check */
+
+/**
+ * nwClockSet:
+ * @date: the host date.
+ *
+ * Set the date, and restart the reference synchronization.
+ */
+void nwClockSet( time_t date )
+{
+	setTime( date );
+	st_hasRef = true;
+	st_refDate = date;
+	st_refMs = millis();
+	st_syncMs = st_refMs;
+	st_applied = 0;
+}
+
+/**
+ * nwClockSync:
+ * @date: the host date.
+ *
+ * Synchronize the date with the host, and update the drift estimate
+ * when the reference is old enough.
+ */
+void nwClockSync( time_t date )
+{
+	unsigned long ms = millis();
+	unsigned long elapsed = ms-st_refMs;
+	long error = ( long ) date-( long ) now();
+
+	if( !st_hasRef || elapsed > 0x7FFFFFFFUL || labs( error ) > NW_CLOCK_MAX_STEP ){
+		nwClockSet( date );
+		return;
+	}
+	if( elapsed >= NW_CLOCK_MIN_BASE*1000UL ){
+		int64_t drift = (( int64_t )( date-st_refDate )*1000-( int64_t ) elapsed )*1000000/( int64_t ) elapsed;
+		if( drift > NW_CLOCK_MAX_DRIFT || drift < -NW_CLOCK_MAX_DRIFT ){
+			nwClockSet( date );
+			return;
+		}
+		st_drift = ( long ) drift;
+		st_hasDrift = true;
+	}
+	if( error ){
+		adjustTime( error );
+	}
+	st_syncMs = ms;
+	st_applied = 0;
+}
+
+/**
+ * nwClockRun:
+ *
+ * Once per second, apply the drift correction which is due since the
+ * last synchronization, rounded to the nearest second.
+ */
+void nwClockRun()
+{
+	unsigned long ms = millis();
+
+	if( !st_hasRef || !st_hasDrift || ms-st_runMs < 1000 ){
+		return;
+	}
+	st_runMs = ms;
+	int64_t correction = ( int64_t )( ms-st_syncMs )*st_drift/1000000;
+	long due = ( long )(( correction+( correction < 0 ? -500 : 500 ))/1000 );
+	if( due != st_applied ){
+		adjustTime( due-st_applied );
+		st_applied = due;
+	}
+}
+
+/**
+ * nwClockDriftGet:
+ * @ppm: [out] the drift estimate.
+ *
+ * Returns: true if the drift has been estimated, false else.
+ */
+bool nwClockDriftGet( long *ppm )
+{
+	*ppm = st_drift;
+	return( st_hasDrift );
+}
+
+/**
+ * nwClockDriftSet:
+ * @ppm: the drift estimate.
+ *
+ * Restore the drift estimate, e.g. after a reset of the board by its
+ * own watchdog timer.
+ */
+void nwClockDriftSet( long ppm )
+{
+	st_drift = ppm;
+	st_hasDrift = true;
+}
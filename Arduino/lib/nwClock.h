@@ -0,0 +1,68 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWCLOCK_H__
+#define __NWCLOCK_H__
+
+/* The clock synchronization
+ *
+ * The date of the board is set by the host, either with the
+ * 'SET DATE <time>' command, or on each ping with the optional form
+ * 'PING [<channel>] <time>'; between two synchronizations, the date is
+ * driven by millis(), i.e. by the ceramic resonator of the Nano, whose
+ * frequency may be off by up to 0.5%, i.e. several minutes a day.
+ *
+ * The clock keeps so a reference synchronization: each following one
+ * compares the elapsed host time to the elapsed millis(), and, once the
+ * two are at least NW_CLOCK_MIN_BASE apart, updates the estimated drift
+ * of the resonator, in ppm (a positive drift meaning that the board
+ * clock runs slow). nwClockRun() then corrects the date by whole
+ * seconds between the synchronizations, so that the date of a reset
+ * event is still accurate to the second when the host has stopped
+ * pinging for a while.
+ *
+ * A host date which is more than NW_CLOCK_MAX_STEP off the corrected
+ * board date, or a drift greater than NW_CLOCK_MAX_DRIFT, is taken as a
+ * step of the host clock: the date is set, and the reference restarts,
+ * the current drift estimate being kept.
+ */
+#define NW_CLOCK_MIN_DATE	1000000000L		/* min. host date, 2001-09-09 */
+#define NW_CLOCK_MIN_BASE	600				/* min. reference base (sec.) */
+#define NW_CLOCK_MAX_STEP	60				/* max. error of a synchronization (sec.) */
+#define NW_CLOCK_MAX_DRIFT	20000			/* max. drift (ppm) */
+
+/* set the date, restarting the reference */
+void nwClockSet     ( time_t date );
+
+/* synchronize the date, updating the drift estimate */
+void nwClockSync    ( time_t date );
+
+/* to be called on each loop() iteration */
+void nwClockRun     ();
+
+/* the drift estimate (ppm), false if not known yet */
+bool nwClockDriftGet( long *ppm );
+void nwClockDriftSet( long ppm );
+
+#endif /* __NWCLOCK_H__ */
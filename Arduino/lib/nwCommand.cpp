@@ -0,0 +1,268 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+static byte nwCommandFind ( const char *command, nwCommand *cmd, nwArg *arg );
+static bool nwCommandParse( const char *args, const nwCommand &cmd, nwArg *arg );
+
+/* the commands table, and the index of the first command of each letter
+ * (NW_COMMAND_NONE if no command starts with this letter) */
+#define NW_COMMAND_NONE          0xFF
+
+static const nwCommand *nwCommands = NULL;
+static byte             nwCommandCount = 0;
+static byte             nwCommandFirst['Z'-'A'+1];
+
+/**
+ * nwCommandSetup:
+ * @table: the commands table, in Flash memory.
+ * @count: the count of commands in the table.
+ *
+ * Index the commands table by first letter, so that looking for a
+ * command only compares it with the commands which share its first
+ * letter: the table must be grouped by first letter.
+ */
+void nwCommandSetup( const nwCommand *table, byte count )
+{
+	nwCommands = table;
+	nwCommandCount = count;
+	memset( nwCommandFirst, NW_COMMAND_NONE, sizeof( nwCommandFirst ));
+	for( byte i=count ; i>0 ; --i ){
+		PGM_P name = ( PGM_P ) pgm_read_ptr( &table[i-1].name );
+		byte c = pgm_read_byte( name );
+		if( c >= 'A' && c <= 'Z' ){
+			nwCommandFirst[c-'A'] = i-1;
+		}
+	}
+}
+
+/**
+ * nwCommandFind:
+ * @command: the text command.
+ * @cmd: [out] the command, as found in the table.
+ * @arg: [out] the parsed argument.
+ *
+ * Look for the command in the table, and parse its argument.
+ *
+ * Returns: the index of the command in the table, or NW_COMMAND_NONE if
+ *  it is unknown or if its argument is invalid.
+ */
+static byte nwCommandFind( const char *command, nwCommand *cmd, nwArg *arg )
+{
+	byte c = command[0];
+
+	if( c < 'A' || c > 'Z' || nwCommandFirst[c-'A'] == NW_COMMAND_NONE ){
+		return( NW_COMMAND_NONE );
+	}
+	for( byte i=nwCommandFirst[c-'A'] ; i<nwCommandCount ; ++i ){
+		memcpy_P( cmd, &nwCommands[i], sizeof( *cmd ));
+		if( pgm_read_byte( cmd->name ) != c ){
+			break;
+		}
+		size_t len = strlen_P( cmd->name );
+		/* a command may be the prefix of another one (e.g. STATUS and
+		 * STATUS SINCE): go on with the next ones if the argument
+		 * doesn't fit */
+		if( !strncmp_P( command, cmd->name, len ) &&
+				( command[len] == '\0' || command[len] == ' ' ) &&
+				nwCommandParse( command+len, *cmd, arg )){
+			return( i );
+		}
+	}
+	return( NW_COMMAND_NONE );
+}
+
+/**
+ * nwCommandRun:
+ * @command: the text command.
+ *
+ * Look for the command in the table, parse its argument, and execute
+ * it.
+ *
+ * Returns: true if the command has been successfully executed, false
+ *  if it is unknown, if its argument is invalid, or if the handler has
+ *  failed.
+ */
+bool nwCommandRun( const char *command )
+{
+	nwCommand cmd;
+	nwArg arg;
+	byte i = nwCommandFind( command, &cmd, &arg );
+
+	if( i == NW_COMMAND_NONE ){
+		return( false );
+	}
+	nwPerfCommand( i );
+	return( cmd.handler( &arg ));
+}
+
+/**
+ * nwCommandIsValid:
+ * @command: the text command.
+ *
+ * Returns: true if the command is known and its argument is valid,
+ *  without executing it.
+ */
+bool nwCommandIsValid( const char *command )
+{
+	nwCommand cmd;
+	nwArg arg;
+
+	return( nwCommandFind( command, &cmd, &arg ) != NW_COMMAND_NONE );
+}
+
+/**
+ * nwCommandHelpLine:
+ * @index: the index of the command in the table.
+ *
+ * Display the help line of the command, as found in the table.
+ *
+ * Returns: true if the line has been displayed, false if the index is
+ *  out of the table.
+ */
+bool nwCommandHelpLine( byte index )
+{
+	if( index >= nwCommandCount ){
+		return( false );
+	}
+	nwCommand cmd;
+	memcpy_P( &cmd, &nwCommands[index], sizeof( cmd ));
+	size_t len = strlen_P( cmd.name );
+	Serial.print( " " );
+	Serial.print( FS( cmd.name ));
+	if( cmd.syntax ){
+		Serial.print( " " );
+		Serial.print( FS( cmd.syntax ));
+		len += 1+strlen_P( cmd.syntax );
+	}
+	do {
+		Serial.print( " " );
+	} while( ++len < 21 );
+	Serial.println( FS( cmd.help ));
+	return( true );
+}
+
+/**
+ * nwCommandCountGet:
+ *
+ * Returns: the count of commands in the table.
+ */
+byte nwCommandCountGet()
+{
+	return( nwCommandCount );
+}
+
+/**
+ * nwCommandName:
+ * @index: the index of the command in the table.
+ *
+ * Returns: the name of the command, in Flash memory.
+ */
+PGM_P nwCommandName( byte index )
+{
+	return(( PGM_P ) pgm_read_ptr( &nwCommands[index].name ));
+}
+
+/*
+ * nwCommandParse:
+ * @args: the rest of the command after the name, i.e. either an empty
+ *  string or a space followed by the argument, which may be preceded
+ *  by a channel number for NW_ARG_CHANNEL commands.
+ * @cmd: the command.
+ * @arg: [out] the parsed argument.
+ *
+ * Returns: true if the argument is valid for the command.
+ */
+static bool nwCommandParse( const char *args, const nwCommand &cmd, nwArg *arg )
+{
+	byte type = cmd.type & NW_ARG_TYPE;
+
+	arg->l = 0;
+	arg->l2 = 0;
+	arg->channel = NW_CHANNEL_NONE;
+	if(( cmd.type & NW_ARG_CHANNEL ) && args[0] == ' ' && isdigit( args[1] )){
+		char *end;
+		long channel = strtol( args+1, &end, 10 );
+		/* without a main argument, the channel is the whole argument;
+		 * else it is only present when followed by another word */
+		if(( type == NW_ARG_NONE && *end == '\0' ) || ( type != NW_ARG_NONE && *end == ' ' )){
+			if( channel >= NW_MAX_CHANNEL ){
+				return( false );
+			}
+			arg->channel = channel;
+			args = end;
+		}
+	}
+	if( type == NW_ARG_NONE ){
+		return( args[0] == '\0' );
+	}
+	if( args[0] != ' ' ){
+		return( false );
+	}
+	args += 1;
+	if( type == NW_ARG_LONG ){
+		return( nwStrToLong( args, &arg->l ) && arg->l >= cmd.min && arg->l <= cmd.max );
+	}
+	if( type == NW_ARG_BOOL ){
+		if( !strcmp_P( args, PSTR( "ON" ))){
+			arg->l = 1;
+			return( true );
+		}
+		return( !strcmp_P( args, PSTR( "OFF" )));
+	}
+	if( type == NW_ARG_DELAY ){
+		char *end;
+		if( !isdigit( args[0] )){
+			return( false );
+		}
+		arg->l = strtol( args, &end, 10 );
+		if( *end == '\0' ){
+			if( arg->l > cmd.max/1000 ){
+				return( false );
+			}
+			arg->l *= 1000;
+		} else if( strcmp_P( end, PSTR( "ms" ))){
+			return( false );
+		}
+		return( arg->l >= cmd.min && arg->l <= cmd.max );
+	}
+	if( type == NW_ARG_PAIR || type == NW_ARG_RANGE ){
+		char sep = ( type == NW_ARG_PAIR ) ? ' ' : '-';
+		char *end;
+		if( !isdigit( args[0] )){
+			return( false );
+		}
+		arg->l = strtol( args, &end, 10 );
+		if( *end != sep || !isdigit( end[1] )){
+			return( false );
+		}
+		arg->l2 = strtol( end+1, &end, 10 );
+		return( *end == '\0' &&
+				arg->l >= cmd.min && arg->l <= cmd.max &&
+				arg->l2 >= cmd.min && arg->l2 <= cmd.max &&
+				( type == NW_ARG_PAIR || arg->l <= arg->l2 ));
+	}
+	return( false );
+}
@@ -0,0 +1,103 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWCOMMAND_H__
+#define __NWCOMMAND_H__
+
+#include "nwProfile.h"
+
+/* the type of the argument of a text command */
+enum {
+	NW_ARG_NONE = 0,					/* no argument */
+	NW_ARG_LONG,						/* an integer in the [min..max] range */
+	NW_ARG_BOOL,						/* ON or OFF */
+	NW_ARG_DELAY,						/* a count of seconds, or of milliseconds with
+										   a 'ms' suffix, in the [min..max] ms range */
+	NW_ARG_PAIR,						/* two space-separated integers, each in the
+										   [min..max] range */
+	NW_ARG_RANGE,						/* '<from>-<to>' integers in the [min..max]
+										   range, from being not greater than to */
+	NW_ARG_TYPE             = 0x0F,		/* mask of the above */
+	NW_ARG_CHANNEL          = 0x10		/* or'ed with the above: the argument may be
+										   preceded by a channel number */
+};
+
+/* the parsed argument of a text command */
+struct nwArg {
+	long l;								/* NW_ARG_LONG value, 0/1 for NW_ARG_BOOL,
+										   milliseconds for NW_ARG_DELAY, first
+										   value for NW_ARG_PAIR and NW_ARG_RANGE */
+	long l2;							/* second value for NW_ARG_PAIR and
+										   NW_ARG_RANGE */
+	byte channel;						/* with NW_ARG_CHANNEL, the channel number,
+										   or NW_CHANNEL_NONE if not specified */
+};
+
+/* a command handler
+ * @arg is NULL when the handler is called outside of the text protocol */
+typedef bool ( *nwCommandHandler )( const nwArg *arg );
+
+/* a text command, as it is described in the commands table (which lives
+ * in Flash memory)
+ * name is the keyword(s) of the command, e.g. "SET DELAY"; syntax is the
+ * synopsis of the argument as displayed by HELP, or NULL */
+struct nwCommand {
+	PGM_P            name;
+	byte             type;
+	long             min;
+	long             max;
+	nwCommandHandler handler;
+	PGM_P            syntax;
+	PGM_P            help;
+};
+
+/* the syntax and the help texts of the commands, which are only
+ * compiled in with the HELP command (see nwProfile.h), e.g.
+ * static const PROGMEM char cmdNoopHelp[] = NW_HELP( "do nothing" ); */
+#if NW_PROFILE_HELP
+#define NW_HELP( text )			text
+#else
+#define NW_HELP( text )			""
+#endif
+
+/* index the commands table, which must be grouped by first letter */
+void nwCommandSetup( const nwCommand *table, byte count );
+
+/* find, parse and execute a text command
+ * returns false if the command is unknown or invalid */
+bool nwCommandRun( const char *command );
+
+/* whether the command is known and its argument valid, without
+ * executing it */
+bool nwCommandIsValid( const char *command );
+
+/* display the HELP line of the index-th command, as generated from the
+ * table; returns false if there is no such command */
+bool nwCommandHelpLine( byte index );
+
+/* the count of commands in the table, and the name of the index-th one */
+byte  nwCommandCountGet();
+PGM_P nwCommandName( byte index );
+
+#endif /* __NWCOMMAND_H__ */
@@ -24,6 +24,210 @@
 
 #include "NanoWatchdog.h"
 
+static void     nwLegacyConvert( int count );
+static byte     nwRegion( int adr );
+static int      nwResetSlot( int index );
+static int      nwResetSlotAdr( int slot );
+static uint16_t nwResetSeqNext( uint16_t seq );
+static uint32_t nwResetLogIdNext( uint32_t logid );
+static byte     nwResetTargetGet( int slot );
+static void     nwResetTargetSet( int slot, byte target );
+static void     nwResetTargetClear();
+
+/* the reset log state, loaded by nwEEPROMSetup() */
+static int      nwResetHead  = -1;		/* slot of the most recent event, -1 if empty */
+static uint16_t nwResetSeq   = 0;		/* sequence number of the most recent event */
+static int      nwResetCount = 0;		/* count of stored events */
+static uint32_t nwResetLogId = 0;		/* identifier of the reset log */
+static uint16_t nwBootCount  = 0;		/* count of startups */
+static byte     nwFirmwareId = 0;		/* identifier of the running firmware */
+
+/* the write counters since startup, by region */
+static unsigned long nwWriteCount[NW_EEPROM_REGION_COUNT];	/* written bytes */
+static unsigned long nwSkipCount[NW_EEPROM_REGION_COUNT];	/* unchanged bytes */
+
+static const PROGMEM char nwRegionHeader[] = "header";
+static const PROGMEM char nwRegionInit[]   = "init event";
+static const PROGMEM char nwRegionReset[]  = "reset log";
+static const PROGMEM char nwRegionTarget[] = "reset targets";
+static const PROGMEM char nwRegionUnused[] = "unused";
+static const PROGMEM char nwRegionConfig[] = "config";
+
+static const PROGMEM char * const nwRegionNames[] = {
+	nwRegionHeader,
+	nwRegionInit,
+	nwRegionReset,
+	nwRegionTarget,
+	nwRegionUnused,
+	nwRegionConfig
+};
+
+/**
+ * nwEEPROMWrite:
+ * @adr: the write address in the EEPROM (counted from zero).
+ * @data: the data to be written.
+ * @size: the size of the data.
+ *
+ * Writes the data, only actually writing the bytes which change: an
+ * EEPROM write costs 3.3 ms and some wear, while a read is almost free.
+ * The watchdog timer is kicked after each actual write, so that a full
+ * rewrite of the EEPROM doesn't exceed its period.
+ */
+void nwEEPROMWrite( int adr, const void *data, int size )
+{
+	const byte *p = ( const byte * ) data;
+
+	for( int i=0 ; i<size ; ++i ){
+		byte region = nwRegion( adr+i );
+		if( EEPROM.read( adr+i ) != p[i] ){
+			EEPROM.write( adr+i, p[i] );
+			nwWriteCount[region] += 1;
+			nwWdtKick();
+		} else {
+			nwSkipCount[region] += 1;
+		}
+	}
+}
+
+/**
+ * nwEEPROMClear:
+ *
+ * Reset the whole EEPROM content to zero.
+ */
+void nwEEPROMClear()
+{
+	const byte zero = 0;
+
+	for( int i=0 ; i<EEPROM_SIZE ; ++i ){
+		nwEEPROMWrite( i, &zero, sizeof( zero ));
+	}
+}
+
+/**
+ * nwEEPROMRegionName:
+ * @region: the region.
+ *
+ * Returns: the name of the region, as a string in Flash memory.
+ */
+PGM_P nwEEPROMRegionName( byte region )
+{
+	return(( PGM_P ) pgm_read_ptr( nwRegionNames+region ));
+}
+
+/**
+ * nwEEPROMWriteCountGet:
+ * @region: the region.
+ *
+ * Returns: the count of bytes written in the region since startup.
+ */
+unsigned long nwEEPROMWriteCountGet( byte region )
+{
+	return( nwWriteCount[region] );
+}
+
+/**
+ * nwEEPROMSkipCountGet:
+ * @region: the region.
+ *
+ * Returns: the count of bytes which were not written in the region
+ *  since startup, because they were unchanged.
+ */
+unsigned long nwEEPROMSkipCountGet( byte region )
+{
+	return( nwSkipCount[region] );
+}
+
+/**
+ * nwEEPROMBaudRateGet:
+ *
+ * Returns: the stored serial baud rate, or NW_DEFAULT_BAUD if no valid
+ *  rate has been stored.
+ */
+long nwEEPROMBaudRateGet()
+{
+	long rate;
+
+	EEPROM.get( nwBaudRateAdr, rate );
+
+	return( nwBaudRateIsValid( rate ) ? rate : NW_DEFAULT_BAUD );
+}
+
+/**
+ * nwEEPROMBaudRateSet:
+ * @rate: the serial baud rate.
+ *
+ * Stores the serial baud rate to be used at startup.
+ */
+void nwEEPROMBaudRateSet( long rate )
+{
+	nwEEPROMPut( nwBaudRateAdr, rate );
+}
+
+/*
+ * nwConfigCrc:
+ * @config: the configuration.
+ *
+ * Returns: the CRC-8 of the configuration, but the crc field.
+ */
+static byte nwConfigCrc( const nwConfigStr &config )
+{
+	const byte *p = ( const byte * ) &config;
+	byte crc = 0;
+
+	for( int i=0 ; i<nwConfigStrSize-1 ; ++i ){
+		crc = nwCrc8( crc, p[i] );
+	}
+	return( crc );
+}
+
+/**
+ * nwEEPROMConfigGet:
+ * @config: [out] the configuration.
+ *
+ * Returns: true if a valid configuration has been read, false else.
+ */
+bool nwEEPROMConfigGet( nwConfigStr &config )
+{
+	EEPROM.get( nwConfigStrAdr, config );
+	return( config.layout == NW_CONFIG_LAYOUT && config.crc == nwConfigCrc( config ));
+}
+
+/**
+ * nwEEPROMConfigSet:
+ * @config: the configuration.
+ *
+ * Stores the configuration, setting its layout and its CRC.
+ */
+void nwEEPROMConfigSet( nwConfigStr &config )
+{
+	config.layout = NW_CONFIG_LAYOUT;
+	config.crc = nwConfigCrc( config );
+	nwEEPROMPut( nwConfigStrAdr, config );
+}
+
+/**
+ * nwEEPROMConfigClear:
+ *
+ * Invalidates the stored configuration; only the layout byte is
+ * rewritten.
+ */
+void nwEEPROMConfigClear()
+{
+	const byte zero = 0;
+	nwEEPROMWrite( nwConfigStrAdr+offsetof( nwConfigStr, layout ), &zero, sizeof( zero ));
+}
+
+/**
+ * nwEEPROMFirmwareId:
+ *
+ * Returns: the identifier of the running firmware, as written in the
+ *  events it stores.
+ */
+byte nwEEPROMFirmwareId()
+{
+	return( nwFirmwareId );
+}
+
 /**
  * nwEEPROMInitEventGet:
  *
@@ -33,7 +237,9 @@ nwEvent nwEEPROMInitEventGet()
 {
 	nwEvent ev;
 
-	ev.readFromEEPROM( nwInitEventAdr );
+	if( !ev.readFromEEPROM( nwInitEventAdr )){
+		ev.clear();
+	}
 
 	return( ev );
 }
@@ -45,6 +251,7 @@ nwEvent nwEEPROMInitEventGet()
  */
 void nwEEPROMInitEventSet( nwEvent &ev )
 {
+	ev.setSeq( 0 );
 	ev.writeToEEPROM( nwInitEventAdr );
 }
 
@@ -55,11 +262,7 @@ void nwEEPROMInitEventSet( nwEvent &ev )
  */
 int nwEEPROMResetEventCountGet()
 {
-    int count;
-
-    EEPROM.get( nwResetCountAdr, count );
-
-    return( count );
+    return( nwResetCount );
 }
 
 /**
@@ -68,13 +271,17 @@ int nwEEPROMResetEventCountGet()
  *  0 is the most recent reset event.
  *  Upper limit is NW_MAX_RESET_EVENT-1, which is the oldest kept event.
  *
- * Returns: the desired reset event as a newly allocated nwEvent object.
+ * Returns: the desired reset event as a newly allocated nwEvent object,
+ *  which is null if there is no such event, or if it is corrupted.
  */
 nwEvent nwEEPROMResetEventGet( int index )
 {
 	nwEvent ev;
 
-	ev.readFromEEPROM( nwResetEventAdr + index*nwEventStrSize );
+	if( index < 0 || index >= nwResetCount ||
+			!ev.readFromEEPROM( nwResetSlotAdr( nwResetSlot( index )), nwResetTargetGet( nwResetSlot( index )))){
+		ev.clear();
+	}
 
 	return( ev );
 }
@@ -87,38 +294,363 @@ nwEvent nwEEPROMResetEventGet( int index )
  */
 void nwEEPROMResetEventSet( nwEvent &ev, int index )
 {
-	ev.writeToEEPROM( nwResetEventAdr + index*nwEventStrSize );
+	if( index >= 0 && index < nwResetCount ){
+		nwResetTargetSet( nwResetSlot( index ), ev.getTarget());
+		ev.writeToEEPROM( nwResetSlotAdr( nwResetSlot( index )));
+	}
 }
 
 /**
- * nwEEPROMResetEventSetNew:
+ * nwEEPROMResetEventAcknowledge:
  * @index: the index of the desired reset event, counted from 0.
- *  0 is the most recent reset event.
- *  Upper limit is NW_MAX_RESET_EVENT-1, which is the oldest kept event.
  *
- * Writes the specified reset event at the given index, shifted previous
- * events accordingly.
- *
- * The reset events are stored from most recent to least recent in the
- * limit of NW_MAX_RESET_EVENT events.
- * In order to rightly store the last event, we have to shift the
- * previous one, maybe losing the last one.
- */
-void nwEEPROMResetEventSetNew( nwEvent &ev, int index )
-{
-	nwEvent ev_temp;
-    int count = nwEEPROMResetEventCountGet();
-    /* shift of one place to the bottom */
-    if( count == NW_MAX_RESET_EVENT ){
-        count -= 1;
-    }
-    for( int i=count ; i>0 ; --i ){
-        ev_temp = nwEEPROMResetEventGet( i-1 );
-        nwEEPROMResetEventSet( ev_temp, i );
-    }
-    /* write the most recent event */
-    nwEEPROMResetEventSet( ev, 0 );
-    /* update the counter */
-    count += 1;
-    EEPROM.put( nwResetCountAdr, count );
+ * Acknowledges the specified reset event: as the CRC leaves the
+ * acknowledgment indicator out, this only rewrites one byte.
+ *
+ * Returns: true if the index is valid, false else.
+ */
+bool nwEEPROMResetEventAcknowledge( int index )
+{
+	return( nwEEPROMResetEventAcknowledgeRange( index, index ));
+}
+
+/**
+ * nwEEPROMResetEventAcknowledgeRange:
+ * @from: the index of the most recent event to be acknowledged.
+ * @to: the index of the oldest event to be acknowledged.
+ *
+ * Acknowledges the specified reset events in one pass, the events which
+ * are already acknowledged being left untouched.
+ *
+ * Returns: true if the range is valid, false else.
+ */
+bool nwEEPROMResetEventAcknowledgeRange( int from, int to )
+{
+	if( from < 0 || from > to || to >= nwResetCount ){
+		return( false );
+	}
+	for( int i=from ; i<=to ; ++i ){
+		int adr = nwResetSlotAdr( nwResetSlot( i ))+offsetof( nwEventStr, ack_reason );
+		byte ack_reason;
+		EEPROM.get( adr, ack_reason );
+		if( !( ack_reason & B10000000 )){
+			ack_reason |= B10000000;
+			nwEEPROMPut( adr, ack_reason );
+		}
+	}
+	return( true );
+}
+
+/**
+ * nwEEPROMResetEventSeqGet:
+ *
+ * Returns: the sequence number of the most recent reset event, zero if
+ *  the reset log is empty.
+ */
+uint16_t nwEEPROMResetEventSeqGet()
+{
+	return( nwResetSeq );
+}
+
+/**
+ * nwEEPROMResetLogIdGet:
+ *
+ * Returns: the identifier of the run of sequence numbers of the reset
+ *  log (see nwHeaderStr).
+ */
+uint32_t nwEEPROMResetLogIdGet()
+{
+	return( nwResetLogId );
+}
+
+/**
+ * nwEEPROMResetEventSetNew:
+ *
+ * Writes the specified reset event as the most recent one.
+ *
+ * The event is written in the slot which follows the most recent
+ * event, maybe overwriting the oldest one: this costs one record
+ * write, whatever be the count of already stored events.
+ * The sequence number is written last, so that the slot only becomes
+ * the head of the log once the event is fully written; the target is
+ * written first.
+ * When the sequence numbers wrap, the identifier of the reset log is
+ * renewed before the event is written.
+ */
+void nwEEPROMResetEventSetNew( nwEvent &ev )
+{
+	int slot = ( nwResetHead+1 ) % NW_MAX_RESET_EVENT;
+	uint16_t seq = nwResetSeqNext( nwResetSeq );
+
+	if( seq < nwResetSeq ){
+		nwResetLogId = nwResetLogIdNext( nwResetLogId );
+		nwEEPROMPut( nwHeaderAdr+offsetof( nwHeaderStr, logid ), nwResetLogId );
+	}
+	ev.setSeq( seq );
+	nwResetTargetSet( slot, ev.getTarget());
+	ev.writeToEEPROM( nwResetSlotAdr( slot ));
+
+	nwResetHead = slot;
+	nwResetSeq = seq;
+	if( nwResetCount < NW_MAX_RESET_EVENT ){
+		nwResetCount += 1;
+	}
+}
+
+/**
+ * nwEEPROMSetup:
+ *
+ * Converts a legacy content to the current layout if needed, or
+ * reinitializes a content of another layout, records the running
+ * firmware in the header, then loads the reset log state (most recent
+ * slot, last sequence number and count of events).
+ * This must be called at startup, and each time the EEPROM content
+ * is reinitialized.
+ */
+void nwEEPROMSetup()
+{
+	nwHeaderStr header;
+	uint16_t seq;
+
+	EEPROM.get( nwHeaderAdr, header );
+
+	/* only a content without header may be a legacy one */
+	if( header.magic != NW_EEPROM_MAGIC ){
+		int count;
+		EEPROM.get( nwLegacyCountAdr, count );
+		if( count >= 0 && count <= NW_LEGACY_MAX_RESET_EVENT ){
+			nwLegacyConvert( count );
+		} else {
+			nwLegacyConvert( -1 );
+		}
+		EEPROM.get( nwHeaderAdr, header );
+	} else if( header.layout != NW_EEPROM_LAYOUT ){
+		nwLegacyConvert( -1 );
+		EEPROM.get( nwHeaderAdr, header );
+	}
+
+	/* a new firmware gets a new identifier */
+	if( strncmp_P( header.version, nwVersionString, nwVersionSize )){
+		header.fwid = ( header.fwid == 0xFF ) ? 1 : header.fwid+1;
+		strncpy_P( header.version, nwVersionString, nwVersionSize );
+		nwEEPROMPut( nwHeaderAdr, header );
+	}
+	nwFirmwareId = header.fwid;
+	nwResetLogId = header.logid;
+	nwBootCount = header.boots;
+
+	/* the most recent event is the last one of the run of consecutive
+	 * sequence numbers which starts at the first used slot */
+	nwResetHead = -1;
+	nwResetSeq = 0;
+	nwResetCount = 0;
+	for( int slot=0 ; slot<NW_MAX_RESET_EVENT ; ++slot ){
+		EEPROM.get( nwResetSlotAdr( slot )+offsetof( nwEventStr, seq ), seq );
+		if( seq == 0 ){
+			continue;
+		}
+		nwResetCount += 1;
+		if( nwResetHead < 0 || ( nwResetHead == slot-1 && seq == nwResetSeqNext( nwResetSeq ))){
+			nwResetHead = slot;
+			nwResetSeq = seq;
+		}
+	}
+}
+
+/**
+ * nwEEPROMBootNew:
+ *
+ * Counts a new startup of the board in the header; the count is kept
+ * when the EEPROM content is reinitialized.
+ * This must be called once at startup, after nwEEPROMSetup().
+ *
+ * Returns: the number of this startup.
+ */
+uint16_t nwEEPROMBootNew()
+{
+	nwBootCount += 1;
+	nwEEPROMPut( nwHeaderAdr+offsetof( nwHeaderStr, boots ), nwBootCount );
+	return( nwBootCount );
+}
+
+/*
+ * nwLegacyConvert:
+ * @count: the count of legacy reset events, -1 if there is no legacy
+ *  content at all.
+ *
+ * Converts a legacy EEPROM content to the current layout.
+ *
+ * The legacy events are first read in memory, the current layout
+ * overlapping the legacy one; they get the identifier of the running
+ * firmware if they have been written by it, and are marked as coming
+ * from an unknown firmware else.
+ * The header is written first, so that an interrupted conversion is
+ * not tried again on a partially overwritten legacy content; the
+ * reset events which would not have been written are then either
+ * empty or invalid. It gets a new reset log identifier, greater than
+ * the one of the previous content, if any, and keeps its count of
+ * startups.
+ */
+static void nwLegacyConvert( int count )
+{
+	nwEvent events[NW_LEGACY_MAX_RESET_EVENT+1];
+	nwLegacyEventStr legacy;
+	nwHeaderStr header;
+	uint16_t seq;
+	int n = 0;
+
+	/* the initialization event, then the reset events from the oldest
+	 * to the most recent, the oldest ones being dropped if the reset
+	 * log of the board profile is shorter */
+	for( int i=-1 ; i<count ; ++i ){
+		if( i >= 0 && i < count-NW_MAX_RESET_EVENT ){
+			continue;
+		}
+		int adr = ( i < 0 ) ? nwHeaderAdr : nwLegacyEventAdr + ( count-1-i )*nwLegacyEventStrSize;
+		EEPROM.get( adr, legacy );
+		events[n].set( legacy.time, legacy.ack_reason,
+				strncmp_P( legacy.version, nwVersionString, nwVersionSize ) ? 0 : 1 );
+		n += 1;
+	}
+
+	memset(( void * ) &header, '\0', sizeof( header ));
+	header.magic = NW_EEPROM_MAGIC;
+	header.layout = NW_EEPROM_LAYOUT;
+	header.fwid = 1;
+	strncpy_P( header.version, nwVersionString, nwVersionSize );
+	header.logid = nwResetLogIdNext( nwResetLogId );
+	header.boots = nwBootCount;
+	nwEEPROMPut( nwHeaderAdr, header );
+
+	seq = 0;
+	for( int slot=0 ; slot<NW_MAX_RESET_EVENT ; ++slot ){
+		nwEEPROMPut( nwResetSlotAdr( slot )+offsetof( nwEventStr, seq ), seq );
+	}
+	nwResetTargetClear();
+	for( int i=0 ; i<n ; ++i ){
+		if( i == 0 ){
+			events[i].setSeq( 0 );
+			events[i].writeToEEPROM( nwInitEventAdr );
+		} else {
+			events[i].setSeq( i );
+			events[i].writeToEEPROM( nwResetSlotAdr( i-1 ));
+		}
+	}
+}
+
+/*
+ * nwRegion:
+ * @adr: an EEPROM address.
+ *
+ * Returns: the region the address belongs to.
+ */
+static byte nwRegion( int adr )
+{
+	if( adr < nwInitEventAdr ){
+		return( NW_EEPROM_REGION_HEADER );
+	}
+	if( adr < nwResetEventAdr ){
+		return( NW_EEPROM_REGION_INIT );
+	}
+	if( adr < nwResetTargetAdr ){
+		return( NW_EEPROM_REGION_RESET );
+	}
+	if( adr < nwResetTargetAdr+nwResetTargetSize ){
+		return( NW_EEPROM_REGION_TARGET );
+	}
+	if( adr < nwConfigAdr ){
+		return( NW_EEPROM_REGION_UNUSED );
+	}
+	return( NW_EEPROM_REGION_CONFIG );
+}
+
+/*
+ * nwResetSlot:
+ * @index: the index of a stored reset event, 0 being the most recent.
+ *
+ * Returns: the slot of the reset event in the reset log.
+ */
+static int nwResetSlot( int index )
+{
+	return(( nwResetHead-index+NW_MAX_RESET_EVENT ) % NW_MAX_RESET_EVENT );
+}
+
+/*
+ * nwResetSlotAdr:
+ * @slot: a slot of the reset log.
+ *
+ * Returns: the EEPROM address of the slot.
+ */
+static int nwResetSlotAdr( int slot )
+{
+	return( nwResetEventAdr + slot*nwEventStrSize );
+}
+
+/*
+ * nwResetSeqNext:
+ * @seq: a sequence number.
+ *
+ * Returns: the next sequence number, skipping zero which marks an
+ *  empty slot.
+ */
+static uint16_t nwResetSeqNext( uint16_t seq )
+{
+	return( seq == 0xFFFF ? 1 : seq+1 );
+}
+
+/*
+ * nwResetLogIdNext:
+ * @logid: the identifier of the previous reset log, zero if none.
+ *
+ * Returns: the identifier of a new reset log, i.e. the current date,
+ *  but always greater than the previous identifier, as the date may
+ *  not have been set yet.
+ */
+static uint32_t nwResetLogIdNext( uint32_t logid )
+{
+	uint32_t date = now();
+
+	return( date > logid ? date : logid+1 );
+}
+
+/*
+ * nwResetTargetGet:
+ * @slot: a slot of the reset log.
+ *
+ * Returns: the reset target of the event of the slot.
+ */
+static byte nwResetTargetGet( int slot )
+{
+	return(( EEPROM.read( nwResetTargetAdr+slot/4 ) >> ( 2*( slot%4 ))) & 0x03 );
+}
+
+/*
+ * nwResetTargetSet:
+ * @slot: a slot of the reset log.
+ * @target: the reset target of the event of the slot.
+ *
+ * Writes the 2-bits target field of the slot.
+ */
+static void nwResetTargetSet( int slot, byte target )
+{
+	int adr = nwResetTargetAdr+slot/4;
+	byte shift = 2*( slot%4 );
+	byte value = EEPROM.read( adr );
+
+	value = ( value & ~( 0x03 << shift )) | (( target & 0x03 ) << shift );
+	nwEEPROMPut( adr, value );
+}
+
+/*
+ * nwResetTargetClear:
+ *
+ * Reset the targets of all the slots of the reset log to the first one.
+ */
+static void nwResetTargetClear()
+{
+	const byte zero = 0;
+
+	for( int i=0 ; i<nwResetTargetSize ; ++i ){
+		nwEEPROMWrite( nwResetTargetAdr+i, &zero, sizeof( zero ));
+	}
 }
@@ -23,7 +23,9 @@
  */
 
 #include <Time.h>           			/* to get the time_t definition */
+#include "nwChannel.h"
 #include "nwEvent.h"
+#include "nwProfile.h"
 
 #ifndef __NWEEPROM_H__
 #define __NWEEPROM_H__
@@ -34,41 +36,200 @@
  * - the acknowledgment boolean in b7
  * - the reason code in b6..b0 which actually limits the reason codes
  *   to 127.
+ * fwid identifies the firmware which has written the event (see
+ * nwHeaderStr), zero standing for an unknown firmware.
+ * seq is the sequence number of a reset event in the reset log, zero
+ * for an empty slot; it is written last.
+ * crc is the CRC-8 of the other fields, the acknowledgment bit being
+ * left out so that acknowledging an event only rewrites one byte.
  */
 struct nwEventStr {
-    char   version[nwVersionSize];		/* 32 */
-    time_t time;						/*  4 */
-    byte   ack_reason;					/*  1 */
+    uint32_t time;						/* 4 */
+    byte     ack_reason;				/* 1 */
+    byte     fwid;						/* 1 */
+    byte     crc;						/* 1 */
+    uint16_t seq;						/* 2 */
 };
 
 static const int nwEventStrSize = sizeof( nwEventStr );
 
+/* The EEPROM header.
+ * The version string is the one of the firmware identified by fwid,
+ * i.e. of the running firmware once nwEEPROMSetup() has been called.
+ * logid identifies the run of sequence numbers of the reset log: it is
+ * renewed when the EEPROM is initialized and when the sequence numbers
+ * wrap, so that a host which has synced the log up to a sequence number
+ * knows whether this one is still meaningful (see EEPROM READ SINCE).
+ * boots counts the startups of the board, so that a host knows whether
+ * the status sequence numbers have restarted (see STATUS SINCE).
+ */
+struct nwHeaderStr {
+    uint16_t magic;						/*  2 - NW_EEPROM_MAGIC */
+    byte     layout;					/*  1 - NW_EEPROM_LAYOUT */
+    byte     fwid;						/*  1 */
+    char     version[nwVersionSize];	/* 32 */
+    uint32_t logid;						/*  4 - time_t */
+    uint16_t boots;						/*  2 */
+};
+
+static const int nwHeaderStrSize = sizeof( nwHeaderStr );
+
+/* The runtime configuration, as saved by the SAVE CONFIG command and
+ * restored at startup.
+ * layout is NW_CONFIG_LAYOUT, so that a zeroed or an erased EEPROM is
+ * not taken as a valid configuration.
+ * flags holds the test mode in b0, the autostart in b1, and the idle
+ * mode in b2; with the autostart, the started channels are started at
+ * startup, each first deadline being pushed by the grace period.
+ * targets holds the bindings of the channels to the reset targets (see
+ * nwTargetBindingsGet()).
+ * crc is the CRC-8 of the other fields.
+ */
+struct nwConfigStr {
+    byte     layout;					/*  1 - NW_CONFIG_LAYOUT */
+    byte     flags;						/*  1 - NW_CONFIG_xxx */
+    byte     started;					/*  1 - bit n: channel n */
+    uint16_t grace;						/*  2 - sec. */
+    uint32_t delay[NW_MAX_CHANNEL];		/* 16 - ms */
+    byte     targets;					/*  1 - bits 2n+1..2n: channel n */
+    byte     crc;						/*  1 */
+};
+
+static const int nwConfigStrSize = sizeof( nwConfigStr );
+
+#define NW_CONFIG_LAYOUT         2
+#define NW_CONFIG_TEST           ( 1 << 0 )
+#define NW_CONFIG_AUTOSTART      ( 1 << 1 )
+#define NW_CONFIG_IDLE           ( 1 << 2 )
+
 /* EEPROM content:
  *
  * address  type          size  content
  * -------  ------------  ----  ---------------------------------------
- *       0  nwEvent         37  initialization of the EEPROM
+ *       0  nwHeader        42  header
+ *      42  nwEvent          9  initialization of the EEPROM
+ *      51  nwEvent x 100  900  reset log
+ *     951  byte x 25       25  reset targets of the reset log
+ *     976  .. 991              unused
+ *     992  config          32  configuration, of which:
+ *     992  nwConfig        23  runtime configuration (see SAVE CONFIG)
+ *    1020  long             4  serial baud rate (zero for default)
+ *
+ * with the 1024 bytes EEPROM of the ATmega328P; the size of the EEPROM
+ * and the count of reset events are those of the board profile (see
+ * nwProfile.h), the configuration being always at the end.
+ *
+ * The reset log is a circular buffer: a new event is written in the
+ * slot which follows the most recent one, with the next sequence
+ * number, overwriting the oldest event when the log is full.
+ *
+ * The reset target of each slot of the reset log is a 2-bits field,
+ * slot n using the bits 2(n%4)+1..2(n%4) of the (n/4)-th byte; it is
+ * written before the event itself.
+ *
+ * Up to v11.2017, the EEPROM held, without any header:
+ *
+ *       0  nwLegacyEvent   37  initialization of the EEPROM
  *      37  int              2  count of reset traces
- *      39  nwEvent x 10   370  ten last resets
- *     409  .. 1023             unused
+ *      39  nwLegacyEvent  370  ten last resets, most recent first
+ *
+ * such a content is converted by nwEEPROMSetup().
  */
-static const int nwInitEventAdr  = 0;
-static const int nwResetCountAdr = nwInitEventAdr+nwEventStrSize;
-static const int nwResetEventAdr = nwResetCountAdr+sizeof( int );
+#define EEPROM_SIZE              NW_PROFILE_EEPROM_SIZE
+#define EEPROM_CONFIG_SIZE       32
+#define NW_MAX_RESET_EVENT       NW_PROFILE_MAX_RESET_EVENT
+#define NW_EEPROM_MAGIC          0x574E		/* "NW" */
+#define NW_EEPROM_LAYOUT         3
+
+static const int nwHeaderAdr     = 0;
+static const int nwInitEventAdr  = nwHeaderAdr+nwHeaderStrSize;
+static const int nwResetEventAdr = nwInitEventAdr+nwEventStrSize;
+static const int nwResetTargetAdr = nwResetEventAdr+NW_MAX_RESET_EVENT*nwEventStrSize;
+static const int nwResetTargetSize = ( NW_MAX_RESET_EVENT+3 )/4;
+static const int nwConfigAdr     = EEPROM_SIZE-EEPROM_CONFIG_SIZE;
+static const int nwConfigStrAdr  = nwConfigAdr;
+static const int nwBaudRateAdr   = EEPROM_SIZE-sizeof( long );
 
-#define EEPROM_SIZE              1024
-#define NW_MAX_RESET_EVENT       10
+static_assert( nwResetTargetAdr+nwResetTargetSize <= nwConfigAdr,
+		"the reset log of the board profile overflows its EEPROM" );
+static_assert( nwConfigStrAdr+nwConfigStrSize <= nwBaudRateAdr,
+		"the saved configuration overflows the stored baud rate" );
+
+/* the legacy (up to v11.2017) event record */
+struct nwLegacyEventStr {
+    char   version[nwVersionSize];		/* 32 */
+    time_t time;						/*  4 */
+    byte   ack_reason;					/*  1 */
+};
+
+#define NW_LEGACY_MAX_RESET_EVENT 10
+
+static const int nwLegacyEventStrSize = sizeof( nwLegacyEventStr );
+static const int nwLegacyCountAdr     = nwLegacyEventStrSize;
+static const int nwLegacyEventAdr     = nwLegacyCountAdr+sizeof( int );
+
+/* EEPROM regions, as reported by the write counters */
+enum {
+	NW_EEPROM_REGION_HEADER = 0,
+	NW_EEPROM_REGION_INIT,
+	NW_EEPROM_REGION_RESET,
+	NW_EEPROM_REGION_TARGET,
+	NW_EEPROM_REGION_UNUSED,
+	NW_EEPROM_REGION_CONFIG,
+	NW_EEPROM_REGION_COUNT
+};
+
+/* update-only access: only the changed bytes are actually written */
+void    nwEEPROMWrite( int adr, const void *data, int size );
+void    nwEEPROMClear();
+
+template< typename T > void nwEEPROMPut( int adr, const T &value )
+{
+	nwEEPROMWrite( adr, &value, sizeof( T ));
+}
+
+/* the write counters since startup */
+PGM_P         nwEEPROMRegionName( byte region );
+unsigned long nwEEPROMWriteCountGet( byte region );
+unsigned long nwEEPROMSkipCountGet( byte region );
+
+/* check the layout, and load the reset log state */
+void    nwEEPROMSetup();
+
+/* count a new startup, returning its number */
+uint16_t nwEEPROMBootNew();
+
+/* the identifier of the running firmware */
+byte    nwEEPROMFirmwareId();
 
 /* read/write the initialization event */
 nwEvent nwEEPROMInitEventGet();
 void    nwEEPROMInitEventSet( nwEvent &ev );
 
+/* read/write the serial baud rate */
+long    nwEEPROMBaudRateGet();
+void    nwEEPROMBaudRateSet( long rate );
+
+/* read/write/clear the runtime configuration
+ * reading returns false if no valid configuration has been saved */
+bool    nwEEPROMConfigGet  ( nwConfigStr &config );
+void    nwEEPROMConfigSet  ( nwConfigStr &config );
+void    nwEEPROMConfigClear();
+
 /* read the count of stored reset events */
 int     nwEEPROMResetEventCountGet();
 
 /* read/write a reset event */
 nwEvent nwEEPROMResetEventGet   ( int index );
 void    nwEEPROMResetEventSet   ( nwEvent &ev, int index=0 );
-void    nwEEPROMResetEventSetNew( nwEvent &ev, int index=0 );
+void    nwEEPROMResetEventSetNew( nwEvent &ev );
+bool    nwEEPROMResetEventAcknowledge( int index );
+bool    nwEEPROMResetEventAcknowledgeRange( int from, int to );
+
+/* the sequence number of the most recent reset event */
+uint16_t nwEEPROMResetEventSeqGet();
+
+/* the identifier of the run of sequence numbers of the reset log */
+uint32_t nwEEPROMResetLogIdGet();
 
 #endif /* __NWEEPROM_H__ */
@@ -38,13 +38,15 @@ nwEvent::nwEvent()
 /**
  * nwEvent::nwEvent:
  * @reason: the event reason code.
+ * @target: the reset target.
  *
  * A constructor which takes a specific reason code.
  */
-nwEvent::nwEvent( int reason )
+nwEvent::nwEvent( int reason, byte target )
 {
 	this->setup();
     _reason = reason;
+    _target = target;
 }
 
 /*
@@ -54,41 +56,57 @@ nwEvent::nwEvent( int reason )
  */
 void nwEvent::setup()
 {
-	/* set version to current version string */
-    memset(( void * ) _version, '\0', sizeof( _version ));
-    for( int i=0 ;; ++i ){
-        _version[i] = pgm_read_byte_near( nwVersionString+i );
-        if( _version[i] == '\0' ){
-        	break;
-        }
-    }
     /* set event time to now */
     _time = now();
     /* set reason code to default (no ping) */
     _reason = NW_REASON_DEFAULT;
     /* set acknowledgement to false */
     _ack = false;
+    /* the event comes from this firmware */
+    _fwid = nwEEPROMFirmwareId();
+    _seq = 0;
+    _target = 0;
+}
+
+/**
+ * nwEvent::set:
+ * @time: the event time.
+ * @ack_reason: the acknowledgment indicator and the reason code, packed
+ *  as in the nwEventStr structure.
+ * @fwid: the identifier of the originating firmware.
+ *
+ * Set the content of the object.
+ */
+void nwEvent::set( time_t time, byte ack_reason, byte fwid )
+{
+    _time = time;
+    _reason = ack_reason & B01111111;
+    _ack = ack_reason >> 7;
+    _fwid = fwid;
 }
 
 /**
  * nwEvent::readFromEEPROM:
  * @adr: the read address in the EEPROM (counted from zero)
+ * @target: the reset target, which is stored apart from the record
+ *  (see nwEEPROM.h).
  *
  * Deserialization: setup the current object with the data read from
  * EEPROM at specified address.
+ *
+ * Returns: true if the read record is valid, false else.
  */
-void nwEvent::readFromEEPROM( int adr )
+bool nwEvent::readFromEEPROM( int adr, byte target )
 {
 	nwEventStr ev;
 
     EEPROM.get( adr, ev );
 
-    for( int i=0 ; i<nwVersionSize ; ++i ){
-    	_version[i] = ev.version[i];
-    }
-    _time = ev.time;
-    _reason = ev.ack_reason & B01111111;
-    _ack = ev.ack_reason >> 7;
+    set( ev.time, ev.ack_reason, ev.fwid );
+    _seq = ev.seq;
+    _target = target;
+
+    return( ev.crc == crc());
 }
 
 /**
@@ -102,14 +120,36 @@ void nwEvent::writeToEEPROM( int adr )
 {
 	nwEventStr ev;
 
-	for( int i=0 ; i<nwVersionSize ; ++i ){
-    	ev.version[i] = _version[i];
-    }
     ev.time = _time;
-    ev.ack_reason = _reason;
-    ev.ack_reason |= ( _ack ? B10000000 : 0 );
+    ev.ack_reason = getAckReason();
+    ev.fwid = _fwid;
+    ev.crc = crc();
+    ev.seq = _seq;
+
+    nwEEPROMPut( adr, ev );
+}
+
+/*
+ * nwEvent::crc:
+ *
+ * Returns: the CRC-8 of the serialized event, leaving the
+ *  acknowledgment indicator out.
+ */
+byte nwEvent::crc()
+{
+	uint32_t time = _time;
+	byte crc = 0;
+
+	for( byte i=0 ; i<sizeof( time ) ; ++i ){
+		crc = nwCrc8( crc, time >> ( 8*i ));
+	}
+	crc = nwCrc8( crc, _reason );
+	crc = nwCrc8( crc, _fwid );
+	crc = nwCrc8( crc, _seq );
+	crc = nwCrc8( crc, _seq >> 8 );
+	crc = nwCrc8( crc, _target );
 
-    EEPROM.put( adr, ev );
+	return( crc );
 }
 
 /**
@@ -120,21 +160,91 @@ void nwEvent::writeToEEPROM( int adr )
  */
 void nwEvent::display( const char *prefix )
 {
+    for( byte i=0 ; displayLine( prefix, i ) ; ++i ){
+        ;
+    }
+}
+
+/**
+ * nwEvent::displayLine:
+ * @prefix: the prefix to be displayed
+ * @line: the index of the line, from zero to NW_EVENT_LINES-1
+ *
+ * Display one line of the content of the object, so that a long answer
+ * may be streamed line by line (see nwOutput.h).
+ *
+ * Returns: true if the line has been displayed, false if @line is out
+ *  of range.
+ */
+bool nwEvent::displayLine( const char *prefix, byte line )
+{
+    if( line >= NW_EVENT_LINES ){
+        return( false );
+    }
     Serial.print( prefix );
-    Serial.print( F( "version:      " ));
-    Serial.println( _version );
-    Serial.print( prefix );
-    Serial.print( F( "date:         " ));
-    Serial.println( nwDateTimeString( _time ));
-    Serial.print( prefix );
-    Serial.print( F( "reason:       " ));
+    switch( line ){
+        case 0:
+            Serial.print( F( "version:      " ));
+            if( _fwid == nwEEPROMFirmwareId()){
+                Serial.println( FS( nwVersionString ));
+            } else if( _fwid == 0 ){
+                Serial.println( F( "unknown" ));
+            } else {
+                Serial.print( F( "firmware #" ));
+                Serial.println( _fwid );
+            }
+            break;
+        case 1:
+            Serial.print( F( "date:         " ));
+            nwDateTimePrint( _time );
+            break;
+        case 2: {
+            Serial.print( F( "reason:       " ));
+            Serial.print( _reason );
+            Serial.print( " (" );
+            Serial.print( FS( nwReasonString( _reason )));
+            byte channel = nwReasonChannel( _reason );
+            if( channel != NW_CHANNEL_NONE && channel > 0 ){
+                Serial.print( " " );
+                Serial.print( channel );
+            }
+            Serial.println( ")" );
+            break;
+        }
+        case 3:
+            Serial.print( F( "acknowledged: " ));
+            Serial.println( _ack ? "yes":"no" );
+            break;
+        case 4:
+            Serial.print( F( "target:       " ));
+            Serial.println( _target );
+            break;
+    }
+    return( true );
+}
+
+/**
+ * nwEvent::displayRecord:
+ *
+ * Display the content of the object as a single machine-readable line
+ * of space-separated 'key=value' pairs, the time being the raw time_t
+ * value, e.g.:
+ *   seq=17 time=1508083200 reason=1 ack=0 fwid=1 target=0
+ */
+void nwEvent::displayRecord()
+{
+    Serial.print( F( "seq=" ));
+    Serial.print( _seq );
+    Serial.print( F( " time=" ));
+    Serial.print(( unsigned long ) _time );
+    Serial.print( F( " reason=" ));
     Serial.print( _reason );
-    Serial.print( " (" );
-    Serial.print( nwReasonString( _reason ));
-    Serial.println( ")" );
-    Serial.print( prefix );
-    Serial.print( F( "acknowledged: " ));
-    Serial.println( _ack ? "yes":"no" );
+    Serial.print( F( " ack=" ));
+    Serial.print( _ack ? 1 : 0 );
+    Serial.print( F( " fwid=" ));
+    Serial.print( _fwid );
+    Serial.print( F( " target=" ));
+    Serial.println( _target );
 }
 
 /**
@@ -157,3 +267,70 @@ bool nwEvent::isNull()
 {
 	return( _time == 0 );
 }
+
+/**
+ * nwEvent::clear:
+ *
+ * Reset the object to a null event.
+ */
+void nwEvent::clear()
+{
+    _time = 0;
+    _reason = NW_REASON_DEFAULT;
+    _ack = false;
+    _fwid = 0;
+    _seq = 0;
+    _target = 0;
+}
+
+/**
+ * nwEvent::getTime:
+ *
+ * Returns: the time of the event.
+ */
+time_t nwEvent::getTime()
+{
+	return( _time );
+}
+
+/**
+ * nwEvent::getSeq:
+ *
+ * Returns: the sequence number of the event in the reset log.
+ */
+uint16_t nwEvent::getSeq()
+{
+	return( _seq );
+}
+
+/**
+ * nwEvent::setSeq:
+ * @seq: the sequence number.
+ *
+ * Set the sequence number of the event in the reset log.
+ */
+void nwEvent::setSeq( uint16_t seq )
+{
+	_seq = seq;
+}
+
+/**
+ * nwEvent::getTarget:
+ *
+ * Returns: the reset target of the event.
+ */
+byte nwEvent::getTarget()
+{
+	return( _target );
+}
+
+/**
+ * nwEvent::getAckReason:
+ *
+ * Returns: the acknowledgment indicator and the reason code, packed as
+ * in the nwEventStr structure.
+ */
+byte nwEvent::getAckReason()
+{
+	return( _reason | ( _ack ? B10000000 : 0 ));
+}
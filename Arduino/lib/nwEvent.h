@@ -27,27 +27,44 @@
 #ifndef __NWEVENT_H__
 #define __NWEVENT_H__
 
+/* the count of lines of nwEvent::display() */
+#define NW_EVENT_LINES	5
+
 class nwEvent {
 	public:
 		nwEvent();
-		nwEvent( int reason );
-		void readFromEEPROM( int adr=0 );
+		nwEvent( int reason, byte target=0 );
+		void set( time_t time, byte ack_reason, byte fwid );
+		bool readFromEEPROM( int adr=0, byte target=0 );
 		void writeToEEPROM( int adr=0 );
 		void display( const char *prefix="" );
+		bool displayLine( const char *prefix, byte line );
+		void displayRecord();
 		void acknowledge( bool ack=true );
 		bool isNull();
+		void clear();
+		time_t getTime();
+		byte getAckReason();
+		uint16_t getSeq();
+		void setSeq( uint16_t seq );
+		byte getTarget();
 	private:
-		/* the version string of the originating NanoWatchdog */
-	    char   _version[nwVersionSize];
 	    /* the time_t time when the event happened */
-	    time_t _time;
+	    time_t   _time;
 	    /* the reason code of the event (see nwReason.h) */
-	    int    _reason;
+	    int      _reason;
 	    /* whether the event has been acknowledged */
-	    bool   _ack;
+	    bool     _ack;
+		/* the identifier of the originating firmware (see nwEEPROM.h) */
+	    byte     _fwid;
+	    /* the sequence number in the reset log */
+	    uint16_t _seq;
+	    /* the reset target (see nwTarget.h) */
+	    byte     _target;
 
 	    /* private functions */
 	    void setup();
+	    byte crc();
 };
 
 #endif /* __NWEVENT_H__ */
@@ -0,0 +1,97 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+static bool          st_enabled = true;
+static bool          st_woken = false;		/* woken up by a received byte */
+static unsigned long st_wokenAt = 0;		/* micros() of this wake up */
+
+/**
+ * nwIdleEnable:
+ * @enable: whether to sleep between the events.
+ */
+void nwIdleEnable( bool enable )
+{
+	st_enabled = enable;
+}
+
+/**
+ * nwIdleIsEnabled:
+ *
+ * Returns: whether loop() sleeps between the events.
+ */
+bool nwIdleIsEnabled()
+{
+	return( st_enabled );
+}
+
+/**
+ * nwIdleSleep:
+ *
+ * Sleep until the next interrupt, unless a received byte is already
+ * waiting.
+ * The check and the sleep are done with the interrupts disabled, the
+ * instruction which follows 'sei' being always executed before any
+ * interrupt: a byte received in between wakes the MCU up at once.
+ */
+void nwIdleSleep()
+{
+	if( !st_enabled ){
+		return;
+	}
+	unsigned long start = micros();
+	set_sleep_mode( SLEEP_MODE_IDLE );
+	cli();
+	if( Serial.available()){
+		sei();
+		return;
+	}
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	unsigned long end = micros();
+	nwPerfIdle( end-start );
+	if( Serial.available()){
+		st_woken = true;
+		st_wokenAt = end;
+	}
+}
+
+/**
+ * nwIdleParse:
+ *
+ * Record the wake-to-parse latency if the MCU has been woken up by a
+ * received byte.
+ */
+void nwIdleParse()
+{
+	if( st_woken ){
+		nwPerfWake( micros()-st_wokenAt );
+		st_woken = false;
+	}
+}
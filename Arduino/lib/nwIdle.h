@@ -0,0 +1,59 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWIDLE_H__
+#define __NWIDLE_H__
+
+/* The idle mode
+ *
+ * Rather than polling Serial.available() and millis() at full speed,
+ * loop() may put the MCU into SLEEP_MODE_IDLE at the end of each
+ * iteration, as long as no received byte is waiting to be read.
+ *
+ * In this mode the CPU is stopped, but the timers and the USART keep on
+ * running: the MCU is woken up by the USART receive interrupt, and by
+ * the Timer0 overflow interrupt which drives millis() every 1.024 ms.
+ * The deadlines of the channels and the LED and relay transitions,
+ * which are all millis()-based, are so checked as often as with the
+ * busy polling, without any other timer.
+ *
+ * The time spent asleep and the wake-to-parse latencies, i.e. from the
+ * wake up by a received byte to the reading of the input, are recorded
+ * in the performance counters (see nwPerf.h).
+ *
+ * The idle mode is only available on the AVR: on other targets,
+ * nwIdleSleep() returns at once.
+ */
+
+/* whether loop() sleeps between the events, else busy polls */
+void nwIdleEnable   ( bool enable );
+bool nwIdleIsEnabled();
+
+/* to be called at the end of each loop() iteration */
+void nwIdleSleep    ();
+
+/* to be called just before reading the serial input */
+void nwIdleParse    ();
+
+#endif /* __NWIDLE_H__ */
@@ -0,0 +1,156 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+/* a queued notification */
+struct nwNotifyStr {
+	byte          code;
+	byte          channel;
+	unsigned long value;
+};
+
+static nwNotifyStr   st_queue[NW_MAX_NOTIFY];
+static byte          st_head = 0;			/* index of the oldest notification */
+static byte          st_count = 0;
+static unsigned long st_lost = 0;
+static bool          st_enabled = false;
+
+/* the notification names, as sent with the text protocol */
+static const PROGMEM char st_nameStart[]    = "START";
+static const PROGMEM char st_nameStop[]     = "STOP";
+static const PROGMEM char st_nameDeadline[] = "DEADLINE";
+static const PROGMEM char st_nameReset[]    = "RESET";
+static const PROGMEM char st_nameEeprom[]   = "EEPROM";
+static const PROGMEM char st_nameLost[]     = "LOST";
+
+static const PROGMEM char * const st_names[NW_NOTIFY_COUNT-1] = {
+	st_nameStart, st_nameStop, st_nameDeadline, st_nameReset, st_nameEeprom, st_nameLost
+};
+
+static void nwNotifyWrite( byte code, byte channel, unsigned long value, bool binary );
+
+/**
+ * nwNotifyEnable:
+ * @enable: whether the notifications are to be sent.
+ *
+ * Enable or disable the notifications; the pending ones are dropped
+ * when disabling.
+ */
+void nwNotifyEnable( bool enable )
+{
+	st_enabled = enable;
+	if( !enable ){
+		st_count = 0;
+		st_lost = 0;
+	}
+}
+
+/**
+ * nwNotifyIsEnabled:
+ *
+ * Returns: whether the notifications are enabled.
+ */
+bool nwNotifyIsEnabled()
+{
+	return( st_enabled );
+}
+
+/**
+ * nwNotifyPush:
+ * @code: the NW_NOTIFY_xxx notification code.
+ * @channel: the channel number, or NW_CHANNEL_NONE.
+ * @value: the value of the notification.
+ *
+ * Queue a notification to be sent at the end of the current loop.
+ * When the queue is full, the notification is counted as lost, and a
+ * NW_NOTIFY_LOST notification is sent after the queued ones.
+ */
+void nwNotifyPush( byte code, byte channel, unsigned long value )
+{
+	if( st_enabled ){
+		if( st_count < NW_MAX_NOTIFY ){
+			nwNotifyStr &n = st_queue[( st_head+st_count ) % NW_MAX_NOTIFY];
+			n.code = code;
+			n.channel = channel;
+			n.value = value;
+			st_count += 1;
+		} else {
+			st_lost += 1;
+		}
+	}
+}
+
+/**
+ * nwNotifySend:
+ * @binary: whether the binary protocol is used.
+ *
+ * Send the queued notifications.
+ */
+void nwNotifySend( bool binary )
+{
+	while( st_count > 0 ){
+		nwNotifyStr &n = st_queue[st_head];
+		nwNotifyWrite( n.code, n.channel, n.value, binary );
+		st_head = ( st_head+1 ) % NW_MAX_NOTIFY;
+		st_count -= 1;
+	}
+	if( st_lost > 0 ){
+		nwNotifyWrite( NW_NOTIFY_LOST, NW_CHANNEL_NONE, st_lost, binary );
+		st_lost = 0;
+	}
+}
+
+/*
+ * nwNotifyWrite:
+ * @code: the NW_NOTIFY_xxx notification code.
+ * @channel: the channel number, or NW_CHANNEL_NONE.
+ * @value: the value of the notification.
+ * @binary: whether the binary protocol is used.
+ *
+ * Send a notification.
+ */
+static void nwNotifyWrite( byte code, byte channel, unsigned long value, bool binary )
+{
+	if( binary ){
+		nwFrame frame;
+		frame.opcode = NW_BIN_OP_NOTIFY;
+		frame.length = 0;
+		nwBinaryPut( frame, code, 1 );
+		nwBinaryPut( frame, channel, 1 );
+		nwBinaryPut( frame, value, 4 );
+		nwBinaryWrite( frame );
+	} else {
+		Serial.print( F( "! " ));
+		Serial.print( FS(( PGM_P ) pgm_read_ptr( &st_names[code-1] )));
+		Serial.print( " " );
+		if( channel == NW_CHANNEL_NONE ){
+			Serial.print( "-" );
+		} else {
+			Serial.print( channel );
+		}
+		Serial.print( " " );
+		Serial.println( value );
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWNOTIFY_H__
+#define __NWNOTIFY_H__
+
+/* The asynchronous notifications
+ *
+ * Once enabled by the 'SET EVENTS ON' command, the board sends an
+ * unsolicited notification on each of its state transitions, so that
+ * the host doesn't have to poll the STATUS.
+ *
+ * The notifications are queued when the transition happens, and only
+ * sent from loop() once the current command has been answered, so that
+ * they are never mixed with an answer. They are sent:
+ * - with the text protocol, as a '!'-prefixed line:
+ *   "! <name> <channel> <value>", the channel being '-' when the
+ *   notification is not bound to a channel
+ * - with the binary protocol, as a NW_BIN_OP_NOTIFY frame (see
+ *   nwBinary.h).
+ */
+enum {
+	NW_NOTIFY_START          = 1,	/* channel started, value=delay (ms) */
+	NW_NOTIFY_STOP,					/* channel stopped, value=0 */
+	NW_NOTIFY_DEADLINE,				/* channel not pinged for value=50, 75 or 90% of its delay */
+	NW_NOTIFY_RESET,				/* reset activated, value=reason code */
+	NW_NOTIFY_EEPROM,				/* reset event written, value=its sequence number */
+	NW_NOTIFY_LOST,					/* value=count of notifications lost on a full queue */
+	NW_NOTIFY_COUNT
+};
+
+/* max count of queued notifications */
+#define NW_MAX_NOTIFY            8
+
+/* whether the notifications are sent (default is off) */
+void nwNotifyEnable  ( bool enable );
+bool nwNotifyIsEnabled();
+
+/* queue a notification, if enabled */
+void nwNotifyPush    ( byte code, byte channel, unsigned long value );
+
+/* send the queued notifications; is to be called from loop() */
+void nwNotifySend    ( bool binary );
+
+#endif /* __NWNOTIFY_H__ */
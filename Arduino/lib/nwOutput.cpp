@@ -0,0 +1,72 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+static nwOutputStep  st_step = NULL;
+static nwOutputEnd   st_end = NULL;
+static unsigned int  st_index = 0;		/* the next record to be emitted */
+
+/**
+ * nwOutputStart:
+ * @step: the function which emits the records of the answer.
+ * @end: the function which terminates the answer, or NULL.
+ *
+ * Start streaming an answer, the first records being emitted by the
+ * next nwOutputRun().
+ */
+void nwOutputStart( nwOutputStep step, nwOutputEnd end )
+{
+	st_step = step;
+	st_end = end;
+	st_index = 0;
+}
+
+/**
+ * nwOutputIsBusy:
+ *
+ * Returns: whether an answer is being streamed.
+ */
+bool nwOutputIsBusy()
+{
+	return( st_step != NULL );
+}
+
+/**
+ * nwOutputRun:
+ *
+ * Emit the next records of the current answer while the TX buffer has
+ * room for them, and terminate the answer after its last record.
+ */
+void nwOutputRun()
+{
+	while( st_step && Serial.availableForWrite() >= NW_OUTPUT_ROOM ){
+		if( !st_step( st_index++ )){
+			st_step = NULL;
+			if( st_end ){
+				st_end();
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWOUTPUT_H__
+#define __NWOUTPUT_H__
+
+/* The streamed answers
+ *
+ * The long answers (HELP, STATUS, EEPROM DUMP) are not printed in one
+ * go: Serial.print() blocks as soon as the 64 bytes of the TX buffer are
+ * full, and, at 19200 bauds, an EEPROM dump would so keep loop() busy
+ * during most of a second, neither checking the deadlines nor reading
+ * the incoming pings.
+ *
+ * Instead, the command registers a step function, which emits the
+ * index-th record (one or a few lines) of its answer, and returns false
+ * when there is nothing left to emit. loop() calls nwOutputRun() on each
+ * iteration, which emits the next records as long as the TX buffer has
+ * at least NW_OUTPUT_ROOM free bytes, then calls the end function when
+ * the answer is complete. A record longer than the free room still
+ * waits for the TX buffer to drain its overflow.
+ *
+ * A step function may emit nothing for an index (e.g. a field which is
+ * not displayed), and is free to keep its own state between the calls,
+ * the indexes being always run in sequence from zero.
+ */
+#define NW_OUTPUT_ROOM		40
+
+typedef bool ( *nwOutputStep )( unsigned int index );
+typedef void ( *nwOutputEnd )();
+
+/* start streaming an answer */
+void nwOutputStart ( nwOutputStep step, nwOutputEnd end );
+
+/* whether an answer is being streamed */
+bool nwOutputIsBusy();
+
+/* to be called on each loop() iteration */
+void nwOutputRun   ();
+
+#endif /* __NWOUTPUT_H__ */
@@ -0,0 +1,500 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+/* the serial receive buffer of the Arduino core */
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE    64
+#endif
+
+/* the free RAM paint
+ * NW_PERF_GUARD bytes are left unpainted below the stack pointer, for
+ * the interrupts which may happen while painting */
+#define NW_PERF_CANARY           0xC5
+#define NW_PERF_GUARD            32
+
+#ifdef __AVR__
+extern char  __heap_start;
+extern char *__brkval;
+#endif
+
+static unsigned long st_since = 0;			/* millis() of the last reset */
+static unsigned long st_loopStart = 0;		/* micros() at the start of the iteration */
+static unsigned long st_loopCount = 0;
+static unsigned long st_loopSum = 0;		/* us, along with st_loopAvgCount */
+static unsigned long st_loopAvgCount = 0;
+static unsigned long st_loopMax = 0;
+static unsigned long st_total = 0;			/* text commands and binary requests */
+#if NW_PROFILE_PERF
+static unsigned long st_commands[NW_PERF_MAX_COMMAND];
+static unsigned long st_frames[NW_PERF_MAX_FRAME];
+#endif
+static unsigned long st_rejected = 0;
+static unsigned long st_rxFull = 0;
+static unsigned long st_rxDropped = 0;
+static unsigned long st_badFrames = 0;
+static unsigned long st_eepromBase = 0;		/* EEPROM bytes written before the reset */
+static unsigned long st_marginMin = NW_PERF_NONE;
+static byte          st_marginChannel = NW_CHANNEL_NONE;
+static unsigned long st_idleCount = 0;
+static unsigned long st_idleMs = 0;			/* ms asleep, along with st_idleUs */
+static unsigned long st_idleUs = 0;			/* us asleep, less than 1000 */
+static unsigned long st_wakeCount = 0;
+static unsigned long st_wakeSum = 0;		/* us, along with st_wakeAvgCount */
+static unsigned long st_wakeAvgCount = 0;
+static unsigned long st_wakeMax = 0;
+
+/*
+ * nwPerfEEPROMTotal:
+ *
+ * Returns: the count of bytes written to the EEPROM since startup.
+ */
+static unsigned long nwPerfEEPROMTotal()
+{
+	unsigned long total = 0;
+	for( byte i=0 ; i<NW_EEPROM_REGION_COUNT ; ++i ){
+		total += nwEEPROMWriteCountGet( i );
+	}
+	return( total );
+}
+
+/*
+ * nwPerfPaint:
+ *
+ * Paint the free RAM between the top of the heap and the stack.
+ */
+static void nwPerfPaint()
+{
+#ifdef __AVR__
+	char here;
+	char *p = __brkval ? __brkval : &__heap_start;
+	while( p < &here-NW_PERF_GUARD ){
+		*p++ = NW_PERF_CANARY;
+	}
+#endif
+}
+
+/**
+ * nwPerfSetup:
+ *
+ * Start counting.
+ */
+void nwPerfSetup()
+{
+	nwPerfReset();
+}
+
+/**
+ * nwPerfReset:
+ *
+ * Reset all the counters, and paint again the free RAM.
+ */
+void nwPerfReset()
+{
+	st_since = millis();
+	st_loopCount = 0;
+	st_loopSum = 0;
+	st_loopAvgCount = 0;
+	st_loopMax = 0;
+	st_total = 0;
+#if NW_PROFILE_PERF
+	memset( st_commands, 0, sizeof( st_commands ));
+	memset( st_frames, 0, sizeof( st_frames ));
+#endif
+	st_rejected = 0;
+	st_rxFull = 0;
+	st_rxDropped = 0;
+	st_badFrames = 0;
+	st_eepromBase = nwPerfEEPROMTotal();
+	st_marginMin = NW_PERF_NONE;
+	st_marginChannel = NW_CHANNEL_NONE;
+	st_idleCount = 0;
+	st_idleMs = 0;
+	st_idleUs = 0;
+	st_wakeCount = 0;
+	st_wakeSum = 0;
+	st_wakeAvgCount = 0;
+	st_wakeMax = 0;
+	nwPerfPaint();
+}
+
+/**
+ * nwPerfLoopBegin:
+ *
+ * Record the start of a loop() iteration, and check whether the serial
+ * receive buffer has been filled since the previous one.
+ */
+void nwPerfLoopBegin()
+{
+	st_loopStart = micros();
+	if( Serial.available() >= SERIAL_RX_BUFFER_SIZE-1 ){
+		st_rxFull += 1;
+	}
+}
+
+/**
+ * nwPerfLoopEnd:
+ *
+ * Record the duration of the loop() iteration.
+ * The average is computed on a sum of the durations which is halved,
+ * along with its count, when it reaches 2^31 us (about 36 minutes), so
+ * that it can't overflow and slowly forgets the oldest iterations.
+ */
+void nwPerfLoopEnd()
+{
+	unsigned long duration = micros()-st_loopStart;
+	st_loopCount += 1;
+	if( duration > st_loopMax ){
+		st_loopMax = duration;
+	}
+	st_loopSum += duration;
+	st_loopAvgCount += 1;
+	if( st_loopSum >= 0x80000000UL ){
+		st_loopSum /= 2;
+		st_loopAvgCount /= 2;
+	}
+}
+
+/**
+ * nwPerfCommand:
+ * @index: the index of the text command in the commands table.
+ */
+void nwPerfCommand( byte index )
+{
+	st_total += 1;
+#if NW_PROFILE_PERF
+	if( index < NW_PERF_MAX_COMMAND ){
+		st_commands[index] += 1;
+	}
+#endif
+}
+
+/**
+ * nwPerfRejected:
+ *
+ * Record a text command answered as unknown or invalid.
+ */
+void nwPerfRejected()
+{
+	st_rejected += 1;
+}
+
+/**
+ * nwPerfFrame:
+ * @opcode: the opcode of the binary request.
+ */
+void nwPerfFrame( byte opcode )
+{
+	st_total += 1;
+#if NW_PROFILE_PERF
+	if( opcode < NW_PERF_MAX_FRAME ){
+		st_frames[opcode] += 1;
+	}
+#endif
+}
+
+/**
+ * nwPerfBadFrame:
+ *
+ * Record a frame received with a wrong CRC or length.
+ */
+void nwPerfBadFrame()
+{
+	st_badFrames += 1;
+}
+
+/**
+ * nwPerfRxDropped:
+ *
+ * Record a byte dropped because the command it belongs to is too long.
+ */
+void nwPerfRxDropped()
+{
+	st_rxDropped += 1;
+}
+
+/**
+ * nwPerfMargin:
+ * @channel: the channel number.
+ * @left: the ms left before the deadline of the channel when it is
+ *  pinged, or zero when it expires.
+ */
+void nwPerfMargin( byte channel, unsigned long left )
+{
+	if( left < st_marginMin ){
+		st_marginMin = left;
+		st_marginChannel = channel;
+	}
+}
+
+/**
+ * nwPerfIdle:
+ * @asleep: the duration of the sleep (us).
+ *
+ * Record a sleep of the idle mode.
+ */
+void nwPerfIdle( unsigned long asleep )
+{
+	st_idleCount += 1;
+	st_idleUs += asleep;
+	st_idleMs += st_idleUs/1000;
+	st_idleUs %= 1000;
+}
+
+/**
+ * nwPerfWake:
+ * @latency: the us from the wake up to the reading of the input.
+ *
+ * Record a wake-to-parse latency of the idle mode.
+ * The average is computed as for the loop() iterations.
+ */
+void nwPerfWake( unsigned long latency )
+{
+	st_wakeCount += 1;
+	if( latency > st_wakeMax ){
+		st_wakeMax = latency;
+	}
+	st_wakeSum += latency;
+	st_wakeAvgCount += 1;
+	if( st_wakeSum >= 0x80000000UL ){
+		st_wakeSum /= 2;
+		st_wakeAvgCount /= 2;
+	}
+}
+
+/**
+ * nwPerfSince:
+ *
+ * Returns: the ms elapsed since the counters have been reset.
+ */
+unsigned long nwPerfSince()
+{
+	return( millis()-st_since );
+}
+
+/**
+ * nwPerfLoopCount:
+ *
+ * Returns: the count of loop() iterations.
+ */
+unsigned long nwPerfLoopCount()
+{
+	return( st_loopCount );
+}
+
+/**
+ * nwPerfLoopAverage:
+ *
+ * Returns: the average duration of a loop() iteration (us).
+ */
+unsigned long nwPerfLoopAverage()
+{
+	return( st_loopAvgCount ? st_loopSum/st_loopAvgCount : 0 );
+}
+
+/**
+ * nwPerfLoopMax:
+ *
+ * Returns: the longest duration of a loop() iteration (us).
+ */
+unsigned long nwPerfLoopMax()
+{
+	return( st_loopMax );
+}
+
+/**
+ * nwPerfCommandCount:
+ * @index: the index of the text command in the commands table.
+ *
+ * Returns: the count of times the command has been executed.
+ */
+unsigned long nwPerfCommandCount( byte index )
+{
+#if NW_PROFILE_PERF
+	return( index < NW_PERF_MAX_COMMAND ? st_commands[index] : 0 );
+#else
+	return( 0 );
+#endif
+}
+
+/**
+ * nwPerfCommandTotal:
+ *
+ * Returns: the count of executed text commands and binary requests.
+ */
+unsigned long nwPerfCommandTotal()
+{
+	return( st_total );
+}
+
+/**
+ * nwPerfRejectedCount:
+ *
+ * Returns: the count of text commands answered as unknown or invalid.
+ */
+unsigned long nwPerfRejectedCount()
+{
+	return( st_rejected );
+}
+
+/**
+ * nwPerfFrameCount:
+ * @opcode: the opcode of the binary request.
+ *
+ * Returns: the count of received requests.
+ */
+unsigned long nwPerfFrameCount( byte opcode )
+{
+#if NW_PROFILE_PERF
+	return( opcode < NW_PERF_MAX_FRAME ? st_frames[opcode] : 0 );
+#else
+	return( 0 );
+#endif
+}
+
+/**
+ * nwPerfRxFullCount:
+ *
+ * Returns: the count of loop() iterations which have found the serial
+ *  receive buffer full.
+ */
+unsigned long nwPerfRxFullCount()
+{
+	return( st_rxFull );
+}
+
+/**
+ * nwPerfRxDroppedCount:
+ *
+ * Returns: the count of bytes dropped from too long commands.
+ */
+unsigned long nwPerfRxDroppedCount()
+{
+	return( st_rxDropped );
+}
+
+/**
+ * nwPerfBadFrameCount:
+ *
+ * Returns: the count of frames received with a wrong CRC or length.
+ */
+unsigned long nwPerfBadFrameCount()
+{
+	return( st_badFrames );
+}
+
+/**
+ * nwPerfFreeRamMin:
+ *
+ * Returns: the smallest count of free bytes ever seen between the heap
+ *  and the stack, not counting NW_PERF_GUARD, or NW_PERF_NONE if this
+ *  is unknown.
+ */
+unsigned long nwPerfFreeRamMin()
+{
+#ifdef __AVR__
+	const char *p = __brkval ? __brkval : &__heap_start;
+	unsigned long count = 0;
+	while( *p++ == ( char ) NW_PERF_CANARY ){
+		count += 1;
+	}
+	return( count );
+#else
+	return( NW_PERF_NONE );
+#endif
+}
+
+/**
+ * nwPerfEEPROMWritten:
+ *
+ * Returns: the count of bytes written to the EEPROM.
+ */
+unsigned long nwPerfEEPROMWritten()
+{
+	return( nwPerfEEPROMTotal()-st_eepromBase );
+}
+
+/**
+ * nwPerfMarginMin:
+ * @channel: [out] the channel which has seen the smallest margin.
+ *
+ * Returns: the smallest count of ms ever left before the deadline of a
+ *  channel, or NW_PERF_NONE if no started channel has been pinged.
+ */
+unsigned long nwPerfMarginMin( byte *channel )
+{
+	*channel = st_marginChannel;
+	return( st_marginMin );
+}
+
+/**
+ * nwPerfIdleCount:
+ *
+ * Returns: the count of sleeps of the idle mode.
+ */
+unsigned long nwPerfIdleCount()
+{
+	return( st_idleCount );
+}
+
+/**
+ * nwPerfIdleTime:
+ *
+ * Returns: the time spent asleep (ms).
+ */
+unsigned long nwPerfIdleTime()
+{
+	return( st_idleMs );
+}
+
+/**
+ * nwPerfWakeCount:
+ *
+ * Returns: the count of wake ups by a received byte.
+ */
+unsigned long nwPerfWakeCount()
+{
+	return( st_wakeCount );
+}
+
+/**
+ * nwPerfWakeAverage:
+ *
+ * Returns: the average wake-to-parse latency (us).
+ */
+unsigned long nwPerfWakeAverage()
+{
+	return( st_wakeAvgCount ? st_wakeSum/st_wakeAvgCount : 0 );
+}
+
+/**
+ * nwPerfWakeMax:
+ *
+ * Returns: the max wake-to-parse latency (us).
+ */
+unsigned long nwPerfWakeMax()
+{
+	return( st_wakeMax );
+}
@@ -0,0 +1,103 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWPERF_H__
+#define __NWPERF_H__
+
+/* The performance counters
+ *
+ * Kept in RAM since the startup, or since the last nwPerfReset(), and
+ * displayed by the PERF command:
+ * - the count of loop() iterations, and their average and worst-case
+ *   durations
+ * - the count of text commands by entry of the commands table, of the
+ *   rejected ones, and of binary requests by opcode; the counters by
+ *   command and by opcode are only kept with NW_PROFILE_PERF, the total
+ *   being always kept
+ * - the count of loop() iterations which have found the serial receive
+ *   buffer full (the next received bytes are then silently dropped by
+ *   the Arduino core), of the bytes dropped from too long commands, and
+ *   of the frames received with a wrong CRC or length
+ * - the low-water mark of the free RAM between the heap and the stack
+ * - the count of bytes written to the EEPROM
+ * - the smallest margin ever seen before the deadline of a channel,
+ *   i.e. the ms which were left when it has been pinged
+ * - with the idle mode (see nwIdle.h), the count of sleeps and the time
+ *   spent asleep, and the wake-to-parse latencies, i.e. the us from the
+ *   wake up by a received byte to its reading.
+ *
+ * The free RAM is measured by painting it with a canary byte, and by
+ * looking at how much of this paint is left: this catches the deepest
+ * stack usage, even between two loop() iterations. It is only available
+ * on the AVR.
+ */
+#if NW_PROFILE_PERF
+#define NW_PERF_MAX_COMMAND      40	/* at least the size of the commands table */
+#define NW_PERF_MAX_FRAME        16	/* the request opcodes are less than that */
+#else
+#define NW_PERF_MAX_COMMAND      0
+#define NW_PERF_MAX_FRAME        0
+#endif
+#define NW_PERF_NONE             0xFFFFFFFF
+
+/* paint the free RAM, and start counting */
+void          nwPerfSetup            ();
+void          nwPerfReset            ();
+
+/* to be called at the start and at the end of each loop() iteration */
+void          nwPerfLoopBegin        ();
+void          nwPerfLoopEnd          ();
+
+/* record the events */
+void          nwPerfCommand          ( byte index );
+void          nwPerfRejected         ();
+void          nwPerfFrame            ( byte opcode );
+void          nwPerfBadFrame         ();
+void          nwPerfRxDropped        ();
+void          nwPerfMargin           ( byte channel, unsigned long left );
+void          nwPerfIdle             ( unsigned long asleep );
+void          nwPerfWake             ( unsigned long latency );
+
+/* the counters */
+unsigned long nwPerfSince            ();
+unsigned long nwPerfLoopCount        ();
+unsigned long nwPerfLoopAverage      ();
+unsigned long nwPerfLoopMax          ();
+unsigned long nwPerfCommandCount     ( byte index );
+unsigned long nwPerfCommandTotal     ();
+unsigned long nwPerfRejectedCount    ();
+unsigned long nwPerfFrameCount       ( byte opcode );
+unsigned long nwPerfRxFullCount      ();
+unsigned long nwPerfRxDroppedCount   ();
+unsigned long nwPerfBadFrameCount    ();
+unsigned long nwPerfFreeRamMin       ();
+unsigned long nwPerfEEPROMWritten    ();
+unsigned long nwPerfMarginMin        ( byte *channel );
+unsigned long nwPerfIdleCount        ();
+unsigned long nwPerfIdleTime         ();
+unsigned long nwPerfWakeCount        ();
+unsigned long nwPerfWakeAverage      ();
+unsigned long nwPerfWakeMax          ();
+
+#endif /* __NWPERF_H__ */
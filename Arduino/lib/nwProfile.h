@@ -0,0 +1,148 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWPROFILE_H__
+#define __NWPROFILE_H__
+
+/* The board profiles
+ *
+ * The pin map, the size of the EEPROM, the depth of the reset log, the
+ * size of the command line buffer and the optional features are fixed
+ * at compile time by the board profile.
+ *
+ * NW_PROFILE defaults to the profile of the target board, as defined by
+ * the Arduino IDE, or else to NW_PROFILE_NANO; it may also be set on
+ * the compiler command line, e.g. -DNW_PROFILE=NW_PROFILE_MINI.
+ *
+ * profile             MCU         EEPROM  events  command  relays  HELP  REINIT  PERF
+ * ------------------  ----------  ------  ------  -------  ------  ----  ------  ----
+ * NW_PROFILE_NANO     ATmega328P    1024     100       80       4   yes     yes   yes
+ * NW_PROFILE_UNO      ATmega328P    1024     100       80       4   yes     yes   yes
+ * NW_PROFILE_PROMINI  ATmega328P    1024     100       80       4   yes     yes   yes
+ * NW_PROFILE_MINI     ATmega168      512      40       48       2    no      no    no
+ *
+ * The three ATmega328P boards share the pin map of the Nano (the LEDs
+ * and the relay of the first target on A0..A3, the relays of the other
+ * targets on D2..D4, see nwTarget.h). The MINI profile fits the ATmega168-class
+ * boards (16 KB Flash, 1 KB RAM): HELP and its texts, and the
+ * deprecated REINIT command, are left out of the commands table, their
+ * then unreferenced handlers being dropped by the linker (the Arduino
+ * builds use -ffunction-sections and --gc-sections); the PERF command
+ * only displays the total of the commands, without the counters by
+ * command and by binary opcode (224 bytes of RAM, see nwPerf.h).
+ *
+ * Each value may yet be overriden on its own, e.g. -DNW_PROFILE_LED_PING=13.
+ *
+ * 'make -C Arduino/NanoWatchdog sizes' displays the footprint of each
+ * profile, as reported by avr-size.
+ */
+#define NW_PROFILE_NANO              1
+#define NW_PROFILE_UNO               2
+#define NW_PROFILE_PROMINI           3
+#define NW_PROFILE_MINI              4
+
+#ifndef NW_PROFILE
+#if defined( __AVR_ATmega168__ ) || defined( __AVR_ATmega168P__ )
+#define NW_PROFILE                   NW_PROFILE_MINI
+#elif defined( ARDUINO_AVR_UNO )
+#define NW_PROFILE                   NW_PROFILE_UNO
+#elif defined( ARDUINO_AVR_PRO )
+#define NW_PROFILE                   NW_PROFILE_PROMINI
+#else
+#define NW_PROFILE                   NW_PROFILE_NANO
+#endif
+#endif
+
+#if NW_PROFILE == NW_PROFILE_MINI
+#define NW_PROFILE_DEF_EEPROM_SIZE   512
+#define NW_PROFILE_DEF_RESET_EVENT   40
+#define NW_PROFILE_DEF_COMMAND       48
+#define NW_PROFILE_DEF_TARGET        2
+#define NW_PROFILE_DEF_FEATURES      0
+#elif NW_PROFILE == NW_PROFILE_NANO || NW_PROFILE == NW_PROFILE_UNO || NW_PROFILE == NW_PROFILE_PROMINI
+#define NW_PROFILE_DEF_EEPROM_SIZE   1024
+#define NW_PROFILE_DEF_RESET_EVENT   100
+#define NW_PROFILE_DEF_COMMAND       80
+#define NW_PROFILE_DEF_TARGET        4
+#define NW_PROFILE_DEF_FEATURES      1
+#else
+#error "NW_PROFILE: unknown board profile"
+#endif
+
+/* the pins of the LEDs and of the reset relays, EXEC_RESET being the
+ * relay of the first target */
+#ifndef NW_PROFILE_LED_START
+#define NW_PROFILE_LED_START         14			/* A0 */
+#endif
+#ifndef NW_PROFILE_LED_PING
+#define NW_PROFILE_LED_PING          15			/* A1 */
+#endif
+#ifndef NW_PROFILE_LED_RESET
+#define NW_PROFILE_LED_RESET         16			/* A2 */
+#endif
+#ifndef NW_PROFILE_EXEC_RESET
+#define NW_PROFILE_EXEC_RESET        17			/* A3 */
+#endif
+#ifndef NW_PROFILE_EXEC_RESET1
+#define NW_PROFILE_EXEC_RESET1       2			/* D2 */
+#endif
+#ifndef NW_PROFILE_EXEC_RESET2
+#define NW_PROFILE_EXEC_RESET2       3			/* D3 */
+#endif
+#ifndef NW_PROFILE_EXEC_RESET3
+#define NW_PROFILE_EXEC_RESET3       4			/* D4 */
+#endif
+
+/* the count of reset relays, i.e. of the hosts which may be supervised
+ * (at most 4, see nwTarget.h) */
+#ifndef NW_PROFILE_MAX_TARGET
+#define NW_PROFILE_MAX_TARGET        NW_PROFILE_DEF_TARGET
+#endif
+
+/* the size of the EEPROM, and the count of kept reset events (see
+ * nwEEPROM.h) */
+#ifndef NW_PROFILE_EEPROM_SIZE
+#define NW_PROFILE_EEPROM_SIZE       NW_PROFILE_DEF_EEPROM_SIZE
+#endif
+#ifndef NW_PROFILE_MAX_RESET_EVENT
+#define NW_PROFILE_MAX_RESET_EVENT   NW_PROFILE_DEF_RESET_EVENT
+#endif
+
+/* the max length of a command line, not counting the '\n' */
+#ifndef NW_PROFILE_MAX_COMMAND
+#define NW_PROFILE_MAX_COMMAND       NW_PROFILE_DEF_COMMAND
+#endif
+
+/* the optional features */
+#ifndef NW_PROFILE_HELP
+#define NW_PROFILE_HELP              NW_PROFILE_DEF_FEATURES
+#endif
+#ifndef NW_PROFILE_REINIT
+#define NW_PROFILE_REINIT            NW_PROFILE_DEF_FEATURES
+#endif
+#ifndef NW_PROFILE_PERF
+#define NW_PROFILE_PERF              NW_PROFILE_DEF_FEATURES
+#endif
+
+#endif /* __NWPROFILE_H__ */
@@ -24,26 +24,51 @@
 
 #include "NanoWatchdog.h"
 
+static const PROGMEM char st_init[]     = "initialization";
+static const PROGMEM char st_noping[]   = "no ping";
+static const PROGMEM char st_mcuWdt[]   = "firmware watchdog reset";
+static const PROGMEM char st_channel[]  = "no ping on channel";
+static const PROGMEM char st_command[]  = "external command";
+static const PROGMEM char st_unknown[]  = "unknown reason code";
+
 /**
  * nwReasonString:
  * @code: the reason code.
  *
- * Returns: the label corresponding to the specified reason code as a
- * new String
+ * Returns: the label corresponding to the specified reason code, as a
+ * string stored in Flash memory; the label of a missing ping on a
+ * channel other than 0 is to be completed with the channel number (see
+ * nwReasonChannel()).
  */
-String nwReasonString( int code )
+PGM_P nwReasonString( int code )
 {
-    String str;
-
     if( code == NW_REASON_INIT ){
-		str = "initialization";
+		return( st_init );
     } else if( code == NW_REASON_NOPING ){
-		str = "no ping";
+		return( st_noping );
+    } else if( code == NW_REASON_MCU_WDT ){
+		return( st_mcuWdt );
+    } else if( code > NW_REASON_NOPING_CHANNEL && code < NW_REASON_COMMAND_START ){
+		return( st_channel );
     } else if( code >= NW_REASON_COMMAND_START ){
-    	str = "external command";
-    } else {
-    	str = "unknown reason code";
+    	return( st_command );
     }
+    return( st_unknown );
+}
 
-    return( str );
+/**
+ * nwReasonChannel:
+ * @code: the reason code.
+ *
+ * Returns: the channel whose missing ping is the reason, or
+ *  NW_CHANNEL_NONE if the reason is not a missing ping.
+ */
+byte nwReasonChannel( int code )
+{
+    if( code == NW_REASON_NOPING ){
+		return( 0 );
+    } else if( code > NW_REASON_NOPING_CHANNEL && code < NW_REASON_COMMAND_START ){
+		return( code-NW_REASON_NOPING_CHANNEL );
+    }
+    return( NW_CHANNEL_NONE );
 }
@@ -37,6 +37,10 @@ enum {
 	NW_REASON_INIT          = 0,
 	NW_REASON_NOPING,								/* 1 */
 	NW_REASON_DEFAULT       = NW_REASON_NOPING,		/* 1 */
+	NW_REASON_MCU_WDT,								/* 2: the board itself has been reset by
+													   its watchdog timer (see nwWdt.h) */
+	NW_REASON_NOPING_CHANNEL = 8,					/* 8+n: no ping on channel n (1..7),
+													   channel 0 using NW_REASON_NOPING */
 	NW_REASON_COMMAND_START = 16,
 	NW_REASON_MAX_LOAD_1    = 16,					/* NanoWatchdog management daemon */
 	NW_REASON_MAX_LOAD_5,							/* NanoWatchdog management daemon */
@@ -49,6 +53,10 @@ enum {
 	NW_REASON_MAX           = 127
 };
 
-String nwReasonString( int code );
+/* the label of the reason code, in Flash memory */
+PGM_P nwReasonString ( int code );
+
+/* the channel whose missing ping is the reason, or NW_CHANNEL_NONE */
+byte  nwReasonChannel( int code );
 
 #endif /* __NWREASON_H__ */
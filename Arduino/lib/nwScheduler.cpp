@@ -0,0 +1,131 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+/* a pin transition slot
+ * the slot is free while not pending
+ */
+struct nwSchedulerSlot {
+	bool          pending;
+	int           pin;
+	int           state;
+	unsigned long at;
+};
+
+static nwSchedulerSlot st_slots[NW_MAX_SCHEDULED];
+
+/*
+ * nwSchedulerFind:
+ * @pin: the pin number.
+ *
+ * Returns: the index of the slot which holds a pending transition for
+ * this pin, or -1.
+ */
+static int nwSchedulerFind( int pin )
+{
+	for( int i=0 ; i<NW_MAX_SCHEDULED ; ++i ){
+		if( st_slots[i].pending && st_slots[i].pin == pin ){
+			return( i );
+		}
+	}
+	return( -1 );
+}
+
+/*
+ * nwSchedulerFindFree:
+ *
+ * Returns: the index of a free slot, or -1.
+ */
+static int nwSchedulerFindFree()
+{
+	for( int i=0 ; i<NW_MAX_SCHEDULED ; ++i ){
+		if( !st_slots[i].pending ){
+			return( i );
+		}
+	}
+	return( -1 );
+}
+
+/**
+ * nwSchedulerPinSet:
+ * @pin: the pin number.
+ * @state: the target state (HIGH or LOW).
+ * @delay: the delay in milliseconds from now.
+ *
+ * Schedule the pin to be set to @state after @delay ms.
+ * A pending transition for the same pin is replaced, so that successive
+ * blinks just extend the current one.
+ * Should there be no free slot, the transition is executed right now
+ * rather than lost.
+ */
+void nwSchedulerPinSet( int pin, int state, unsigned long delay )
+{
+	int idx = nwSchedulerFind( pin );
+	if( idx < 0 ){
+		idx = nwSchedulerFindFree();
+	}
+	if( idx < 0 ){
+		digitalWrite( pin, state );
+		return;
+	}
+	st_slots[idx].pending = true;
+	st_slots[idx].pin = pin;
+	st_slots[idx].state = state;
+	st_slots[idx].at = millis() + delay;
+}
+
+/**
+ * nwSchedulerPinWrite:
+ * @pin: the pin number.
+ * @state: the target state (HIGH or LOW).
+ *
+ * Cancel any pending transition for this pin, and set it right now.
+ */
+void nwSchedulerPinWrite( int pin, int state )
+{
+	int idx = nwSchedulerFind( pin );
+	if( idx >= 0 ){
+		st_slots[idx].pending = false;
+	}
+	digitalWrite( pin, state );
+}
+
+/**
+ * nwSchedulerRun:
+ *
+ * Execute the pending transitions which are due.
+ * The comparison is done on the signed difference so that it keeps
+ * right when millis() rolls over (about every 49 days).
+ */
+void nwSchedulerRun()
+{
+	unsigned long tnow = millis();
+	for( int i=0 ; i<NW_MAX_SCHEDULED ; ++i ){
+		if( st_slots[i].pending && ( long )( tnow - st_slots[i].at ) >= 0 ){
+			digitalWrite( st_slots[i].pin, st_slots[i].state );
+			st_slots[i].pending = false;
+		}
+	}
+}
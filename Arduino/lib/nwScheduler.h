@@ -0,0 +1,44 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "nwProfile.h"
+
+#ifndef __NWSCHEDULER_H__
+#define __NWSCHEDULER_H__
+
+/* max count of simultaneously pending pin transitions
+ * we only have to deal with one transition per output pin, so this
+ * must be at least the count of LEDs and relays */
+#define NW_MAX_SCHEDULED         ( 3+NW_PROFILE_MAX_TARGET )
+
+/* schedule a pin transition after the given delay (ms) */
+void nwSchedulerPinSet  ( int pin, int state, unsigned long delay );
+
+/* cancel any pending transition and set the pin right now */
+void nwSchedulerPinWrite( int pin, int state );
+
+/* execute the transitions which are due; is to be called from loop() */
+void nwSchedulerRun();
+
+#endif /* __NWSCHEDULER_H__ */
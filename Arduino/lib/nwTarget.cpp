@@ -0,0 +1,246 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+
+/* the relay pins, by target */
+static const PROGMEM byte st_pins[] = {
+	NW_PROFILE_EXEC_RESET,
+	NW_PROFILE_EXEC_RESET1,
+	NW_PROFILE_EXEC_RESET2,
+	NW_PROFILE_EXEC_RESET3
+};
+
+/* the target of each channel, and the reset state and time of each
+ * target; the time is zero until the date is set */
+static byte          st_bindings[NW_MAX_CHANNEL];
+static bool          st_reset[NW_MAX_TARGET];
+static time_t        st_resetTime[NW_MAX_TARGET];
+
+/**
+ * nwTargetSetup:
+ *
+ * Set the relay pins as outputs, and bind all the channels to the
+ * first target; no target is reset.
+ */
+void nwTargetSetup()
+{
+	for( byte i=0 ; i<NW_MAX_TARGET ; ++i ){
+		pinMode( nwTargetPin( i ), OUTPUT );
+		st_reset[i] = false;
+		st_resetTime[i] = 0;
+	}
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		st_bindings[i] = 0;
+	}
+}
+
+/**
+ * nwTargetPin:
+ * @target: the target number.
+ *
+ * Returns: the pin of the relay of the target.
+ */
+int nwTargetPin( byte target )
+{
+	return( pgm_read_byte( st_pins+target ));
+}
+
+/**
+ * nwTargetBind:
+ * @channel: the channel number.
+ * @target: the target number.
+ *
+ * Bind the channel to the target, whose relay is so activated when the
+ * channel misses its deadline.
+ */
+void nwTargetBind( byte channel, byte target )
+{
+	st_bindings[channel] = target;
+}
+
+/**
+ * nwTargetOf:
+ * @channel: the channel number.
+ *
+ * Returns: the target the channel is bound to.
+ */
+byte nwTargetOf( byte channel )
+{
+	return( st_bindings[channel] );
+}
+
+/**
+ * nwTargetBindingsGet:
+ *
+ * Returns: the bindings of all the channels, packed as 2-bits fields.
+ */
+byte nwTargetBindingsGet()
+{
+	byte bindings = 0;
+
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		bindings |= st_bindings[i] << ( 2*i );
+	}
+	return( bindings );
+}
+
+/**
+ * nwTargetBindingsSet:
+ * @bindings: the bindings of all the channels, packed as 2-bits fields.
+ *
+ * Restore the bindings of the channels, the targets which do not exist
+ * with this board profile falling back to the first one.
+ */
+void nwTargetBindingsSet( byte bindings )
+{
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		byte target = ( bindings >> ( 2*i )) & 0x03;
+		st_bindings[i] = ( target < NW_MAX_TARGET ) ? target : 0;
+	}
+}
+
+/**
+ * nwTargetReset:
+ * @target: the target number.
+ *
+ * Activate the reset state of the target.
+ *
+ * Returns: true if the target was not already reset, false else.
+ */
+bool nwTargetReset( byte target )
+{
+	if( st_reset[target] ){
+		return( false );
+	}
+	st_reset[target] = true;
+	st_resetTime[target] = now();
+	return( true );
+}
+
+/**
+ * nwTargetClear:
+ * @target: the target number.
+ *
+ * Leave the reset state of the target.
+ */
+void nwTargetClear( byte target )
+{
+	st_reset[target] = false;
+	st_resetTime[target] = 0;
+}
+
+/**
+ * nwTargetIsReset:
+ * @target: the target number.
+ *
+ * Returns: whether the target is in its reset state.
+ */
+bool nwTargetIsReset( byte target )
+{
+	return( st_reset[target] );
+}
+
+/**
+ * nwTargetResetTime:
+ * @target: the target number.
+ *
+ * Returns: the time at which the target has been reset, or zero if it
+ *  is not reset, or if the date was not set then.
+ */
+time_t nwTargetResetTime( byte target )
+{
+	return( st_resetTime[target] );
+}
+
+/**
+ * nwTargetResetCount:
+ *
+ * Returns: the count of reset targets.
+ */
+byte nwTargetResetCount()
+{
+	byte count = 0;
+
+	for( byte i=0 ; i<NW_MAX_TARGET ; ++i ){
+		if( st_reset[i] ){
+			count += 1;
+		}
+	}
+	return( count );
+}
+
+/**
+ * nwTargetIsWatched:
+ * @channel: the channel number.
+ *
+ * Returns: whether the channel is started, and its target is not reset.
+ */
+bool nwTargetIsWatched( byte channel )
+{
+	return( nwChannelIsStarted( channel ) && !st_reset[st_bindings[channel]] );
+}
+
+/**
+ * nwTargetWatchedCount:
+ *
+ * Returns: the count of watched channels.
+ */
+byte nwTargetWatchedCount()
+{
+	byte count = 0;
+
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		if( nwTargetIsWatched( i )){
+			count += 1;
+		}
+	}
+	return( count );
+}
+
+/**
+ * nwTargetLeftMin:
+ *
+ * The expired channels of a reset target are left out, so that the
+ * other targets keep a meaningful deadline.
+ *
+ * Returns: the ms left before the soonest deadline of the watched
+ *  channels, or zero if there is none.
+ */
+unsigned long nwTargetLeftMin()
+{
+	unsigned long left = 0;
+	bool found = false;
+
+	for( byte i=0 ; i<NW_MAX_CHANNEL ; ++i ){
+		if( nwTargetIsWatched( i )){
+			unsigned long chleft = nwChannelLeft( i );
+			if( !found || chleft < left ){
+				left = chleft;
+				found = true;
+			}
+		}
+	}
+	return( left );
+}
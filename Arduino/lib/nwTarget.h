@@ -0,0 +1,98 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include <Time.h>           			/* to get the time_t definition */
+#include "nwChannel.h"
+#include "nwProfile.h"
+
+#ifndef __NWTARGET_H__
+#define __NWTARGET_H__
+
+/* The reset targets
+ *
+ * A target is a supervised host, reset by its own relay: a single
+ * board may so watch several hosts, each host pinging its own channel.
+ * Each channel is bound to a target, all the channels being bound to
+ * the first target by default, so that a missed deadline on any of the
+ * channels resets the PC as long as no other target is bound.
+ *
+ * Once reset, a target stays in the reset state, the pings of the
+ * channels which are bound to it being refused, until one of these
+ * channels is started again (e.g. by the rebooted host), or the whole
+ * watchdog is stopped.
+ *
+ * The target of a reset is recorded with the reset event, as a 2-bits
+ * field (see nwEEPROM.h).
+ */
+#define NW_MAX_TARGET            NW_PROFILE_MAX_TARGET	/* at most 4 */
+
+static_assert( NW_MAX_TARGET >= 1 && NW_MAX_TARGET <= 4,
+		"NW_PROFILE_MAX_TARGET must be in the 1..4 range" );
+
+/* the bindings are saved as 2 bits per channel in a single byte (see
+ * nwConfigStr and wdtState) */
+static_assert( 2*NW_MAX_CHANNEL <= 8,
+		"the target bindings do not fit in a byte: at most 4 channels" );
+
+/* set the relay pins as outputs, binding all the channels to the first
+ * target, which are all not reset */
+void          nwTargetSetup      ();
+
+/* the pin of the relay of the target */
+int           nwTargetPin        ( byte target );
+
+/* the target the channel is bound to */
+void          nwTargetBind       ( byte channel, byte target );
+byte          nwTargetOf         ( byte channel );
+
+/* the bindings of all the channels packed as 2-bits fields, bits
+ * 2n+1..2n being the target of channel n, as saved in the EEPROM */
+byte          nwTargetBindingsGet();
+void          nwTargetBindingsSet( byte bindings );
+
+/* activate the reset state of the target at the current date
+ * returns false if the target was already reset */
+bool          nwTargetReset      ( byte target );
+
+/* leave the reset state of the target; idempotent */
+void          nwTargetClear      ( byte target );
+
+/* whether the target is in its reset state */
+bool          nwTargetIsReset    ( byte target );
+
+/* now() when the target has been reset, zero if it is not reset */
+time_t        nwTargetResetTime  ( byte target );
+
+/* the count of reset targets */
+byte          nwTargetResetCount ();
+
+/* whether the channel is started and its target is not reset */
+bool          nwTargetIsWatched  ( byte channel );
+
+/* the count of watched channels, and the ms left before the soonest
+ * of their deadlines */
+byte          nwTargetWatchedCount();
+unsigned long nwTargetLeftMin    ();
+
+#endif /* __NWTARGET_H__ */
@@ -0,0 +1,156 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#include "NanoWatchdog.h"
+#include <avr/wdt.h>
+
+#ifdef __AVR__
+/* not zeroed by the C runtime, so that it survives a reset */
+#define NW_NOINIT                __attribute__(( section( ".noinit" )))
+#else
+#define NW_NOINIT
+#endif
+
+static byte st_resetFlags NW_NOINIT;
+static byte st_save[NW_WDT_SAVE_SIZE+2] NW_NOINIT;	/* size, data, crc */
+
+#ifdef __AVR__
+/*
+ * nwWdtCapture:
+ *
+ * Run from the .init3 section, i.e. before the .bss is cleared and
+ * before the constructors: copy the reset flags of the MCU, and clear
+ * them along with the watchdog timer, which would else stay armed with
+ * its shortest period after having fired.
+ *
+ * Optiboot clears MCUSR before starting the sketch, but passes its
+ * value in r2.
+ */
+void nwWdtCapture() __attribute__(( naked, used, section( ".init3" )));
+void nwWdtCapture()
+{
+	byte flags = MCUSR;
+	if( !flags ){
+		__asm__ __volatile__( "mov %0, r2" : "=r"( flags ));
+	}
+	st_resetFlags = flags;
+	MCUSR = 0;
+	wdt_disable();
+}
+#endif
+
+/*
+ * nwWdtCrc:
+ *
+ * Returns: the CRC-8 of the saved state.
+ */
+static byte nwWdtCrc()
+{
+	byte crc = 0;
+	for( byte i=0 ; i<=st_save[0] ; ++i ){
+		crc = nwCrc8( crc, st_save[i] );
+	}
+	return( crc );
+}
+
+/**
+ * nwWdtSetup:
+ *
+ * Arm the watchdog timer.
+ */
+void nwWdtSetup()
+{
+#ifndef __AVR__
+	st_resetFlags = 0;
+#endif
+	wdt_enable( WDTO_4S );
+}
+
+/**
+ * nwWdtKick:
+ *
+ * Restart the period of the watchdog timer.
+ */
+void nwWdtKick()
+{
+	wdt_reset();
+}
+
+/**
+ * nwWdtResetFlags:
+ *
+ * Returns: the reset flags of the MCU (the MCUSR register) at startup.
+ */
+byte nwWdtResetFlags()
+{
+	return( st_resetFlags );
+}
+
+/**
+ * nwWdtHasFired:
+ *
+ * Returns: true if the MCU has been reset by its watchdog timer.
+ */
+bool nwWdtHasFired()
+{
+#ifdef __AVR__
+	return( st_resetFlags & _BV( WDRF ));
+#else
+	return( false );
+#endif
+}
+
+/**
+ * nwWdtSave:
+ * @data: the state to be saved.
+ * @size: the size of the state, at most NW_WDT_SAVE_SIZE.
+ *
+ * Save the state into the RAM area which survives a reset; this only
+ * costs RAM writes, and may so be done as often as needed.
+ */
+void nwWdtSave( const void *data, byte size )
+{
+	if( size <= NW_WDT_SAVE_SIZE ){
+		st_save[0] = size;
+		memcpy( st_save+1, data, size );
+		st_save[size+1] = nwWdtCrc();
+	}
+}
+
+/**
+ * nwWdtRestore:
+ * @data: [out] the restored state.
+ * @size: the size of the state.
+ *
+ * Returns: true if a state of this size has been saved before the
+ * reset, and is left intact, false else.
+ */
+bool nwWdtRestore( void *data, byte size )
+{
+	if( size > NW_WDT_SAVE_SIZE || st_save[0] != size || st_save[size+1] != nwWdtCrc()){
+		return( false );
+	}
+	memcpy( data, st_save+1, size );
+	return( true );
+}
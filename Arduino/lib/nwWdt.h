@@ -0,0 +1,66 @@
+/*
+ * NanoWatchdog
+ * An Arduino Nano based PC watchdog.
+ *
+ * Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser@trychlos.org>
+ *
+ * NanoWatchdog is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * NanoWatchdog is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with NanoWatchdog; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Pierre Wieser <pwieser@trychlos.org>
+ */
+
+#ifndef __NWWDT_H__
+#define __NWWDT_H__
+
+/* The supervision of the firmware by the watchdog timer of the MCU
+ *
+ * nwWdtSetup() arms the watchdog timer of the ATmega, which must then
+ * be kicked with nwWdtKick() more often than each NW_WDT_PERIOD ms:
+ * loop() kicks it on each iteration, and the few paths which may last
+ * longer kick it on each of their steps (e.g. each EEPROM byte write,
+ * each dumped event). If the firmware ever wedges, the MCU resets
+ * itself.
+ *
+ * The reset flags of the MCU are captured at the very start of the
+ * firmware, before the C++ initialization, so that the firmware knows
+ * whether it restarts because of its own watchdog.
+ *
+ * A small state may be saved with nwWdtSave() into a RAM area which is
+ * not initialized at startup: it survives a reset of the MCU (though
+ * not a power cycle), and may be read back with nwWdtRestore() after a
+ * reset by the watchdog. It is protected by a CRC-8.
+ *
+ * All of this is only available on the AVR: on other targets, the
+ * watchdog timer never fires.
+ */
+#define NW_WDT_PERIOD            4000	/* ms, see WDTO_4S */
+#define NW_WDT_SAVE_SIZE         32		/* max size of the saved state */
+
+/* arm the watchdog timer, and kick it */
+void nwWdtSetup   ();
+void nwWdtKick    ();
+
+/* the reset flags of the MCU (MCUSR) at startup */
+byte nwWdtResetFlags();
+
+/* whether the MCU has been reset by its watchdog timer */
+bool nwWdtHasFired();
+
+/* save and restore the state kept across a reset */
+void nwWdtSave    ( const void *data, byte size );
+bool nwWdtRestore ( void *data, byte size );
+
+#endif /* __NWWDT_H__ */
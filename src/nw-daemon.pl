@@ -28,12 +28,15 @@ use Device::SerialPort;
 use File::Basename;
 use File::Find;
 use Getopt::Long;
+use IO::Select;
 use IO::Socket::INET;
 use MIME::Lite;
 use POSIX;
 use Proc::Daemon;
+use Socket;
 use Sys::Hostname;
 use Sys::Syslog qw(:standard :macros);
+use Time::HiRes;
 
 use constant { true => 1, false => 0 };
 
@@ -121,16 +124,41 @@ my $parms = {
 	'action'		=> { 'type'			=> PARM_TYPE_BOOL,
 						 'category'		=> PARM_CATEGORY_RUN,
 						 'def'			=> true },
+	# whether the board starts by itself at power-up: on or off
+	'autostart'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "off",
+						 'config'		=> "autostart" },
+	# grace period (secs.) added to the first deadline after an autostart
+	'autostartgrace'	=> { 'type'			=> PARM_TYPE_INT,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> 60,
+						 'min'			=> 0,
+						 'max'			=> 3600,
+						 'config'		=> "autostart-grace" },
 	# board serial bus baud rate (bps)
 	'baudrate'		=> { 'type'			=> PARM_TYPE_INT,
 						 'category'		=> PARM_CATEGORY_BOARD,
 						 'def'			=> 19200,
 						 'config'		=> "baudrate" },
+	# the daemon which owns the board, as host:port of its listener
+	# communication proxy, when the board is shared with other hosts
+	'boardhost'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "",
+						 'config'		=> "board-host" },
 	# port number of the listener communication proxy to the board
 	'boardport'		=> { 'type'			=> PARM_TYPE_INT,
 						 'category'		=> PARM_CATEGORY_LISTENER,
 						 'def'			=> 7777,
 						 'config'		=> "port-serial" },
+	# the channel of the board pinged by this host
+	'channel'		=> { 'type'			=> PARM_TYPE_INT,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> 0,
+						 'min'			=> 0,
+						 'max'			=> 3,
+						 'config'		=> "channel" },
 	# nanowatchdog configuration file
 	'config'		=> { 'type'			=> PARM_TYPE_STRING,
 						 'category'		=> PARM_CATEGORY_RUN,
@@ -151,6 +179,11 @@ my $parms = {
 						 'min'			=> 10,
 						 'max'			=> 3600,
 						 'config'		=> "delay" },
+	# whether the board sends asynchronous notifications: on or off
+	'events'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "on",
+						 'config'		=> "events" },
 	# device filename
 	'device'		=> { 'type'			=> PARM_TYPE_STRING,
 						 'category'		=> PARM_CATEGORY_BOARD,
@@ -164,6 +197,17 @@ my $parms = {
 	'help'			=> { 'type'			=> PARM_TYPE_BOOL,
 						 'category'		=> PARM_CATEGORY_RUN,
 						 'def'			=> false },
+	# where to keep the sequence number of the last synced reset event,
+	# and the identifier of its reset log
+	'historyfile'	=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_CONFIG,
+						 'def'			=> "",
+						 'config'		=> "history-file" },
+	# where to append the synced reset events
+	'historylog'	=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_CONFIG,
+						 'def'			=> "",
+						 'config'		=> "history-log" },
 	# include another configuration file (e.g. /etc/watchdog.conf)
 	'include'		=> { 'type'			=> PARM_TYPE_STRING,
 						 'category'		=> PARM_CATEGORY_CONFIG,
@@ -239,21 +283,63 @@ my $parms = {
 						 'category'		=> PARM_CATEGORY_BOARD,
 						 'def'			=> 10,
 						 'config'		=> "open-timeout" },
+	# interval (secs.) between two reads of the board performance
+	# counters, zero to disable
+	'perfinterval'	=> { 'type'			=> PARM_TYPE_INT,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> 60,
+						 'min'			=> 0,
+						 'max'			=> 3600,
+						 'config'		=> "perf-interval" },
 	# list of PID filenames to check
 	'pidfile'		=> { 'type'			=> PARM_TYPE_STRING,
 						 'category'		=> PARM_CATEGORY_WATCHDOG,
 						 'def'			=> [],
 						 'config'		=> "pidfile" },
+	# communication protocol with the board: text or binary
+	'protocol'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "text",
+						 'config'		=> "protocol" },
+	# how to ping the board: command or heartbeat
+	'pingmode'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "command",
+						 'config'		=> "ping-mode" },
+	# the reset relay of the board which resets this host
+	'target'		=> { 'type'			=> PARM_TYPE_INT,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> 0,
+						 'min'			=> 0,
+						 'max'			=> 3,
+						 'config'		=> "target" },
+	# whether the command pings synchronize the date of the board
+	'timesync'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "on",
+						 'config'		=> "time-sync" },
 	# list of ipv4 to check
 	'ping'			=> { 'type'			=> PARM_TYPE_STRING,
 						 'category'		=> PARM_CATEGORY_WATCHDOG,
 						 'def'			=> [],
 						 'config'		=> "ping" },
+	# max time to wait for the answers of the pinged hosts
+	'pingtimeout'	=> { 'type'			=> PARM_TYPE_INT,
+						 'category'		=> PARM_CATEGORY_WATCHDOG,
+						 'def'			=> 2,
+						 'min'			=> 1,
+						 'max'			=> 30,
+						 'config'		=> "ping-timeout" },
 	# timeout when reading from the board
 	'readtimeout'	=> { 'type'			=> PARM_TYPE_INT,
 						 'category'		=> PARM_CATEGORY_BOARD,
 						 'def'			=> 5,
 						 'config'		=> "read-timeout" },
+	# where to record the bytes sent to the board (see Arduino/bench)
+	'record'		=> { 'type'			=> PARM_TYPE_STRING,
+						 'category'		=> PARM_CATEGORY_BOARD,
+						 'def'			=> "",
+						 'config'		=> "record-file" },
 	# the emitter of the mail
 	'sendfrom'		=> { 'type'			=> PARM_TYPE_STRING,
 						 'category'		=> PARM_CATEGORY_CONFIG,
@@ -343,6 +429,33 @@ my $options = [
 	{ 'device'		=> { 'template'	=> '=/path/to/device',
 						 'help'		=> "the serial bus to talk with",
 						 'parm'		=> "device" }},
+	{ 'protocol'	=> { 'template'	=> '=text|binary',
+						 'help'		=> "the protocol to talk with the board",
+						 'parm'		=> "protocol" }},
+	{ 'events'		=> { 'template'	=> '=on|off',
+						 'help'		=> "whether the board sends asynchronous notifications",
+						 'parm'		=> "events" }},
+	{ 'autostart'	=> { 'template'	=> '=on|off',
+						 'help'		=> "whether the board starts by itself at power-up, with the current configuration",
+						 'parm'		=> "autostart" }},
+	{ 'autostart-grace'	=> { 'template'	=> '=number',
+						 'help'		=> "grace period (secs.) added to the first deadline after an autostart",
+						 'parm'		=> "autostartgrace" }},
+	{ 'perf-interval'	=> { 'template'	=> '=number',
+						 'help'		=> "interval (secs.) between two reads of the board performance counters",
+						 'parm'		=> "perfinterval" }},
+	{ 'record-file'	=> { 'template'	=> "=/path/to/filename",
+						 'help'		=> "record the bytes sent to the board, to be replayed by nw-bench",
+						 'parm'		=> "record" }},
+	{ 'board-host'	=> { 'template'	=> '=host:port',
+						 'help'		=> "talk with the board through the daemon which owns it, when it is shared",
+						 'parm'		=> "boardhost" }},
+	{ 'channel'		=> { 'template'	=> '=number',
+						 'help'		=> "the channel of the board pinged by this host",
+						 'parm'		=> "channel" }},
+	{ 'target'		=> { 'template'	=> '=number',
+						 'help'		=> "the reset relay of the board which resets this host",
+						 'parm'		=> "target" }},
 	# TCP listener
 	{ 'ip'			=> { 'template'	=> '=1.2.3.4',
 						 'help'		=> "IP address the TCP server must listen to for commands",
@@ -362,6 +475,12 @@ my $options = [
 						 'parm'		=> "interval" }},
 	{ 'ping'		=> { 'help'		=> "whether to ping the NanoWatchdog on wake",
 						 'parm'		=> "nwping" }},
+	{ 'ping-mode'	=> { 'template'	=> '=command|heartbeat',
+						 'help'		=> "how to ping the NanoWatchdog",
+						 'parm'		=> "pingmode" }},
+	{ 'time-sync'	=> { 'template'	=> '=on|off',
+						 'help'		=> "whether the command pings synchronize the date of the board",
+						 'parm'		=> "timesync" }},
 	# watchdog specific options
 	# not all watchdog configuration parameters may be specified as a
 	# command-line option - see man watchdog for more information
@@ -430,10 +549,73 @@ use constant {
 my $daemon_socket = undef;
 my $board_socket = undef;
 my $serial = undef;
+my $remote = false;						# whether the board is owned by another daemon (see board-host)
 my $background = false;
 my $have_to_quit = false;
 my $reason_code = 0;
 my $board_status = undef;
+my $board_perf = undef;					# the last PERF answer, appended to the status file
+my $binary = false;						# whether the board talks the binary protocol
+my $heartbeats = 0;						# count of not yet acknowledged heartbeats
+my $notify_buffer = "";					# received data not yet part of a notification
+my $status_dirty = false;				# whether a notification requires to rewrite the status
+my $status_seq = undef;					# the board status sequence number (see STATUS SINCE)
+my $status_boot = undef;				# the board startup this sequence number is about
+my $status_title = "";					# the title line of the last full STATUS
+my @status_blocks = ();					# the last known status, as [ field, lines ] array refs
+my @timers = ();						# the timers of the main loop (see timer_add)
+my $loop_tick = 0;						# count of interval ticks since the last log
+my $ping_last = 0;						# Time::HiRes::time() of the last ping of the board
+my %probe_files = ();					# the kept opened proc and sys files, by path
+my @thermal_files = ();					# the temperature files found by checks_init()
+my $icmp_socket = undef;				# the raw ICMP socket, if allowed to open it
+my $icmp_seq = 0;						# sequence number of the last ICMP echo request
+my $ping_probe = undef;					# the running ping probe (see ping_start)
+my $record_last = undef;				# the time of the last recorded write to the board
+
+# the baud rates accepted by the board, in the order they are tried when
+# the board doesn't answer at the configured one (see SET BAUD)
+use constant BOARD_BAUD_RATES => ( 19200, 115200, 250000, 57600, 38400, 9600 );
+
+# the max length of a command line accepted by the board, and so of a
+# batch of ';'-separated commands (see Arduino/NanoWatchdog.ino)
+use constant BOARD_MAX_COMMAND => 80;
+
+# the min date accepted by 'PING <date>', the lesser values being
+# channels (see Arduino/lib/nwClock.h)
+use constant BOARD_MIN_DATE => 1000000000;
+
+# single-byte heartbeat (see Arduino/lib/NanoWatchdog.h)
+use constant {
+	HEARTBEAT           => 0x05,
+	HEARTBEAT_ACK       => 0x06,
+	HEARTBEAT_NAK       => 0x15,
+};
+
+# binary protocol (see Arduino/lib/nwBinary.h)
+use constant {
+	BIN_SOF             => 0xA5,
+	BIN_OP_PING         => 0x01,
+	BIN_OP_STATUS       => 0x02,
+	BIN_OP_REBOOT       => 0x03,
+	BIN_OP_ACKNOWLEDGE  => 0x04,
+	BIN_OP_EEPROM_DUMP  => 0x05,
+	BIN_OP_NOOP         => 0x06,
+	BIN_OP_PERF         => 0x07,
+	BIN_OP_TEXT         => 0x0F,
+	BIN_OP_EVENT        => 0x10,
+	BIN_OP_NOTIFY       => 0x11,
+	BIN_OP_REPLY        => 0x80,
+	BIN_OP_ERROR        => 0xFF,
+	BIN_FLAG_TEST       => 1 << 0,
+	BIN_FLAG_DATE_SET   => 1 << 1,
+	BIN_FLAG_STARTED    => 1 << 2,
+	BIN_FLAG_RESET      => 1 << 3,
+};
+
+# asynchronous notifications, indexed by their code (see
+# Arduino/lib/nwNotify.h)
+use constant NOTIFY_NAMES => ( undef, "START", "STOP", "DEADLINE", "RESET", "EEPROM", "LOST" );
 
 # ---------------------------------------------------------------------
 # handle HUP signal
@@ -441,6 +623,7 @@ sub catch_hup(){
 	msg "HUP signal handler: reloading the configuration file ".$parms->{'config'}{'value'};
 	if( config_read( $parms, $parms->{'config'}{'value'} )){
 		config_dump( $parms ) if $$opt_verbose & LOG_CONFIG_HUP;
+		checks_init();
 	}
 }
 
@@ -456,8 +639,10 @@ sub catch_int(){
 # program termination
 sub catch_term(){
 	if( defined( $serial )){
-		send_serial( "STOP" );
+		send_serial( channel_command( "STOP" ));
 		$serial->close();
+	} elsif( $remote ){
+		send_serial( channel_command( "STOP" ));
 	}
 	$board_socket->close() if defined( $board_socket );
 	$daemon_socket->close() if defined( $daemon_socket );
@@ -469,8 +654,8 @@ sub catch_term(){
 # handle USR1 signal
 sub catch_usr1(){
 	msg "USR1 signal handler: restart the NanoWatchdog";
-	if( defined( $serial )){
-		send_serial( "STOP" );
+	if( defined( $serial ) || $remote ){
+		send_serial( channel_command( "STOP" ));
 		sleep( 1 );
 		start_watchdog();
 	}
@@ -1066,10 +1251,9 @@ sub parse_verbose( $ ){
 # get the answer from the serial (if opened)
 # send the answer to the client through the TCP socket
 sub read_board_command( $ ){
-	my $local_socket = shift;
+	my $client = shift;
 	my $data;
-    my $client = read_command( $local_socket, \$data );
-    if( defined( $client )){
+    if( read_command( $client, \$data )){
 	    my $answer;
 	    if( $parms->{'serial'}{'value'} ){
 			$answer = send_serial( $data );
@@ -1084,10 +1268,9 @@ sub read_board_command( $ ){
 # management daemon command interface
 # get a daemon command from TCP socket (from an external client)
 sub read_daemon_command( $ ){
-	my $local_socket = shift;
+	my $client = shift;
 	my $data;
-    my $client = read_command( $local_socket, \$data );
-    if( defined( $client )){
+    if( read_command( $client, \$data )){
 	    my $answer = "";
 		if( $data =~ /^\s*DUMP\s+OPTS\s*$/ ){
 			my @tmp_array = ();
@@ -1141,26 +1324,34 @@ sub read_daemon_command( $ ){
 }
 
 # ---------------------------------------------------------------------
-# get a command from TCP socket (from an external client)
-# returns a handle to the client
-sub read_command( $$ ){
+# accept a client connection on a listening TCP socket
+# returns a handle to the client, or undef
+sub accept_client( $ ){
 	my $local_socket = shift;			# socket to listen to
-	my $local_data = shift;				# ref to the output data
-	my $out_client = undef;
-    if( $out_client = $local_socket->accept()){
+	my $out_client = $local_socket->accept();
+    if( defined( $out_client )){
 	    # get information about the newly connected client
 	    my $client_address = $out_client->peerhost();
 	    my $client_port = $out_client->peerport();
 	    msg( "connection from $client_address:$client_port" ) if $$opt_verbose & LOG_CLIENT_DEBUG2;
-
-	    # read up to 4096 characters from the connected client
-	    $$local_data = "";
-	    $out_client->recv( $$local_data, 4096 );
-	    msg( "received data from listener socket: '$$local_data'" ) if $$opt_verbose & LOG_CLIENT_DEBUG2;
     }
     return( $out_client );
 }
 
+# ---------------------------------------------------------------------
+# get a command from an accepted client, once it is readable
+# returns true if a command has been received
+sub read_command( $$ ){
+	my $local_client = shift;			# the connected client
+	my $local_data = shift;				# ref to the output data
+
+    # read up to 4096 characters from the connected client
+    $$local_data = "";
+    $local_client->recv( $$local_data, 4096 );
+    msg( "received data from listener socket: '$$local_data'" ) if $$opt_verbose & LOG_CLIENT_DEBUG2;
+    return( length( $$local_data ) > 0 );
+}
+
 # ---------------------------------------------------------------------
 # Compute the default value of send-from
 sub send_from_def(){
@@ -1183,33 +1374,407 @@ sub write_answer( $$ ){
 }
 
 # ---------------------------------------------------------------------
-# send a '\n'-terminated command on the serial bus
+# compute the CRC-8 (polynomial 0x07) of a binary string
+sub bin_crc8( $ ){
+	my $data = shift;
+	my $crc = 0;
+	foreach my $byte ( unpack( "C*", $data )){
+		$crc ^= $byte;
+		for( my $i=0 ; $i<8 ; ++$i ){
+			$crc = ( $crc & 0x80 ) ? (( $crc << 1 ) ^ 0x07 ) & 0xFF : ( $crc << 1 ) & 0xFF;
+		}
+	}
+	return( $crc );
+}
+
+# ---------------------------------------------------------------------
+# decode the frames received in answer to a command
+# returns the answer as the text protocol would have
+sub bin_decode( $$ ){
+	my $command = shift;
+	my $frames = shift;
+	my @lines = ();
+	my $status = 1;
+	foreach my $frame ( @$frames ){
+		my ( $op, $payload ) = @$frame;
+		if( $op == BIN_OP_EVENT ){
+			my ( $index, $time, $ack_reason ) = unpack( "CVC", $payload );
+			push( @lines, $index == 0xFF ? " Initialization event:" : " Reset event #$index" );
+			push( @lines, bin_event_lines( $time, $ack_reason ));
+		} elsif( $op & BIN_OP_REPLY ){
+			$status = unpack( "C", $payload );
+			if( $op == ( BIN_OP_STATUS | BIN_OP_REPLY ) && !$status ){
+				my ( $st, $flags, $delay, $left, $now, $time, $ack_reason, $delay_ms, $left_ms, $seq, $boot ) = unpack( "CCvl<VVCVl<Vv", $payload );
+				# millisecond values are only sent by boards since v11.2017
+				$delay = bin_delay_string( defined( $delay_ms ) ? $delay_ms : 1000*$delay );
+				$left = bin_delay_string( defined( $left_ms ) ? $left_ms : 1000*$left );
+				push( @lines, "[NanoWatchdog] - Current status:" );
+				push( @lines, " Sequence:       $seq" ) if defined( $seq );
+				push( @lines, " Boot:           $boot" ) if defined( $boot );
+				push( @lines, " Reset delay:    $delay" );
+				push( @lines, " Test mode:      ".(( $flags & BIN_FLAG_TEST ) ? "ON (test mode)" : "OFF (reset mode)" ));
+				push( @lines, " Date set:       ".(( $flags & BIN_FLAG_DATE_SET ) ? "yes" : "no" ));
+				# with several targets, the channels of the targets which
+				# are not reset are still watched
+				if( $flags & BIN_FLAG_RESET ){
+					push( @lines, " Status:         reset" );
+				} elsif( $flags & BIN_FLAG_STARTED ){
+					push( @lines, " Status:         started" );
+				} else {
+					push( @lines, " Status:         stopped" );
+				}
+				if( $flags & BIN_FLAG_STARTED ){
+					push( @lines, "   Now is:       ".bin_time_string( $now ));
+					push( @lines, "   Before reset: $left left" );
+				}
+				if( $time ){
+					push( @lines, " Last reset:   " );
+					push( @lines, bin_event_lines( $time, $ack_reason ));
+				} else {
+					push( @lines, " Last reset:   none" );
+				}
+			} elsif( $op == ( BIN_OP_PERF | BIN_OP_REPLY ) && !$status ){
+				my ( $st, $loops, $max, $avg, $rxfull, $dropped, $bad, $free, $eeprom, $margin, $channel, $total ) = unpack( "CVVvvvvvVVCV", $payload );
+				push( @lines, "[NanoWatchdog] - Performance counters:" );
+				push( @lines, " Loop: count=$loops, average=$avg us, max=$max us" );
+				push( @lines, " Free RAM: min=".( $free == 0xFFFF ? "unknown" : "$free bytes" ));
+				push( @lines, " Serial: rx full=$rxfull, dropped=$dropped, bad frames=$bad" );
+				push( @lines, " EEPROM: written=$eeprom bytes" );
+				push( @lines, " Margin: min=".( $margin == 0xFFFFFFFF ? "none" : "$margin ms, channel=$channel" ));
+				push( @lines, " Commands: total=$total" );
+			} elsif( $op == ( BIN_OP_EEPROM_DUMP | BIN_OP_REPLY ) && !$status ){
+				my ( $st, $count ) = unpack( "CC", $payload );
+				unshift( @lines, "[NanoWatchdog] - EEPROM dump:" );
+				push( @lines, " Reset events count:", "   count=$count" );
+			}
+		}
+	}
+	push( @lines, ( $status ? "Unknown or invalid command: " : "OK: " ).$command );
+	return( join( "\x0D\x0A", @lines ));
+}
+
+# ---------------------------------------------------------------------
+# returns the request frame corresponding to a text command, as an
+# [ opcode, payload ] array ref, or undef
+sub bin_encode( $ ){
+	my $command = shift;
+	return( [ BIN_OP_PING, "" ]) if $command eq "PING";
+	return( [ BIN_OP_PING, pack( "C", $1 )]) if $command =~ /^PING (\d+)$/ && $1 < 256;
+	return( [ BIN_OP_PING, pack( "CV", 0, $1 )]) if $command =~ /^PING (\d+)$/ && $1 >= BOARD_MIN_DATE;
+	return( [ BIN_OP_PING, pack( "CV", $1, $2 )]) if $command =~ /^PING (\d+) (\d+)$/ && $1 < 256;
+	return( [ BIN_OP_STATUS, "" ]) if $command eq "STATUS";
+	return( [ BIN_OP_EEPROM_DUMP, "" ]) if $command eq "EEPROM DUMP";
+	return( [ BIN_OP_NOOP, "" ]) if $command eq "NOOP";
+	return( [ BIN_OP_PERF, "" ]) if $command eq "PERF";
+	return( [ BIN_OP_PERF, pack( "C", 1 )]) if $command eq "PERF RESET";
+	return( [ BIN_OP_REBOOT, pack( "C", $1 )]) if $command =~ /^REBOOT (\d+)$/ && $1 < 256;
+	return( [ BIN_OP_REBOOT, pack( "CC", $2, $1 )]) if $command =~ /^REBOOT (\d+) (\d+)$/ && $1 < 256 && $2 < 256;
+	return( [ BIN_OP_ACKNOWLEDGE, pack( "C", $1 )]) if $command =~ /^ACKNOWLEDGE (\d+)$/ && $1 < 256;
+	return( undef );
+}
+
+# ---------------------------------------------------------------------
+# returns the lines which describe an event, as the text protocol does
+sub bin_event_lines( $$ ){
+	my $time = shift;
+	my $ack_reason = shift;
+	my $reason = $ack_reason & 0x7F;
+	my $label = "unknown reason code";
+	if( $reason == 0 ){
+		$label = "initialization";
+	} elsif( $reason == 1 ){
+		$label = "no ping";
+	} elsif( $reason == 2 ){
+		$label = "firmware watchdog reset";
+	} elsif( $reason >= 8 && $reason < 16 ){
+		$label = "no ping (channel ".( $reason-8 ).")";
+	} elsif( $reason >= 16 ){
+		$label = "external command";
+	}
+	return(
+		"   date:         ".bin_time_string( $time ),
+		"   reason:       $reason ($label)",
+		"   acknowledged: ".(( $ack_reason & 0x80 ) ? "yes" : "no" ));
+}
+
+# ---------------------------------------------------------------------
+# returns a delay (ms) as displayed by the board
+sub bin_delay_string( $ ){
+	my $delay = shift;
+	return(( $delay % 1000 ) ? "$delay ms" : ( $delay/1000 )." sec." );
+}
+
+# ---------------------------------------------------------------------
+# returns the 'yyyy-mm-dd hh:mi:ss UTC' string for a time_t value
+sub bin_time_string( $ ){
+	my $time = shift;
+	return( strftime( "%Y-%m-%d %H:%M:%S UTC", gmtime( $time )));
+}
+
+# ---------------------------------------------------------------------
+# send a command to the board, using the current protocol
+# when talking the binary protocol, commands which do not have a binary
+# counterpart are sent through the text protocol, switching back to the
+# binary protocol after
 # returns the ackownledgement received from the serial bus
 sub send_serial( $ ){
+	my $command = shift;
+	return( send_serial_text( $command )) if !$binary;
+	my $request = bin_encode( $command );
+	return( bin_decode( $command, send_serial_frame( $request->[0], $request->[1] ))) if defined( $request );
+	send_serial_frame( BIN_OP_TEXT, "" );
+	$binary = false;
+	my $answer = send_serial_text( $command );
+	set_protocol();
+	return( $answer );
+}
+
+# ---------------------------------------------------------------------
+# send several commands to the board, as batches of ';'-separated
+# commands which fit in a command line, so that each batch only costs
+# one round trip
+# the commands left unanswered, e.g. because the batch has been rejected
+# by a board which doesn't accept batches, or interrupted by a failing
+# command, are then sent one by one, as they are when talking the binary
+# protocol
+# returns the answers, one per command, as send_serial() does
+sub send_batch( @ ){
+	my @commands = @_;
+	return( map( send_serial( $_ ), @commands )) if $binary;
+	my @answers = ();
+	while( @commands ){
+		my @batch = ( shift( @commands ));
+		while( @commands && length( join( ';', @batch, $commands[0] )) <= BOARD_MAX_COMMAND ){
+			push( @batch, shift( @commands ));
+		}
+		if( @batch > 1 ){
+			# each command answer is terminated by its own 'OK:' line
+			my $text = "";
+			foreach my $line ( split( /\x0D\x0A/, send_serial_text( join( ';', @batch )))){
+				$text .= ( length( $text ) ? "\x0D\x0A" : "" ).$line;
+				if( @batch && $line eq "OK: $batch[0]" ){
+					push( @answers, $text );
+					$text = "";
+					shift( @batch );
+				}
+			}
+		}
+		push( @answers, map( send_serial( $_ ), @batch ));
+	}
+	return( @answers );
+}
+
+# ---------------------------------------------------------------------
+# append the bytes about to be written to the board to the record file,
+# as a stream which can be replayed by Arduino/bench/nw-bench: the
+# elapsed time since the previous write as a '@<ms>' line, then the
+# command line, or the hexadecimal bytes as a 'X <hex>...' line
+sub record_serial( $ ){
+	my $data = shift;
+	return if !length( $parms->{'record'}{'value'} );
+	my $now = Time::HiRes::time();
+	if( open( my $fh, '>>', $parms->{'record'}{'value'} )){
+		printf $fh "\@%d\n", 1000*( $now-$record_last ) if defined( $record_last );
+		if( $data =~ /^[\x20-\x7E]+\n$/ ){
+			print $fh $data;
+		} else {
+			print $fh "X ".join( " ", map { sprintf( "%02X", ord( $_ )) } split( //, $data ))."\n";
+		}
+		close( $fh );
+		$record_last = $now;
+	} else {
+		msg( "unable to open ".$parms->{'record'}{'value'}.": $!" );
+		$parms->{'record'}{'value'} = "";
+	}
+}
+
+# ---------------------------------------------------------------------
+# send a binary request frame on the serial bus
+# returns a ref to the array of received frames, up to and including
+# the reply, each frame being a [ opcode, payload ] array ref
+sub send_serial_frame( $$ ){
+	my $opcode = shift;
+	my $payload = shift;
+	my @frames = ();
+	msg( "sending frame to ".$parms->{'device'}{'value'}.": opcode=$opcode, length=".length( $payload ))
+			if $$opt_verbose & LOG_BOARD_DEBUG2;
+    if( $parms->{'serial'}{'value'} ){
+		my $body = pack( "CC", $opcode, length( $payload )).$payload;
+		record_serial( pack( "C", BIN_SOF ).$body.pack( "C", bin_crc8( $body )));
+		$serial->write( pack( "C", BIN_SOF ).$body.pack( "C", bin_crc8( $body )));
+		$serial->read_char_time(0);
+		$serial->read_const_time(10);
+		my $buffer = "";
+		my $done = false;
+		my $timeout = 10*$parms->{'readtimeout'}{'value'};
+		while( !$done && $timeout>0 ){
+	        my ( $count,$saw ) = $serial->read( 255 );
+	        if( $count > 0 ){
+				$buffer .= $saw;
+				while( !$done ){
+					$buffer =~ s/^([^\xA5]+)// and heartbeat_answers( $1 );
+					last if length( $buffer ) < 4;
+					my $total = 4+ord( substr( $buffer, 2, 1 ));
+					last if length( $buffer ) < $total;
+					my $frame = substr( $buffer, 0, $total, "" );
+					my $crc = ord( substr( $frame, -1 ));
+					if( $crc == bin_crc8( substr( $frame, 1, $total-2 ))){
+						my $op = ord( substr( $frame, 1, 1 ));
+						if( $op == BIN_OP_NOTIFY ){
+							bin_notify( substr( $frame, 3, $total-4 ));
+							next;
+						}
+						push( @frames, [ $op, substr( $frame, 3, $total-4 )]);
+						$done = ( $op == ( $opcode | BIN_OP_REPLY ) || $op == BIN_OP_ERROR );
+					} else {
+						msg( "bad CRC in frame received from ".$parms->{'device'}{'value'} )
+								if $$opt_verbose & LOG_BOARD_DEBUG1;
+					}
+				}
+			} else {
+				$timeout--;
+			}
+		}
+		msg( "received ".scalar( @frames )." frame(s) from ".$parms->{'device'}{'value'} )
+				if $$opt_verbose & LOG_BOARD_DEBUG2;
+    }
+	return( \@frames );
+}
+
+# ---------------------------------------------------------------------
+# send a single-byte heartbeat to the board, without waiting for its
+# answer: the answers are consumed when sending the next heartbeat, or
+# when reading the answer of another command
+sub send_heartbeat(){
+    if( $parms->{'serial'}{'value'} ){
+		read_notifications();
+		msg( "$heartbeats heartbeat(s) not acknowledged by ".$parms->{'device'}{'value'} )
+				if $heartbeats > 2 && $$opt_verbose & LOG_BOARD_DEBUG1;
+		record_serial( pack( "C", HEARTBEAT ));
+		$serial->write( pack( "C", HEARTBEAT ));
+		$heartbeats += 1;
+	}
+}
+
+# ---------------------------------------------------------------------
+# count the heartbeat answers found in the received data
+# returns the data without them
+sub heartbeat_answers( $ ){
+	my $data = shift;
+	my $acks = ( $data =~ tr/\x06// );
+	my $naks = ( $data =~ tr/\x15// );
+	if( $acks+$naks > 0 ){
+		$heartbeats = ( $heartbeats > $acks+$naks ) ? $heartbeats-$acks-$naks : 0;
+		msg( "heartbeat refused by ".$parms->{'device'}{'value'}.": watchdog not started" ) if $naks;
+		$data =~ tr/\x06\x15//d;
+	}
+	return( $data );
+}
+
+# ---------------------------------------------------------------------
+# handle an asynchronous notification sent by the board
+# the reset and the near-misses are always logged
+sub board_notify( $$$ ){
+	my $name = shift;
+	my $channel = shift;
+	my $value = shift;
+	if( $name eq "DEADLINE" && $value >= 90 ){
+		msg( "near-miss: channel $channel of ".$parms->{'device'}{'value'}." not pinged for ${value}% of its delay" );
+	} elsif( $name eq "RESET" ){
+		msg( "reset activated by ".$parms->{'device'}{'value'}." (reason $value)" );
+	} elsif( $name eq "LOST" ){
+		msg( "$value notification(s) lost by ".$parms->{'device'}{'value'} );
+	} else {
+		msg( "notification received from ".$parms->{'device'}{'value'}.": $name $channel $value" )
+				if $$opt_verbose & LOG_BOARD_INFO;
+	}
+	$status_dirty = true if $name eq "START" || $name eq "STOP" || $name eq "RESET" || $name eq "EEPROM";
+}
+
+# ---------------------------------------------------------------------
+# handle a NOTIFY frame payload
+sub bin_notify( $ ){
+	my ( $code, $channel, $value ) = unpack( "CCV", shift );
+	my $name = ( NOTIFY_NAMES )[$code];
+	board_notify( $name, $channel == 0xFF ? "-" : $channel, $value ) if defined( $name );
+}
+
+# ---------------------------------------------------------------------
+# handle the notification lines found in the received text
+# returns the text without them
+sub notify_lines( $ ){
+	my $data = shift;
+	while( $data =~ s/(^|\x0D\x0A)! (\w+) (\S+) (\d+)\x0D\x0A/$1/ ){
+		board_notify( $2, $3, $4 );
+	}
+	return( $data );
+}
+
+# ---------------------------------------------------------------------
+# read, without blocking, what the board has sent outside of any answer,
+# i.e. the notifications and the heartbeat answers
+sub read_notifications(){
+    if( $parms->{'serial'}{'value'} ){
+		$serial->read_char_time(0);
+		$serial->read_const_time(0);
+		my ( $count,$saw ) = $serial->read( 255 );
+		return if !$count && !length( $notify_buffer );
+		$notify_buffer .= heartbeat_answers( $saw ) if $count > 0;
+		if( $binary ){
+			while( true ){
+				$notify_buffer =~ s/^[^\xA5]+//;
+				last if length( $notify_buffer ) < 4;
+				my $total = 4+ord( substr( $notify_buffer, 2, 1 ));
+				last if length( $notify_buffer ) < $total;
+				my $frame = substr( $notify_buffer, 0, $total, "" );
+				if( ord( substr( $frame, -1 )) == bin_crc8( substr( $frame, 1, $total-2 )) &&
+						ord( substr( $frame, 1, 1 )) == BIN_OP_NOTIFY ){
+					bin_notify( substr( $frame, 3, $total-4 ));
+				}
+			}
+		} else {
+			$notify_buffer = notify_lines( $notify_buffer );
+			# drop the other complete lines, only keeping a partial one
+			$notify_buffer =~ s/^.*\x0D\x0A//s;
+		}
+	}
+}
+
+# ---------------------------------------------------------------------
+# send a '\n'-terminated command on the serial bus
+# returns the ackownledgement received from the serial bus
+sub send_serial_text( $ ){
     my $command = shift;
+	return( send_remote( $command )) if $remote;
 	my $buffer = "";
 	msg( "sending command to ".$parms->{'device'}{'value'}.": '$command'" )
 			if $$opt_verbose & LOG_BOARD_DEBUG2;
     if( $parms->{'serial'}{'value'} ){
 		# send the command
+		record_serial( "$command\n" );
 	    my $out_count = $serial->write( "$command\n" );
 	    msg( "${out_count} chars written to ".$parms->{'device'}{'value'} )
 				if $$opt_verbose & LOG_BOARD_DEBUG2;
 
 	    # receives the answer
+	    # returns as soon as the end-of-response marker ('.' or '..' line)
+	    # has been received, only waiting for the whole read timeout
+	    # (unit is 100 ms) with boards which do not send it
 		$serial->read_char_time(0);     # don't wait for each character
-		$serial->read_const_time(100);  # 100 ms per unfulfilled "read" call
+		$serial->read_const_time(10);   # 10 ms per unfulfilled "read" call
 		my $chars = 0;
-		my $timeout = $parms->{'readtimeout'}{'value'};
+		my $timeout = 10*$parms->{'readtimeout'}{'value'};
 		while( $timeout>0 ){
 	        my ( $count,$saw ) = $serial->read( 255 );	# will read _up to_ 255 chars
 	        if( $count > 0 ){
 				$chars += $count;
-				$buffer .= $saw;
+				$buffer = notify_lines( $buffer.heartbeat_answers( $saw ));
+				last if $buffer =~ /(^|\x0D\x0A)\.\.?\x0D\x0A$/;
 			} else {
 				$timeout--;
 			}
 		}
+		$buffer =~ s/(^|\x0D\x0A)\.\.?\x0D\x0A$//;
 		$buffer =~ s/\x0D\x0A$//;
 		msg( "received '$buffer' ($chars chars) answer from ".$parms->{'device'}{'value'} )
 				if $$opt_verbose & LOG_BOARD_DEBUG2;
@@ -1217,6 +1782,164 @@ sub send_serial( $ ){
     return( $buffer );
 }
 
+# ---------------------------------------------------------------------
+# send a command to a shared board, through the listener communication
+# proxy of the daemon which owns it (see board-host), which answers
+# each connection with the answer of the board to its command
+# returns the answer, as send_serial_text() does
+sub send_remote( $ ){
+	my $command = shift;
+	my $buffer = "";
+	msg( "sending command to ".$parms->{'boardhost'}{'value'}.": '$command'" )
+			if $$opt_verbose & LOG_BOARD_DEBUG2;
+	my $socket = new IO::Socket::INET (
+		PeerAddr => $parms->{'boardhost'}{'value'},
+		Proto => 'tcp',
+		Timeout => $parms->{'readtimeout'}{'value'} );
+	if( !defined( $socket )){
+		msg( "unable to connect to ".$parms->{'boardhost'}{'value'}.": $!" ) if $$opt_verbose & LOG_BOARD_DEBUG1;
+		return( $buffer );
+	}
+	$socket->send( $command );
+	my $select = IO::Select->new( $socket );
+	my $deadline = Time::HiRes::time()+$parms->{'readtimeout'}{'value'};
+	while( $select->can_read( $deadline-Time::HiRes::time())){
+		my $data = "";
+		$socket->recv( $data, 4096 );
+		last if !length( $data );
+		$buffer .= $data;
+	}
+	$socket->close();
+	$buffer =~ s/\n$//;
+	msg( "received '$buffer' answer from ".$parms->{'boardhost'}{'value'} )
+			if $$opt_verbose & LOG_BOARD_DEBUG2;
+	return( $buffer );
+}
+
+# ---------------------------------------------------------------------
+# discover the probes of the checks, at startup and on HUP, so that the
+# checks done on each interval neither walk the sysfs nor fork
+# the raw ICMP socket requires root privileges: without it, the hosts
+# are pinged by ping(8) children
+sub checks_init(){
+	%probe_files = ();
+	@thermal_files = ();
+	find( sub { push( @thermal_files, $File::Find::name."/temp" ) if -r $File::Find::name."/temp" }, "/sys/class/thermal" )
+			if -d "/sys/class/thermal";
+	if( !defined( $icmp_socket ) && @{$parms->{'ping'}{'value'}} ){
+		if( !socket( $icmp_socket, PF_INET, SOCK_RAW, scalar( getprotobyname( 'icmp' )))){
+			msg( "unable to open a raw ICMP socket: $!, forking ping(8) to check the hosts" )
+					if $$opt_verbose & LOG_LOOP_DEBUG1;
+			$icmp_socket = undef;
+		}
+	}
+}
+
+# ---------------------------------------------------------------------
+# read a proc or sys file, keeping it opened between two reads, the
+# kernel regenerating its content when read again from the start
+# returns the content of the file, or undef
+sub probe_read( $ ){
+	my $path = shift;
+	my $fh = $probe_files{$path};
+	if( !defined( $fh ) || !seek( $fh, 0, 0 )){
+		open( $fh, '<', $path ) or return( undef );
+		$probe_files{$path} = $fh;
+	}
+	local $/ = undef;
+	return( scalar( <$fh> ));
+}
+
+# ---------------------------------------------------------------------
+# compute the checksum of an ICMP packet
+sub icmp_checksum( $ ){
+	my $data = shift;
+	$data .= "\0" if length( $data ) % 2;
+	my $sum = 0;
+	$sum += $_ foreach unpack( "n*", $data );
+	$sum = ( $sum >> 16 )+( $sum & 0xFFFF ) while $sum >> 16;
+	return( ~$sum & 0xFFFF );
+}
+
+# ---------------------------------------------------------------------
+# start pinging all the hosts at once, either by sending them an ICMP
+# echo request on the raw socket, or by forking a ping(8) for each one
+# their answers are then waited for by ping_wait()
+sub ping_start(){
+	ping_end();
+	return if !@{$parms->{'ping'}{'value'}};
+	my $timeout = $parms->{'pingtimeout'}{'value'};
+	$ping_probe = { 'deadline' => Time::HiRes::time()+$timeout, 'alive' => {}, 'seqs' => {}, 'pipes' => {} };
+	foreach my $host ( @{$parms->{'ping'}{'value'}} ){
+		$ping_probe->{'alive'}{$host} = false;
+		if( defined( $icmp_socket )){
+			my $addr = inet_aton( $host );
+			next if !defined( $addr );
+			$icmp_seq = ( $icmp_seq+1 ) & 0xFFFF;
+			my $packet = pack( "CCnnn", 8, 0, 0, $$ & 0xFFFF, $icmp_seq )."NanoWatchdog";
+			substr( $packet, 2, 2 ) = pack( "n", icmp_checksum( $packet ));
+			$ping_probe->{'seqs'}{$icmp_seq} = $host if send( $icmp_socket, $packet, 0, sockaddr_in( 0, $addr ));
+		} else {
+			my $pid = open( my $fh, "-|", "exec ping -c1 -W $timeout $host 2>&1" );
+			$ping_probe->{'pipes'}{$host} = [ $fh, $pid ] if $pid;
+		}
+	}
+}
+
+# ---------------------------------------------------------------------
+# wait for the answers of the pinged hosts, until all have answered or
+# the ping timeout is over, pinging the board meanwhile if needed
+# returns a ref to a hash host -> whether it is alive
+sub ping_wait(){
+	return( {} ) if !defined( $ping_probe );
+	while( %{$ping_probe->{'seqs'}} || %{$ping_probe->{'pipes'}} ){
+		my $left = $ping_probe->{'deadline'}-Time::HiRes::time();
+		last if $left <= 0;
+		my $select = IO::Select->new();
+		$select->add( $icmp_socket ) if %{$ping_probe->{'seqs'}};
+		$select->add( $_->[0] ) foreach values( %{$ping_probe->{'pipes'}} );
+		foreach my $handle ( $select->can_read( $left < 1 ? $left : 1 )){
+			if( defined( $icmp_socket ) && $handle == $icmp_socket ){
+				my $data;
+				next if !defined( recv( $icmp_socket, $data, 1500, 0 )) || !length( $data );
+				my $ihl = ( ord( $data ) & 0x0F )*4;
+				my ( $type, $code, $cksum, $id, $seq ) = unpack( "CCnnn", substr( $data, $ihl, 8 ));
+				if( $type == 0 && $id == ( $$ & 0xFFFF ) && defined( $ping_probe->{'seqs'}{$seq} )){
+					$ping_probe->{'alive'}{$ping_probe->{'seqs'}{$seq}} = true;
+					delete( $ping_probe->{'seqs'}{$seq} );
+				}
+			} else {
+				foreach my $host ( keys( %{$ping_probe->{'pipes'}} )){
+					my ( $fh, $pid ) = @{$ping_probe->{'pipes'}{$host}};
+					next if $fh != $handle;
+					my $output;
+					next if sysread( $fh, $output, 4096 );
+					# end of file: the exit status of the child is set by close()
+					close( $fh );
+					$ping_probe->{'alive'}{$host} = ( $? == 0 );
+					delete( $ping_probe->{'pipes'}{$host} );
+				}
+			}
+		}
+		board_keepalive();
+	}
+	my $alive = $ping_probe->{'alive'};
+	ping_end();
+	return( $alive );
+}
+
+# ---------------------------------------------------------------------
+# terminate the ping probe, killing the ping(8) children still running
+sub ping_end(){
+	return if !defined( $ping_probe );
+	foreach( values( %{$ping_probe->{'pipes'}} )){
+		my ( $fh, $pid ) = @{$_};
+		kill( 'TERM', $pid );
+		close( $fh );
+	}
+	$ping_probe = undef;
+}
+
 # ---------------------------------------------------------------------
 # check specified interfaces
 # check that RX/TX are not zero
@@ -1230,15 +1953,9 @@ sub check_interface( $ ){
     } else {
 	    foreach( @{$parms->{'interface'}{'value'}} ){
 			if( !$reboot ){
-				my $ifconfig = `ifconfig $_ 2>&1`;
-				my $rx = 0;
-				my $tx = 0;
-				if( $ifconfig =~ m/.*RX packets ([0-9]+).*/ms ){
-					$rx = $1;
-				}
-				if( $ifconfig =~ m/.*TX packets ([0-9]+).*/ms ){
-					$tx = $1;
-				}
+				my $rx = probe_read( "/sys/class/net/$_/statistics/rx_packets" ) || 0;
+				my $tx = probe_read( "/sys/class/net/$_/statistics/tx_packets" ) || 0;
+				chomp( $rx, $tx );
 				$reboot = ( $rx+$tx == 0 );
 				msg( "interface=$_, rx=$rx, tx=$tx" )
 					if $reboot || (( $$opt_verbose & LOG_LOOP_DEBUG2 ) && $tick >= $parms->{'logtick'}{'value'} );
@@ -1265,10 +1982,8 @@ sub check_loadavg( $ ){
 			( defined( $parms->{'maxload5'}{'value'} ) && $parms->{'maxload5'}{'value'} > 0 ) ||
 			( defined( $parms->{'maxload15'}{'value'} ) && $parms->{'maxload15'}{'value'} > 0 )){
 
-	    open my $fh, "/proc/loadavg";
-	    if( defined( $fh )){
-			my $line = <$fh>;
-			close( $fh );
+	    my $line = probe_read( "/proc/loadavg" );
+	    if( defined( $line )){
 			chomp $line;
 			my ( $avg1, $avg5, $avg10, $processes, $lastpid ) = split( / /, $line );
 			if( defined( $parms->{'maxload1'}{'value'} ) &&
@@ -1316,20 +2031,12 @@ sub check_memory( $ ){
     my $tick = shift;
     my $reboot = false;
     if( $parms->{'memory'}{'value'} > 0 ){
-	    open my $fh, "/proc/meminfo";
-	    if( defined( $fh )){
-			my $line;
+	    my $meminfo = probe_read( "/proc/meminfo" );
+	    if( defined( $meminfo )){
 			my $swap_free = 0;
-			while( $line = <$fh> ){
-				chomp $line;
-				if( $line =~ /SwapFree:/ ){
-					my ( $label, $count, $unit ) = split( /\s+/, $line );
-					#msg( "label=${label} count=${count} unit=${unit}" );
-					$swap_free = $count / 4;
-					last;
-				}
+			if( $meminfo =~ /^SwapFree:\s+(\d+)/m ){
+				$swap_free = $1 / 4;
 			}
-			close( $fh );
 			$reboot = true if $swap_free < $parms->{'memory'}{'value'};
 			$reason_code = 19 if $reboot;
 			msg( " parm:min-memory=".$parms->{'memory'}{'value'}.", swap_free=$swap_free" )
@@ -1362,9 +2069,8 @@ sub check_pidfile( $ ){
 					my $pid = <$fh>;
 					close $fh;
 					chomp $pid;
-					# this only works for process with same UID
-					#my $exists = kill 0, $pid;
-					my $exists = ( system( "ps --pid $pid 1>/dev/null 2>&1" ) == 0 );
+					# kill 0 only works for process with same UID
+					my $exists = ( $pid =~ /^\d+$/ && -d "/proc/$pid" );
 					#print "pid=$pid, exists=".( $exists ? "true":"false" )."\n";
 					$reboot = !$exists;
 					msg( "pidfile=".$_.", pid=$pid, exists=".( $exists ? "true":"false" ))
@@ -1389,11 +2095,11 @@ sub check_ping( $ ){
 		msg( "ping(s) check is not enabled" )
 				if ( $$opt_verbose & LOG_LOOP_DEBUG1 ) && $tick >= $parms->{'logtick'}{'value'};
     } else {
+	    my $alive = ping_wait();
 	    foreach( @{$parms->{'ping'}{'value'}} ){
 			if( !$reboot ){
-				my $alive = ( system( "ping -c1 $_ 1>/dev/null 2>&1" ) == 0 );
-				$reboot = !$alive;
-				msg( "ipv4=$_, alive=".( $alive ? "true":"false" ))
+				$reboot = !$alive->{$_};
+				msg( "ipv4=$_, alive=".( $alive->{$_} ? "true":"false" ))
 					if $reboot || (( $$opt_verbose & LOG_LOOP_DEBUG2 ) && $tick >= $parms->{'logtick'}{'value'} );
 			}
 	    }
@@ -1412,31 +2118,21 @@ sub check_ping( $ ){
 sub check_temperature( $ ){
     my $tick = shift;
     my $reboot = false;
-    find( sub { check_temperature_wanted( $tick, \$reboot )}, "/sys/class/thermal" );
-    $reason_code = 20 if $reboot;
-    return( $reboot );
-}
-
-sub check_temperature_wanted( $$ ){
-	my $tick = shift;
-	my $reboot_ref = shift;
-	my $reboot_local = false;
-	my $ftemp = $File::Find::name."/temp";
-	if( -r $ftemp ){
-	    open my ( $fh ), $ftemp;
-	    if( defined( $fh )){
-			my $line = <$fh>;
-			close( $fh );
+    foreach my $ftemp ( @thermal_files ){
+		my $line = probe_read( $ftemp );
+	    if( defined( $line )){
 			chomp $line;
 			$line /= 1000;
-			$reboot_local = ( $line > $parms->{'temperature'}{'value'} );
-			msg( "parm:max-temperature=".$parms->{'temperature'}{'value'}.", $ftemp:temperature=${line}" ) 
+			my $reboot_local = ( $line > $parms->{'temperature'}{'value'} );
+			msg( "parm:max-temperature=".$parms->{'temperature'}{'value'}.", $ftemp:temperature=${line}" )
 				if $reboot_local || (( $$opt_verbose & LOG_LOOP_DEBUG2 ) && $tick >= $parms->{'logtick'}{'value'} );
-			$$reboot_ref |= $reboot_local;
+			$reboot |= $reboot_local;
 	    } else {
 			msg( "unable to open $ftemp: $!" );
 	    }
 	}
+    $reason_code = 20 if $reboot;
+    return( $reboot );
 }
 
 # ---------------------------------------------------------------------
@@ -1455,7 +2151,7 @@ sub reboot(){
 	msg( "${pfx}rebooting the system" );
 	if( $parms->{'action'}{'value'} ){
 		# actually reboot the machine
-		send_serial( "REBOOT $reason_code" );
+		send_serial( channel_command( "REBOOT $reason_code" ));
 	}
 }
 
@@ -1475,69 +2171,191 @@ sub run_server(){
 	# open communication sockets
 	$board_socket = open_socket( $parms->{'listener'}{'value'}, $parms->{'boardport'}{'value'} );
 	$daemon_socket = open_socket( $parms->{'listener'}{'value'}, $parms->{'daemonport'}{'value'} );
-	$serial = open_serial() if $parms->{'serial'}{'value'};
+	$remote = $parms->{'serial'}{'value'} && length( $parms->{'boardhost'}{'value'} );
+	$serial = open_serial() if $parms->{'serial'}{'value'} && !$remote;
 	wait_for_watchdog_init() or die "unable to initialized NanoWatchdog board\n";
 
 	# first start the NanoWatchdog board
+	checks_init();
 	start_watchdog();
 	# check status
-	$board_status = send_serial( "STATUS" );
+	refresh_status();
+	sync_history();
 #	$board_status =
 #"  version: NanoWatchdog 2015.1
 #  date:         2015-06-15 00:06:23
 #  reason:       43 (specific reason)
 #  acknowledged: no";
-	write_status( $board_status );
 	send_boot_mail( $board_status );
 
-	my $tick = 0;
-	my $subtick = $parms->{'interval'}{'value'};	# do the first check right now
+	# the main loop sleeps until a TCP client connects or sends its
+	# command, the board sends a notification or a heartbeat answer, or
+	# the next timer is due
+	my $select = IO::Select->new( $board_socket, $daemon_socket );
+	$select->add( $serial->FILENO ) if defined( $serial );
+	my %clients = ();				# accepted client -> its command handler
+	timer_add( $parms->{'interval'}{'value'}, \&run_tick );	# do the first check right now
+	timer_add( $parms->{'perfinterval'}{'value'}, \&refresh_perf ) if $parms->{'perfinterval'}{'value'};
 
 	while( true ){
-		read_board_command( $board_socket );
-		read_daemon_command( $daemon_socket );
-		exit if $have_to_quit;
-		sleep( 1 );
-		$subtick += 1;
-		if( $subtick > $parms->{'interval'}{'value'} ){
-			$subtick = 0;
-			$tick += 1;
-			send_serial( "PING" ) if $parms->{'nwping'}{'value'};
-
-			# http://linux.die.net/man/8/watchdog
-			# The watchdog daemon does several tests to check the system
-			# status:
-			# - is the process table full?
-			# - is there enough free memory?
-			# - are some files accessible?
-			# - have some files changed within a given interval?
-			# - is the average work load too high?
-			# - has a file table overflow occurred?
-			# - is a process still running? The process is specified by a pid file.
-			# - do some IP addresses answer to ping?
-			# - do network interfaces receive traffic?
-			# - is the temperature too high? (Temperature data not always available).
-			# - execute a user defined command to do arbitrary tests.
-			# - execute one or more test/repair commands found in /etc/watchdog.d.
-			#   These commands are called with the argument test or repair.
-			# If any of these checks fail watchdog will cause a shutdown.
-			# Should any of these tests except the user defined binary last longer
-			# than one minute the machine will be rebooted, too.
-
-			if( check_memory( $tick ) ||
-				check_loadavg( $tick ) ||
-				check_temperature( $tick ) ||
-				check_pidfile( $tick ) ||
-				check_ping( $tick ) ||
-				check_interface( $tick ) ||
-				check_test_directory( $tick )){
-					reboot();
+		foreach my $handle ( $select->can_read( timer_timeout())){
+			if( !ref( $handle )){
+				read_notifications();
+			} elsif( defined( $clients{$handle} )){
+				$clients{$handle}->( $handle );
+				delete( $clients{$handle} );
+				$select->remove( $handle );
+				$handle->close();
+			} else {
+				my $client = accept_client( $handle );
+				if( defined( $client )){
+					$clients{$client} = ( $handle == $board_socket ) ? \&read_board_command : \&read_daemon_command;
+					$select->add( $client );
+				}
 			}
-
-			msg( "going to sleep for ".$parms->{'interval'}{'value'}." sec." )
-					if ( $$opt_verbose & LOG_LOOP_DEBUG2 ) && $tick >= $parms->{'logtick'}{'value'};
-			$tick = 0 if $tick >= $parms->{'logtick'}{'value'};
+			exit if $have_to_quit;
 		}
+		if( $status_dirty ){
+			$status_dirty = false;
+			refresh_status();
+		}
+		timer_run();
+	}
+}
+
+# ---------------------------------------------------------------------
+# the interval tick of the main loop: ping the board, and check the
+# system status
+sub run_tick(){
+	$loop_tick += 1;
+	# the PING and the status poll are sent as one batch
+	my @commands = ();
+	if( $parms->{'nwping'}{'value'} ){
+		my $command = board_ping_command();
+		push( @commands, $command ) if defined( $command );
+	}
+	# without notifications, have to poll the status
+	push( @commands, status_command()) if !board_events();
+	my @answers = send_batch( @commands );
+	refresh_status() if !board_events() && !update_status( $commands[-1], $answers[-1] );
+
+	# http://linux.die.net/man/8/watchdog
+	# The watchdog daemon does several tests to check the system
+	# status:
+	# - is the process table full?
+	# - is there enough free memory?
+	# - are some files accessible?
+	# - have some files changed within a given interval?
+	# - is the average work load too high?
+	# - has a file table overflow occurred?
+	# - is a process still running? The process is specified by a pid file.
+	# - do some IP addresses answer to ping?
+	# - do network interfaces receive traffic?
+	# - is the temperature too high? (Temperature data not always available).
+	# - execute a user defined command to do arbitrary tests.
+	# - execute one or more test/repair commands found in /etc/watchdog.d.
+	#   These commands are called with the argument test or repair.
+	# If any of these checks fail watchdog will cause a shutdown.
+	# Should any of these tests except the user defined binary last longer
+	# than one minute the machine will be rebooted, too.
+
+	# the hosts are pinged while the other checks are done, the board
+	# being pinged again between two checks if they last too long
+	ping_start();
+	my $reboot = false;
+	foreach my $check ( \&check_memory, \&check_loadavg, \&check_temperature, \&check_pidfile,
+			\&check_ping, \&check_interface, \&check_test_directory ){
+		board_keepalive();
+		$reboot = $check->( $loop_tick );
+		last if $reboot;
+	}
+	ping_end();
+	reboot() if $reboot;
+
+	msg( "going to sleep for ".$parms->{'interval'}{'value'}." sec." )
+			if ( $$opt_verbose & LOG_LOOP_DEBUG2 ) && $loop_tick >= $parms->{'logtick'}{'value'};
+	$loop_tick = 0 if $loop_tick >= $parms->{'logtick'}{'value'};
+}
+
+# ---------------------------------------------------------------------
+# ping the board, either by sending a heartbeat, or by returning the
+# PING command to be sent
+# the heartbeats only ping the channel 0 of a board we own, and the date
+# of a shared board is synchronized by the daemon which owns it
+sub board_ping_command(){
+	$ping_last = Time::HiRes::time();
+	if( $parms->{'pingmode'}{'value'} eq "heartbeat" && !$parms->{'channel'}{'value'} && !$remote ){
+		send_heartbeat();
+		return( undef );
+	}
+	return( channel_command(( $parms->{'timesync'}{'value'} eq "on" && !$remote ) ? "PING ".time() : "PING" ));
+}
+
+# ---------------------------------------------------------------------
+# whether the board notifies us of its state transitions
+# the notifications of a shared board are only received by the daemon
+# which owns it: the other ones poll the status
+sub board_events(){
+	return( $parms->{'events'}{'value'} eq "on" && !$remote );
+}
+
+# ---------------------------------------------------------------------
+# returns the command which applies to the channel of this host, i.e.
+# the command itself for the channel 0 of a board we own, so that the
+# boards without channels keep working, or else the command with the
+# channel number inserted before its argument
+# STOP without a channel stops the whole watchdog: a shared board is so
+# stopped with the daemon which owns it (and which powers it)
+sub channel_command( $ ){
+	my $command = shift;
+	my $channel = $parms->{'channel'}{'value'};
+	return( $command ) if !$channel && !$remote;
+	$command =~ s/^(PING|START|STOP|REBOOT|SET DELAY|SET TARGET)\b/$1 $channel/;
+	return( $command );
+}
+
+# ---------------------------------------------------------------------
+# ping the board again if the checks have lasted an interval since its
+# last ping, so that slow checks can't starve it
+sub board_keepalive(){
+	return if !$parms->{'nwping'}{'value'} ||
+			Time::HiRes::time()-$ping_last < $parms->{'interval'}{'value'};
+	my $command = board_ping_command();
+	send_serial( $command ) if defined( $command );
+}
+
+# ---------------------------------------------------------------------
+# register a periodic timer of the main loop, first due right now
+sub timer_add( $$ ){
+	my $period = shift;					# the period (sec.)
+	my $code = shift;					# the code ref to be run
+	push( @timers, { 'due' => Time::HiRes::time(), 'period' => $period, 'code' => $code });
+}
+
+# ---------------------------------------------------------------------
+# returns the delay until the soonest timer is due (sec., possibly
+# fractional), or undef to wait forever if there is no timer
+sub timer_timeout(){
+	my $timeout = undef;
+	my $now = Time::HiRes::time();
+	foreach my $timer ( @timers ){
+		my $left = $timer->{'due'}-$now;
+		$left = 0 if $left < 0;
+		$timeout = $left if !defined( $timeout ) || $left < $timeout;
+	}
+	return( $timeout );
+}
+
+# ---------------------------------------------------------------------
+# run the timers which are due, each one being then due one period
+# later, or one period from now if it has fallen behind
+sub timer_run(){
+	my $now = Time::HiRes::time();
+	foreach my $timer ( @timers ){
+		next if $timer->{'due'} > $now;
+		$timer->{'due'} += $timer->{'period'};
+		$timer->{'due'} = $now+$timer->{'period'} if $timer->{'due'} <= $now;
+		$timer->{'code'}->();
 	}
 }
 
@@ -1590,6 +2408,93 @@ ${local_status}
 	}
 }
 
+# ---------------------------------------------------------------------
+# read the reset events of the board reset log which are more recent
+# than the specified sequence number
+# returns the identifier of the reset log, then the events, oldest
+# first, or an empty list if the board has not answered
+sub read_history( $ ){
+	my $since = shift;
+	my $command = "EEPROM READ SINCE $since";
+	my $answer = send_serial( $command );
+	my @lines = split( /\x0D\x0A/, $answer );
+	if( !@lines || $lines[-1] ne "OK: $command" || $lines[0] !~ /^log=(\d+)$/ ){
+		msg( "warning: unable to read the reset events since seq=$since" );
+		return;
+	}
+	my $logid = $1;
+	# the index of an event changes with each new event: only keep the
+	# sequence number
+	return( $logid, reverse map( /^event=\d+ (seq=\d+ .*)$/ ? $1 : (), @lines ));
+}
+
+# ---------------------------------------------------------------------
+# read the reset events recorded since the last synced one, append them
+# to the history log, oldest first, and keep the sequence number of the
+# most recent one in the history file, along with the identifier of its
+# reset log, so that each boot only reads the new events
+# the sequence numbers restart when the EEPROM of the board is
+# initialized or when they wrap, the board then renewing the identifier
+# of its reset log: the whole new log is then read
+sub sync_history(){
+	my $cache = $parms->{'historyfile'}{'value'};
+	return if !$parms->{'serial'}{'value'} || !length( $cache );
+	my $since = 0;
+	my $synced;
+	if( open( my $fh, '<', $cache )){
+		my $line = <$fh>;
+		if( defined( $line ) && $line =~ /^(\d+)(?:\s+(\d+))?/ ){
+			$since = $1;
+			$synced = $2;
+		}
+		close $fh;
+	}
+	my ( $logid, @events ) = read_history( $since );
+	return if !defined( $logid );
+	# a history file without log identifier is taken as being about
+	# the current reset log
+	if( defined( $synced ) && $logid != $synced ){
+		msg( "the reset log of the board has changed since seq=$since, reading it again" );
+		$since = 0;
+		( $logid, @events ) = read_history( $since );
+		return if !defined( $logid );
+	}
+	if( @events ){
+		my $log = $parms->{'historylog'}{'value'};
+		if( length( $log )){
+			if( open( my $fh, '>>', $log )){
+				print $fh hostname." $_\n" foreach( @events );
+				close $fh;
+			} else {
+				msg( "warning: unable to open $log for append: $!" );
+				return;
+			}
+		}
+		$events[-1] =~ /^seq=(\d+)/;
+		$since = $1;
+	} elsif( defined( $synced ) && $logid == $synced ){
+		return;
+	}
+	if( open( my $fh, '>', $cache )){
+		print $fh "$since $logid\n";
+		close $fh;
+	} else {
+		msg( "warning: unable to open $cache for write: $!" );
+	}
+	msg( scalar( @events )." new reset event(s) synced up to seq=$since" ) if $$opt_verbose & LOG_INFO_START;
+}
+
+# ---------------------------------------------------------------------
+# switch the board to the configured protocol
+# the board stays in text mode if it doesn't accept the binary protocol
+sub set_protocol(){
+	if( $parms->{'serial'}{'value'} && $parms->{'protocol'}{'value'} eq "binary" ){
+		my $command = "SET PROTOCOL BINARY";
+		$binary = ( send_serial_text( $command ) eq "OK: $command" );
+		msg( "unable to switch the board to the binary protocol" ) if !$binary;
+	}
+}
+
 # ---------------------------------------------------------------------
 # start NanoWatchdog, waiting for the right answer to the sent command
 # configure it, setting the current date, and the reboot delay
@@ -1598,23 +2503,49 @@ ${local_status}
 sub start_watchdog(){
     if( $parms->{'serial'}{'value'} ){
 		msg( "starting NanoWatchdog board..." ) if $$opt_verbose & LOG_INFO_START;
-		my $command;
+		my @commands = ();
 
-		# set whether we are in test mode
-		$command = "SET TEST ";
-		$command .= $parms->{'action'}{'value'} ? "OFF" : "ON";
-		send_serial( $command );
+		# the test mode and the date of a shared board are set by the
+		# daemon which owns it
+		if( !$remote ){
+			# set whether we are in test mode
+			push( @commands, "SET TEST ".( $parms->{'action'}{'value'} ? "OFF" : "ON" ));
 
-		# set the current date
-		$command = "SET DATE ".time();
-		send_serial( $command );
+			# set the current date
+			push( @commands, "SET DATE ".time());
+		}
 
 		# set the reboot interval
-		$command = "SET DELAY ".$parms->{'delay'}{'value'};
-		send_serial( $command );
+		push( @commands, channel_command( "SET DELAY ".$parms->{'delay'}{'value'} ));
+
+		# bind our channel to the relay which resets this host
+		push( @commands, channel_command( "SET TARGET ".$parms->{'target'}{'value'} ))
+				if $parms->{'channel'}{'value'} || $parms->{'target'}{'value'} || $remote;
+
+		# have the board notify its state transitions
+		push( @commands, "SET EVENTS ON" ) if board_events();
 
 		# last start the watchdog
-		send_serial( "START" );
+		push( @commands, channel_command( "START" ));
+
+		# have the board restore this configuration by itself at
+		# power-up, so that the PC is protected before we are started
+		if( $parms->{'autostart'}{'value'} eq "on" && !$remote ){
+			push( @commands, "SET GRACE ".$parms->{'autostartgrace'}{'value'} );
+			push( @commands, "SET AUTOSTART ON" );
+			push( @commands, "SAVE CONFIG" );
+		}
+
+		# all these commands are sent as batches
+		my @answers = send_batch( @commands );
+		for( my $i=0 ; $i<@commands ; ++$i ){
+			next if $answers[$i] eq "OK: $commands[$i]";
+			msg( "the board doesn't send notifications" ) if $commands[$i] eq "SET EVENTS ON";
+			msg( "unable to save the board configuration" ) if $commands[$i] eq "SAVE CONFIG";
+		}
+
+		# and switch to the requested protocol
+		set_protocol() if !$binary && !$remote;
     }
 	return( true );
 }
@@ -1624,19 +2555,59 @@ sub start_watchdog(){
 # which means the NanoWatchdog is ready
 # returns: true/false whether the watchdog is rightly initialized
 sub wait_for_watchdog_init(){
-	my $answer = "";
-	my $command = "NOOP";
-    if( $parms->{'serial'}{'value'} ){
-		my $timeout = 0;
-		while( true ){
+	return( true ) if !$parms->{'serial'}{'value'};
+	if( $remote ){
+		# the daemon which owns a shared board may be starting too
+		for( my $timeout=0 ; $timeout<=$parms->{'opentimeout'}{'value'} ; ++$timeout ){
+			return( true ) if send_serial_text( "NOOP" ) eq "OK: NOOP";
 			sleep( 1 );
-			$timeout += 1;
-			$answer = send_serial( $command );
-			last if $answer eq "OK: $command";
-			last if $timeout > $parms->{'opentimeout'}{'value'};
 		}
-    }
-	return( !$parms->{'serial'}{'value'} || $answer eq "OK: $command" );
+		return( false );
+	}
+	my $wanted = $parms->{'baudrate'}{'value'};
+	my $timeout = 0;
+	while( true ){
+		sleep( 1 );
+		$timeout += 1;
+		foreach my $rate ( $wanted, grep { $_ != $wanted } BOARD_BAUD_RATES ){
+			next if !probe_serial( $rate );
+			return( true ) if $rate == $wanted;
+			# the board answers at another rate: have it switch to the
+			# configured one (it falls back to its default rate after
+			# some seconds if we do not manage to talk at the new rate)
+			msg( "board found at $rate bps, switching to $wanted bps" ) if $$opt_verbose & LOG_INFO_START;
+			my $command = "SET BAUD $wanted";
+			if( send_serial_text( $command ) eq "OK: $command" ){
+				return( true ) if probe_serial( $wanted );
+			}
+			msg( "unable to switch the board to $wanted bps" );
+			last;
+		}
+		last if $timeout > $parms->{'opentimeout'}{'value'};
+	}
+	return( false );
+}
+
+# ---------------------------------------------------------------------
+# set the host side of the serial bus to the given baud rate, and check
+# that the board answers
+# the board may have been left in binary mode by a previous run:
+# the TEXT frame makes it go back to text mode, the newline being then
+# an empty command; if already in text mode, the frame is just answered
+# as an invalid command
+# returns true if the board answers at this rate
+sub probe_serial( $ ){
+	my $rate = shift;
+	if( $serial->baudrate() != $rate ){
+		$serial->baudrate( $rate );
+		$serial->write_settings() or die "unable to set serial bus settings: $!\n";
+		msg( "trying ".$parms->{'device'}{'value'}." at $rate bps" ) if $$opt_verbose & LOG_BOARD_DEBUG1;
+	}
+	my $body = pack( "CC", BIN_OP_TEXT, 0 );
+	send_serial_text( pack( "C", BIN_SOF ).$body.pack( "C", bin_crc8( $body )));
+	$binary = false;
+	my $command = "NOOP";
+	return( send_serial_text( $command ) eq "OK: $command" );
 }
 
 # ---------------------------------------------------------------------
@@ -1656,13 +2627,106 @@ sub write_pid(){
 }
 
 # ---------------------------------------------------------------------
-# write the STATUS into a file
+# get the board status, and rewrite the status file if it has changed
+# once the sequence number of the status is known, the text protocol
+# only gets the changed fields (see STATUS SINCE), which replace the
+# previous ones; the binary protocol always gets the (compact) whole
+# status
+# the whole status is read again when the board has restarted
+sub refresh_status(){
+	my $command = status_command();
+	if( !update_status( $command, send_serial( $command ))){
+		$command = status_command();
+		update_status( $command, send_serial( $command ));
+	}
+}
+
+# ---------------------------------------------------------------------
+# the command which reads the board status, i.e. only the changed
+# fields when the status has already been read (see STATUS SINCE)
+sub status_command(){
+	return(( defined( $status_seq ) && !$binary ) ? "STATUS SINCE $status_seq" : "STATUS" );
+}
+
+# ---------------------------------------------------------------------
+# update the known status with the answer of the status command
+# returns false if the answer is about another startup of the board
+# than the known status, which is then forgotten, so that the whole
+# status be read again (see status_command()), true else
+sub update_status( $$ ){
+	my $command = shift;
+	my $answer = shift;
+	my @lines = split( /\x0D\x0A/, $answer );
+	return( true ) if !@lines || pop( @lines ) ne "OK: $command";
+	# nothing has changed
+	return( true ) if !@lines;
+	my $title = ( $lines[0] =~ /^\[/ ) ? shift( @lines ) : "";
+	# gather the lines by field, the sub-lines being more indented
+	my @blocks = ();
+	foreach my $line ( @lines ){
+		if( $line =~ /^ (\S[^:]*):/ || !@blocks ){
+			push( @blocks, [ $1 // "", $line ] );
+		} else {
+			$blocks[-1][1] .= "\x0D\x0A$line";
+		}
+	}
+	my $seq = undef;
+	my $boot = undef;
+	foreach( @blocks ){
+		$seq = $1 if $_->[0] eq "Sequence" && $_->[1] =~ /(\d+)\s*$/;
+		$boot = $1 if $_->[0] eq "Boot" && $_->[1] =~ /(\d+)\s*$/;
+	}
+	my $same_boot = ( $boot // "" ) eq ( $status_boot // "" );
+	# the changed fields of a restarted board are not about the known
+	# status
+	if( $command ne "STATUS" && !$same_boot ){
+		$status_seq = undef;
+		$status_boot = undef;
+		return( false );
+	}
+	return( true ) if defined( $seq ) && defined( $status_seq ) && $seq == $status_seq && $same_boot;
+	if( $command eq "STATUS" ){
+		@status_blocks = @blocks;
+		$status_title = $title;
+	} else {
+		foreach my $block ( @blocks ){
+			my @found = grep { $_->[0] eq $block->[0] } @status_blocks;
+			if( @found ){
+				$found[0][1] = $block->[1];
+			} else {
+				push( @status_blocks, $block );
+			}
+		}
+	}
+	$status_seq = $seq;
+	$status_boot = $boot;
+	$board_status = join( "\x0D\x0A", grep( length, $status_title ), map( $_->[1], @status_blocks ), "OK: STATUS" );
+	write_status( $board_status );
+	return( true );
+}
+
+# ---------------------------------------------------------------------
+# read the performance counters of the board, and append them to the
+# status file
+sub refresh_perf(){
+	my $command = "PERF";
+	my $answer = send_serial( $command );
+	my @lines = split( /\x0D\x0A/, $answer );
+	return if !@lines || $lines[-1] ne "OK: $command";
+	$board_perf = $answer;
+	write_status( $board_status );
+}
+
+# ---------------------------------------------------------------------
+# write the STATUS into a file, followed by the last performance
+# counters
 sub write_status( $ ){
 	my $local_status = shift;
 	#print "status='$local_status'\n";
 	if( length( $parms->{'nwstatus'}{'value'} ) && length( $local_status )){
 		if( open( my $fh, '>', $parms->{'nwstatus'}{'value'} )){
 			print $fh $local_status."\n";
+			print $fh $board_perf."\n" if defined( $board_perf );
 			close $fh;
 			msg( "status written in ".$parms->{'nwstatus'}{'value'} ) if $$opt_verbose & LOG_DEBUG_START;
 		} else {
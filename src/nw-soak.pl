@@ -0,0 +1,623 @@
+#!/usr/bin/perl -w
+# @(#) NanoWatchdog
+#
+# Copyright (C) 2015,2016,2017 Pierre Wieser (see AUTHORS)
+#
+# NanoWatchdog is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of
+# the License, or (at your option) any later version.
+#
+# NanoWatchdog is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with NanoWatchdog; if not, see
+# <http://www.gnu.org/licenses/>.
+#
+# Soak and latency test of a NanoWatchdog board connected to the serial
+# bus: drive it with a weighted mix of commands for as long as needed,
+# and report the round-trip latencies, the dropped and garbled answers,
+# and the near-misses of the watchdog channel 0, cross-checked with the
+# performance counters of the board (see the PERF command).
+#
+# The serial bus is directly opened: the NanoWatchdog daemon must not
+# be running meanwhile. The board is set in test mode during the run,
+# so that a missed deadline does not reset the PC.
+#
+# The exit code is non-zero if any answer has been dropped or garbled,
+# if a deadline has been missed, or if the board has lost commands.
+
+use strict;
+use Device::SerialPort;
+use File::Basename;
+use Getopt::Long;
+use IO::Select;
+use Time::HiRes;
+
+my $me = basename( $0 );
+my $my_version = "11.2017";
+use constant { true => 1, false => 0 };
+
+# auto-flush on stdout
+$| = 1;
+
+my $errs = 0;
+my $nbopts = $#ARGV;
+my $opt_help_def = "no";
+my $opt_help = false;
+my $opt_version_def = "no";
+my $opt_version = false;
+my $opt_verbose_def = "no";
+my $opt_verbose = false;
+
+my $opt_device_def = "/dev/ttyUSB0";
+my $opt_device = $opt_device_def;
+my $opt_baudrate_def = 19200;
+my $opt_baudrate = $opt_baudrate_def;
+my $opt_protocol_def = "text";
+my $opt_protocol = $opt_protocol_def;
+my $opt_mix_def = "PING=80,STATUS=15,ACKNOWLEDGE=4,EEPROM=1";
+my $opt_mix = $opt_mix_def;
+my $opt_rate_def = 0;
+my $opt_rate = $opt_rate_def;
+my $opt_duration_def = 3600;
+my $opt_duration = $opt_duration_def;
+my $opt_report_def = 300;
+my $opt_report = $opt_report_def;
+my $opt_delay_def = 10;
+my $opt_delay = $opt_delay_def;
+my $opt_near_miss_def = 90;
+my $opt_near_miss = $opt_near_miss_def;
+my $opt_timeout_def = 5;
+my $opt_timeout = $opt_timeout_def;
+my $opt_open_timeout_def = 10;
+my $opt_open_timeout = $opt_open_timeout_def;
+
+# the single-byte heartbeat and its answers
+use constant {
+	HEARTBEAT           => 0x05,
+	HEARTBEAT_ACK       => 0x06,
+	HEARTBEAT_NAK       => 0x15
+};
+
+# the binary protocol (see Arduino/lib/nwBinary.h)
+use constant {
+	BIN_SOF             => 0xA5,
+	BIN_OP_PING         => 0x01,
+	BIN_OP_STATUS       => 0x02,
+	BIN_OP_ACKNOWLEDGE  => 0x04,
+	BIN_OP_EEPROM_DUMP  => 0x05,
+	BIN_OP_NOOP         => 0x06,
+	BIN_OP_PERF         => 0x07,
+	BIN_OP_TEXT         => 0x0F,
+	BIN_OP_NOTIFY       => 0x11,
+	BIN_OP_REPLY        => 0x80,
+	BIN_OP_ERROR        => 0xFF
+};
+
+# the names of the asynchronous notifications, indexed by their code
+use constant NOTIFY_NAMES => ( undef, "START", "STOP", "DEADLINE", "RESET", "EEPROM", "LOST" );
+
+# the kinds of traffic which may be mixed, with the text command and
+# the binary request each of them sends; the heartbeat is the ENQ byte
+my %kinds = (
+	'PING'        => [ "PING",          BIN_OP_PING,        "" ],
+	'HEARTBEAT'   => [ undef,           undef,              "" ],
+	'STATUS'      => [ "STATUS",        BIN_OP_STATUS,      "" ],
+	'ACKNOWLEDGE' => [ "ACKNOWLEDGE 0", BIN_OP_ACKNOWLEDGE, pack( "C", 0 ) ],
+	'EEPROM'      => [ "EEPROM DUMP",   BIN_OP_EEPROM_DUMP, "" ],
+	'NOOP'        => [ "NOOP",          BIN_OP_NOOP,        "" ],
+	'PERF'        => [ "PERF",          BIN_OP_PERF,        "" ],
+	# not part of the mix
+	'PERF RESET'  => [ "PERF RESET",    BIN_OP_PERF,        pack( "C", 1 ) ]
+);
+
+my $serial;
+my $select;
+my $binary = false;
+my $stop = false;
+my @mix = ();
+my $mix_total = 0;
+
+# the latency histograms and the counts of outcomes, by kind
+my %stats = ();
+# the commands sent since the PERF RESET, which the board must have all
+# counted
+my $sent = 0;
+# the gaps between two acknowledged pings
+my $last_ping;
+my $max_gap = 0;
+my $near_misses = 0;
+my $missed = 0;
+# the notifications of the board
+my $board_near_misses = 0;
+my $board_resets = 0;
+my $board_lost = 0;
+
+# ---------------------------------------------------------------------
+sub msg_help(){
+	msg_version();
+	print " Usage: $0 [options]
+  --[no]help              print this message, and exit [${opt_help_def}]
+  --[no]version           print script version, and exit [${opt_version_def}]
+  --[no]verbose           run verbosely [$opt_verbose_def]
+  --device=path           serial bus device of the board [${opt_device_def}]
+  --baudrate=bps          communication speed of the serial bus [${opt_baudrate_def}]
+  --protocol=text|binary  protocol used to talk with the board [${opt_protocol_def}]
+  --mix=kind=weight,...   weighted mix of commands, the kinds being PING, HEARTBEAT,
+                          STATUS, ACKNOWLEDGE, EEPROM, NOOP and PERF [${opt_mix_def}]
+  --rate=count            commands per second, zero for back-to-back commands [${opt_rate_def}]
+  --duration=secs         duration of the run [${opt_duration_def}]
+  --report=secs           interval between two partial reports, zero for none [${opt_report_def}]
+  --delay=secs            delay of the watchdog channel 0 during the run [${opt_delay_def}]
+  --near-miss=pct         part of the delay beyond which a ping is a near-miss [${opt_near_miss_def}]
+  --timeout=secs          timeout of an answer, beyond which it is dropped [${opt_timeout_def}]
+  --open-timeout=secs     timeout when waiting for the board to answer [${opt_open_timeout_def}]
+";
+}
+
+# ---------------------------------------------------------------------
+sub msg_version(){
+	print " NanoWatchdog v${my_version}
+ Copyright (C) 2015,2016,2017 Pierre Wieser <pwieser\@trychlos.org>
+";
+}
+
+# ---------------------------------------------------------------------
+sub msg( $ ){
+	my $msg = shift;
+	print "[${me}] ${msg}\n";
+}
+
+# ---------------------------------------------------------------------
+# parse the --mix option
+# returns true if it is valid
+sub mix_parse( $ ){
+	my $spec = shift;
+	foreach my $item ( split( /,/, $spec )){
+		if( $item !~ /^(\w+)=(\d+)$/ || !exists( $kinds{$1} )){
+			msg( "invalid mix item: '$item'" );
+			return( false );
+		}
+		next if !$2;
+		push( @mix, [ $1, $2 ]);
+		$mix_total += $2;
+	}
+	msg( "empty mix" ) if !$mix_total;
+	return( $mix_total > 0 );
+}
+
+# ---------------------------------------------------------------------
+# returns the kind of the next command, randomly drawn from the mix
+sub mix_draw(){
+	my $draw = int( rand( $mix_total ));
+	foreach my $item ( @mix ){
+		return( $item->[0] ) if $draw < $item->[1];
+		$draw -= $item->[1];
+	}
+	return( $mix[-1][0] );
+}
+
+# ---------------------------------------------------------------------
+# returns true if the mix pings the watchdog
+sub mix_pings(){
+	return( scalar( grep { $_->[0] eq "PING" || $_->[0] eq "HEARTBEAT" } @mix ) > 0 );
+}
+
+# ---------------------------------------------------------------------
+# open the serial bus, without resetting the board
+sub open_serial(){
+	$serial = Device::SerialPort->new( $opt_device )
+			or die "unable to connect to ${opt_device} serial port: $!\n";
+	$serial->databits( 8 );
+	$serial->baudrate( $opt_baudrate );
+	$serial->parity( "none" );
+	$serial->stopbits( true );
+	$serial->dtr_active( false );
+	$serial->write_settings() or die "unable to set serial bus settings: $!\n";
+	# the answers are waited for on the readiness of the device, and are
+	# then read without blocking
+	$serial->read_char_time( 0 );
+	$serial->read_const_time( 0 );
+	$select = IO::Select->new( $serial->FILENO );
+	msg( "opening ${opt_device} (${opt_baudrate} bps)" ) if $opt_verbose;
+}
+
+# ---------------------------------------------------------------------
+# read what the board has sent, waiting for it up to the deadline
+# returns the read data, or an empty string on timeout
+sub read_serial( $ ){
+	my $deadline = shift;
+	my $left = $deadline-Time::HiRes::time();
+	return( "" ) if $left <= 0 || !$select->can_read( $left );
+	my ( $count, $saw ) = $serial->read( 255 );
+	return( $count > 0 ? $saw : "" );
+}
+
+# ---------------------------------------------------------------------
+# handle an asynchronous notification sent by the board
+sub notify( $$$ ){
+	my $name = shift;
+	my $channel = shift;
+	my $value = shift;
+	msg( "notification: $name $channel $value" ) if $opt_verbose;
+	if( $name eq "DEADLINE" && $value >= $opt_near_miss ){
+		$board_near_misses += 1;
+	} elsif( $name eq "RESET" ){
+		$board_resets += 1;
+	} elsif( $name eq "LOST" ){
+		$board_lost += $value;
+	}
+}
+
+# ---------------------------------------------------------------------
+# handle the notification lines found in the received text
+# returns the text without them
+sub notify_lines( $ ){
+	my $data = shift;
+	while( $data =~ s/(^|\x0D\x0A)! (\w+) (\S+) (\d+)\x0D\x0A/$1/ ){
+		notify( $2, $3, $4 );
+	}
+	return( $data );
+}
+
+# ---------------------------------------------------------------------
+sub bin_crc8( $ ){
+	my $data = shift;
+	my $crc = 0;
+	foreach my $byte ( unpack( "C*", $data )){
+		$crc ^= $byte;
+		for( my $i=0 ; $i<8 ; ++$i ){
+			$crc = ( $crc & 0x80 ) ? (( $crc << 1 ) ^ 0x07 ) & 0xFF : ( $crc << 1 ) & 0xFF;
+		}
+	}
+	return( $crc );
+}
+
+# ---------------------------------------------------------------------
+# extract the next complete frame from the buffer, the bytes before the
+# start-of-frame being dropped
+# returns [ opcode, payload ], or [ undef ] for a frame with a bad CRC,
+# or undef if the buffer does not hold a complete frame
+sub bin_frame( $ ){
+	my $buffer = shift;
+	$$buffer =~ s/^[^\xA5]+//;
+	return( undef ) if length( $$buffer ) < 4;
+	my $total = 4+ord( substr( $$buffer, 2, 1 ));
+	return( undef ) if length( $$buffer ) < $total;
+	my $frame = substr( $$buffer, 0, $total, "" );
+	return( [ undef ] ) if ord( substr( $frame, -1 )) != bin_crc8( substr( $frame, 1, $total-2 ));
+	return( [ ord( substr( $frame, 1, 1 )), substr( $frame, 3, $total-4 ) ]);
+}
+
+# ---------------------------------------------------------------------
+# handle a NOTIFY frame payload
+sub bin_notify( $ ){
+	my ( $code, $channel, $value ) = unpack( "CCV", shift );
+	my $name = ( NOTIFY_NAMES )[$code];
+	notify( $name, $channel == 0xFF ? "-" : $channel, $value ) if defined( $name );
+}
+
+# ---------------------------------------------------------------------
+# send a command to the board, and wait for its whole answer
+# $kind is a key of %kinds, or undef for a text command outside of the
+# mix, which is then sent whatever be the protocol
+# returns the outcome ('ok', 'refused', 'garbled' or 'dropped') and
+# the answer, i.e. the text lines or the payload of the reply frame
+sub transact( $$ ){
+	my $kind = shift;
+	my $command = shift;
+	my $heartbeat = defined( $kind ) && $kind eq "HEARTBEAT";
+	my $frame = defined( $kind ) && $binary && !$heartbeat;
+	my $deadline = Time::HiRes::time()+$opt_timeout;
+	my $buffer = "";
+	if( $heartbeat ){
+		$serial->write( pack( "C", HEARTBEAT ));
+	} elsif( $frame ){
+		my $body = pack( "CC", $kinds{$kind}[1], length( $kinds{$kind}[2] )).$kinds{$kind}[2];
+		$serial->write( pack( "C", BIN_SOF ).$body.pack( "C", bin_crc8( $body )));
+	} else {
+		$serial->write( "$command\n" );
+	}
+	$sent += 1;
+	while( true ){
+		my $data = read_serial( $deadline );
+		return( length( $buffer ) ? "garbled" : "dropped", $buffer ) if !length( $data );
+		$buffer .= $data;
+		if( $heartbeat ){
+			# the answer byte may follow notifications
+			if( $buffer =~ s/([\x06\x15])// ){
+				my $answer = $1;
+				if( $binary ){
+					while( defined( my $f = bin_frame( \$buffer ))){
+						bin_notify( $f->[1] ) if defined( $f->[0] ) && $f->[0] == BIN_OP_NOTIFY;
+					}
+				} else {
+					notify_lines( $buffer );
+				}
+				return( $answer eq chr( HEARTBEAT_ACK ) ? "ok" : "refused", "" );
+			}
+		} elsif( $frame ){
+			while( defined( my $f = bin_frame( \$buffer ))){
+				my ( $op, $payload ) = @$f;
+				return( "garbled", "" ) if !defined( $op ) || $op == BIN_OP_ERROR;
+				if( $op == BIN_OP_NOTIFY ){
+					bin_notify( $payload );
+				} elsif( $op == ( $kinds{$kind}[1] | BIN_OP_REPLY )){
+					return(( length( $payload ) && !ord( $payload ) ? "ok" : "refused" ), $payload );
+				}
+			}
+		} else {
+			$buffer = notify_lines( $buffer );
+			if( $buffer =~ /(^|\x0D\x0A)\.\.?\x0D\x0A$/ ){
+				$buffer =~ s/(^|\x0D\x0A)\.\.?\x0D\x0A$//;
+				my @lines = split( /\x0D\x0A/, $buffer );
+				return( "ok", $buffer ) if @lines && $lines[-1] eq "OK: $command";
+				return( "refused", $buffer ) if @lines && $lines[-1] eq "Unknown or invalid command: $command";
+				return( "garbled", $buffer );
+			}
+		}
+	}
+}
+
+# ---------------------------------------------------------------------
+# consume what the board may still send after a dropped or garbled
+# answer, until it has been silent for 200 ms
+sub drain(){
+	my $buffer = "";
+	while( true ){
+		my $data = read_serial( Time::HiRes::time()+0.2 );
+		last if !length( $data );
+		$buffer .= $data;
+	}
+	notify_lines( $buffer ) if !$binary;
+}
+
+# ---------------------------------------------------------------------
+# send a setup command, which must be successful
+sub setup_command( $ ){
+	my $command = shift;
+	my ( $outcome, $answer ) = transact( undef, $command );
+	die "the board has not accepted '$command': $outcome\n" if $outcome ne "ok";
+	return( $answer );
+}
+
+# ---------------------------------------------------------------------
+# record the round-trip latency of a command, and its outcome, the
+# latencies being counted by 100 us buckets in order to keep the memory
+# footprint constant whatever be the duration of the run
+sub stats_add( $$$ ){
+	my $kind = shift;
+	my $outcome = shift;
+	my $elapsed = shift;
+	$stats{$kind} = { count => 0, hist => {}, max => 0, sum => 0, ok => 0, refused => 0, garbled => 0, dropped => 0 }
+			if !exists( $stats{$kind} );
+	my $s = $stats{$kind};
+	$s->{$outcome} += 1;
+	return if $outcome eq "dropped";
+	$s->{count} += 1;
+	$s->{hist}{ int( 10000*$elapsed ) } += 1;
+	$s->{max} = $elapsed if $elapsed > $s->{max};
+	$s->{sum} += $elapsed;
+}
+
+# ---------------------------------------------------------------------
+# returns the percentile of the latencies of the kind, in ms
+sub stats_percentile( $$ ){
+	my $s = shift;
+	my $pct = shift;
+	my $wanted = $pct*$s->{count}/100;
+	my $count = 0;
+	foreach my $bucket ( sort { $a <=> $b } keys( %{$s->{hist}} )){
+		$count += $s->{hist}{$bucket};
+		return(( $bucket+1 )/10 ) if $count >= $wanted;
+	}
+	return( 0 );
+}
+
+# ---------------------------------------------------------------------
+# record an acknowledged ping, checking the gap since the previous one
+sub ping_done( $ ){
+	my $now = shift;
+	if( defined( $last_ping )){
+		my $gap = $now-$last_ping;
+		$max_gap = $gap if $gap > $max_gap;
+		if( $gap > $opt_delay ){
+			$missed += 1;
+		} elsif( $gap > $opt_delay*$opt_near_miss/100 ){
+			$near_misses += 1;
+		}
+	}
+	$last_ping = $now;
+}
+
+# ---------------------------------------------------------------------
+# read the performance counters of the board
+# returns a ref to a hash of the counters, or undef
+sub perf_read(){
+	my $start = Time::HiRes::time();
+	my ( $outcome, $answer ) = transact( "PERF", "PERF" );
+	stats_add( "PERF", $outcome, Time::HiRes::time()-$start );
+	if( $outcome ne "ok" ){
+		drain();
+		return( undef );
+	}
+	my %perf = ();
+	if( $binary ){
+		my ( $st, $loops, $max, $avg, $rxfull, $dropped, $bad, $free, $eeprom, $margin, $channel, $total ) = unpack( "CVVvvvvvVVCV", $answer );
+		%perf = ( loopmax => $max, rxfull => $rxfull, dropped => $dropped, bad => $bad, eeprom => $eeprom, total => $total );
+		$perf{margin} = $margin if $margin != 0xFFFFFFFF;
+	} else {
+		$perf{loopmax} = $1 if $answer =~ /Loop: count=\d+, average=\d+ us, max=(\d+) us/;
+		( $perf{rxfull}, $perf{dropped}, $perf{bad} ) = ( $1, $2, $3 ) if $answer =~ /Serial: rx full=(\d+), dropped=(\d+), bad frames=(\d+)/;
+		$perf{eeprom} = $1 if $answer =~ /EEPROM: written=(\d+) bytes/;
+		$perf{margin} = $1 if $answer =~ /Margin: min=(\d+) ms/;
+		$perf{total} = $1 if $answer =~ /Commands: total=(\d+)/;
+	}
+	return( \%perf );
+}
+
+# ---------------------------------------------------------------------
+# display the report, cross-checking the counts of the host with the
+# performance counters of the board
+# the final report sets the exit code
+sub report( $$ ){
+	my $elapsed = shift;
+	my $final = shift;
+	my $perf = perf_read();
+	my ( $count, $dropped, $garbled, $refused ) = ( 0, 0, 0, 0 );
+	msg(( $final ? "final" : "partial" )." report after ".int( $elapsed )." sec. on ${opt_device} (${opt_protocol} protocol, ${opt_baudrate} bps)" );
+	printf "  %-12s %9s %8s %8s %8s %8s %8s %8s %8s\n", "kind", "count", "avg ms", "p50 ms", "p99 ms", "max ms", "refused", "garbled", "dropped";
+	foreach my $kind ( sort keys( %stats )){
+		my $s = $stats{$kind};
+		printf "  %-12s %9d %8.1f %8.1f %8.1f %8.1f %8d %8d %8d\n", $kind, $s->{count}+$s->{dropped},
+				$s->{count} ? 1000*$s->{sum}/$s->{count} : 0, stats_percentile( $s, 50 ), stats_percentile( $s, 99 ),
+				1000*$s->{max}, $s->{refused}, $s->{garbled}, $s->{dropped};
+		$count += $s->{count}+$s->{dropped};
+		$dropped += $s->{dropped};
+		$garbled += $s->{garbled};
+		# there may be no event to acknowledge
+		$refused += $s->{refused} if $kind ne "ACKNOWLEDGE";
+	}
+	printf "  %d commands, %.1f per sec.\n", $count, $elapsed > 0 ? $count/$elapsed : 0;
+	if( mix_pings()){
+		printf "  pings: max gap=%.1f ms for a %d sec. delay, near-misses=%d (beyond %d%%), missed=%d\n",
+				1000*$max_gap, $opt_delay, $near_misses, $opt_near_miss, $missed;
+	}
+	printf "  board notifications: near-misses=%d, resets=%d, lost=%d\n", $board_near_misses, $board_resets, $board_lost;
+	my $lost = 0;
+	my $rxerrs = 0;
+	if( defined( $perf )){
+		# the board counts the PERF command itself, and everything which
+		# has been sent since the PERF RESET
+		$lost = $sent-$perf->{total} if defined( $perf->{total} );
+		$rxerrs = $perf->{rxfull}+$perf->{dropped}+$perf->{bad} if defined( $perf->{rxfull} );
+		printf "  board: commands=%s (host sent %d, %d lost), rx full=%s, dropped=%s, bad frames=%s\n",
+				$perf->{total} // "?", $sent, $lost, $perf->{rxfull} // "?", $perf->{dropped} // "?", $perf->{bad} // "?";
+		printf "  board: loop max=%s us, EEPROM written=%s bytes, margin min=%s\n",
+				$perf->{loopmax} // "?", $perf->{eeprom} // "?", defined( $perf->{margin} ) ? "$perf->{margin} ms" : "none";
+	} else {
+		print "  board: unable to read the performance counters\n";
+	}
+	if( $final ){
+		$errs = 1 if $dropped || $garbled || $refused || $missed || $board_resets || $board_lost || $lost || $rxerrs || !defined( $perf );
+		print "  ".( $errs ? "FAILED" : "PASSED" )."\n";
+	}
+}
+
+# =====================================================================
+# MAIN
+# =====================================================================
+
+if( !GetOptions(
+	"help!"			=> \$opt_help,
+	"version!"		=> \$opt_version,
+	"verbose!"		=> \$opt_verbose,
+	"device=s"		=> \$opt_device,
+	"baudrate=i"	=> \$opt_baudrate,
+	"protocol=s"	=> \$opt_protocol,
+	"mix=s"			=> \$opt_mix,
+	"rate=f"		=> \$opt_rate,
+	"duration=i"	=> \$opt_duration,
+	"report=i"		=> \$opt_report,
+	"delay=i"		=> \$opt_delay,
+	"near-miss=i"	=> \$opt_near_miss,
+	"timeout=i"		=> \$opt_timeout,
+	"open-timeout=i" => \$opt_open_timeout )){
+
+		print "try '${0} --help' to get full usage syntax\n";
+		exit( 1 );
+}
+
+if( $opt_help ){
+	msg_help();
+	exit( 0 );
+}
+
+if( $opt_version ){
+	msg_version();
+	exit( 0 );
+}
+
+if( $opt_protocol ne "text" && $opt_protocol ne "binary" ){
+	msg( "invalid protocol: '${opt_protocol}'" );
+	exit( 1 );
+}
+exit( 1 ) if !mix_parse( $opt_mix );
+
+$SIG{INT} = sub { $stop = true; };
+$SIG{TERM} = sub { $stop = true; };
+
+open_serial();
+
+# opening the serial bus may have reset the board
+my $outcome = "dropped";
+for( my $timeout=0 ; $outcome ne "ok" && $timeout<=$opt_open_timeout ; ++$timeout ){
+	sleep( 1 );
+	( $outcome ) = transact( undef, "NOOP" );
+	drain() if $outcome ne "ok";
+}
+die "the board does not answer on ${opt_device}\n" if $outcome ne "ok";
+
+# put the board in test mode, restoring its mode at the end
+my $test = ( setup_command( "STATUS" ) =~ /Test mode:\s+ON/ ) ? "ON" : "OFF";
+setup_command( "SET TEST ON" );
+setup_command( "SET EVENTS ON" );
+setup_command( "SET DELAY ${opt_delay}" );
+if( mix_pings()){
+	setup_command( "START" );
+	ping_done( Time::HiRes::time());
+}
+if( $opt_protocol eq "binary" ){
+	setup_command( "SET PROTOCOL BINARY" );
+	$binary = true;
+}
+# the board does not count the commands which have been sent up to and
+# including the PERF RESET
+my ( $reset ) = transact( "PERF RESET", "PERF RESET" );
+$sent = 0;
+msg( "unable to reset the performance counters" ) if $reset ne "ok";
+
+my $start = Time::HiRes::time();
+my $next_report = $opt_report;
+my $count = 0;
+msg( "running for ${opt_duration} sec. with the '${opt_mix}' mix" );
+while( !$stop ){
+	my $elapsed = Time::HiRes::time()-$start;
+	last if $elapsed >= $opt_duration;
+	if( $opt_report && $elapsed >= $next_report ){
+		report( $elapsed, false );
+		$next_report += $opt_report;
+	}
+	if( $opt_rate > 0 ){
+		my $wait = $start+$count/$opt_rate-Time::HiRes::time();
+		Time::HiRes::sleep( $wait ) if $wait > 0;
+	}
+	my $kind = mix_draw();
+	my $sent_at = Time::HiRes::time();
+	my ( $outcome ) = transact( $kind, $kinds{$kind}[0] );
+	my $now = Time::HiRes::time();
+	stats_add( $kind, $outcome, $now-$sent_at );
+	ping_done( $now ) if $outcome eq "ok" && ( $kind eq "PING" || $kind eq "HEARTBEAT" );
+	msg( "$kind: $outcome" ) if $outcome ne "ok" && $opt_verbose;
+	drain() if $outcome eq "garbled" || $outcome eq "dropped";
+	$count += 1;
+}
+report( Time::HiRes::time()-$start, true );
+
+# restore the board
+if( $binary ){
+	my $body = pack( "CC", BIN_OP_TEXT, 0 );
+	$serial->write( pack( "C", BIN_SOF ).$body.pack( "C", bin_crc8( $body )));
+	$binary = false;
+	drain();
+}
+transact( undef, "STOP" );
+transact( undef, "SET EVENTS OFF" );
+transact( undef, "SET TEST ${test}" );
+$serial->close();
+
+exit( $errs );